@@ -28,6 +28,75 @@
 //  2) ASSERT_XXX  - use assertion methodology including a free text message
 //  3) TEST_XXX0   - use testing methodology without a free text message
 //  4) TEST_XXX    - use assertion methodology including a free text message
+// Each macro is a statement (do { ... } while(false)), not an expression: write
+// "if(c) TEST_PASS(a); else TEST_FAIL(b);" instead of "c ? TEST_PASS(a) : TEST_FAIL(b)",
+// and no macro can be an operand of the comma operator.
+//
+// Quiet mode - UnitTest::Statistics::SetQuiet(true) (or compiling with
+// UNITTEST_QUIET defined) makes a passing assertion only increment the PASS
+// counter: no formatting, no stream and no console colors. Failures are
+// always formatted and printed. The totals are available from
+// UnitTest::Statistics::Passed() / Failed().
+//
+// Async mode - UnitTest::Reporter::SetAsync(true) (or compiling with
+// UNITTEST_ASYNC defined) makes the TEST_XXX methods push the PASS/FAIL
+// records into a bounded lock-free ring which is drained by one reporter
+// thread, so worker threads never block on the console and the output of
+// concurrent threads is never interleaved. The free text messages are kept
+// as pointers, so they must stay valid until the record is printed (string
+// literals always are). The ring is flushed before an assertion throws and
+// at exit; Reporter::Flush() can be called at any time.
+//
+// Report writers - every record goes to the console and to the writers added
+// with Reporter::AddWriter. The Runner adds a streaming JUnit XML file
+// (--junit FILE), a JSON Lines file (--jsonl FILE) and a compact binary log
+// (--binary-log FILE) which "--summarize-log FILE" reads back.
+//
+// Selection - "--filter GLOBS" runs the cases whose "suite.name" matches one of
+// the comma separated globs (a leading '-' excludes: "Parser.*,-*.Slow"), and
+// "--tags EXPRESSION" the cases whose TEST_CASE_TAGS match it ("fast & !io").
+// "--list" prints the selected cases in name order instead of running them.
+//
+// Incremental runs - "--cache FILE" keeps the outcome, duration and fingerprint
+// of every case (its source file and the files it declared with TEST_INPUT).
+// "--failed-first" starts with the cases which failed last time, "--only-failed"
+// runs only those and "--changed-only" skips the cases which passed and whose
+// files are unchanged. "--longest-first" schedules the cases by their last
+// duration (a new case gets the mean of its suite) and prints the predicted and
+// the actual makespan. Without --cache these options use .unittest-cache.
+//
+// Timeouts - "--timeout SECONDS" limits every case, TEST_TIMEOUT(seconds) in a
+// case sets its own limit. A case which runs past it is reported as [TIMEOUT]
+// with the site of its last assertion: a forked worker (--fork) is ended and
+// its case fails, while an in process run prints the cases which are running
+// and exits with status 124. One watchdog thread waits for the earliest
+// deadline; the assertions do not check the time.
+//
+// Console - the header builds with MSVC on Windows and with GCC/Clang on the
+// POSIX systems. PASS/FAIL records are colored with ANSI escapes only when the
+// stream is a terminal and NO_COLOR is not set (decided once), and each record
+// is one write() of its whole text; a pipe or a file gets a batch per write().
+//
+// Assertion sites - each ASSERT_XXX / TEST_XXX / CHECK / REQUIRE macro keeps
+// its file, line, argument text and mode in one static constant UnitTest::Site;
+// a passing assertion is a compare and a counter increment, and the failure
+// paths are out of line and cold. The site id (a hash of file:line) is written to the
+// JSON Lines and binary logs, so the results of one assertion can be grouped
+// across runs and workers.
+//
+// Site profile - compiling with UNITTEST_PROFILE_SITES defined (before the
+// include) makes each macro count its hits, PASS/FAIL results and the time spent
+// in the call, in per thread tables merged at exit. "--profile-sites N" (or
+// UnitTest::SiteProfile::SetEnabled(true) and SiteProfile::Report) lists the
+// top N sites by hits and by time.
+//
+// Failure text - two values which fit in 4 KB together (--failure-bytes N, or
+// UNITTEST_FAILURE_BYTES) are printed whole. Larger ones, such as two long strings,
+// are printed as excerpts around their first difference, with its offset,
+// line and column, and a diff of the lines around it, so the failure report of two
+// 50 MB strings is a few KB. Values are printed by UnitTest::ValueFormatter<T>
+// into a fixed buffer (numbers with std::to_chars, pointers and UnitTest::Bytes
+// in hex); specialise it for a type of your own, or give the type an operator<<.
 //
 //	Example of usage:
 //	//-------------------------------------------------------------------------
@@ -75,12 +144,60 @@
 //	TEST_LESS_OR_EQUAL(3, 3,	"[LessOrEqual]");		// 3 <= 3
 //
 //	//-------------------------------------------------------------------------
+//	// Near (floating point)
+//	//-------------------------------------------------------------------------
+//	TEST_NEAR(0.1 + 0.2, 0.3, 1e-12,	"[Absolute]");	// |0.3 - (0.1 + 0.2)| <= 1e-12
+//	TEST_NEAR(x, y, UnitTest::Tolerance::Relative(1e-6), "[Relative]");	// 1e-6 of the larger magnitude
+//	TEST_NEAR(x, y, UnitTest::Tolerance::Ulps(4),		"[Ulps]");		// at most 4 representable values apart
+//	TEST_COLLECTION_NEAR(reference, output, UnitTest::Tolerance::Ulps(2), "[Output]");	// every element of two float/double ranges
+//
+//	//-------------------------------------------------------------------------
+//	// Expressions (the operands are printed only on failure)
+//	//-------------------------------------------------------------------------
+//	CHECK(v.size() == 3);		// test - prints "With: '2 == 3'" if v has 2 items
+//	REQUIRE(p != nullptr);		// assert - throws std::runtime_error on failure
+//	CHECK((a > 1 && a < 3));	// && and || need their own parentheses
+//
+//	//-------------------------------------------------------------------------
+//	// Performance (median of repeated runs, outliers rejected)
+//	//-------------------------------------------------------------------------
+//	TEST_DURATION_LESS([&]{ sort(v); }, 2.5,		"[DurationLess]");	// median of sort(v) < 2.5 ms
+//	TEST_NOT_SLOWER([&]{ sort(v); }, "sort", 0.10,	"[NotSlower]");		// at most 10% slower than the "sort" baseline
+//
+//	//-------------------------------------------------------------------------
+//	// Allocations (#define UNITTEST_TRACK_ALLOCATIONS in one source file)
+//	//-------------------------------------------------------------------------
+//	TEST_NO_ALLOCATIONS("[NoAllocations]")		{ hot_path(); }		// hot_path() does not call operator new
+//	TEST_MAX_ALLOCATIONS(2, "[MaxAllocations]")	{ v.push_back(1); }	// at most 2 calls to operator new
+//
+//	//-------------------------------------------------------------------------
+//	// Resources
+//	//-------------------------------------------------------------------------
+//	TEST_MAX_CPU_TIME(5, "[MaxCpuTime]")		{ parse(input); }	// parse() uses at most 5 ms of CPU time
+//	TEST_MAX_RSS_DELTA(64, "[MaxRssDelta]")		{ load(input); }	// load() grows the RSS by at most 64 MB
+//
+//	//-------------------------------------------------------------------------
 //	// StringAssert
 //	//-------------------------------------------------------------------------
 //	ASSERT_CONTAINS("World", "Hello World",		"[Contains]");		// "World" is a substring of "Hello World"
 //	ASSERT_STARTS_WITH("Hello", "Hello World",	"[StartsWith]");	// "Hello" is the start of "Hello World"
+//	TEST_ENDS_WITH("World", line,				"[EndsWith]");		// line (a char*, std::string or std::string_view) ends with "World"
 //	ASSERT_EQUAL_IGNORING_CASE("test", "TEST",	"[AreEqualIgnoringCase]");	// "test" is the same as "TEST"
-//	ASSERT_IS_MATCH("Hello", "Hello", "Hello is Hello");
+//	TEST_IS_MATCH("^H[a-z]+o$", "Hello",		"[IsMatch]");		// the regular expression matches (compiled once per pattern)
+//
+//	//-------------------------------------------------------------------------
+//	// CollectionAssert (contiguous ranges - one assertion per range)
+//	//-------------------------------------------------------------------------
+//	TEST_COLLECTION_EQUAL(expected, actual,		"[AreEqual]");		// same elements, same order - prints the first mismatch
+//	TEST_COLLECTION_EQUIVALENT(expected, actual,"[AreEquivalent]");	// same elements, any order
+//	TEST_COLLECTION_CONTAINS(v, 42,				"[Contains]");		// 42 is an element of v
+//	TEST_COLLECTION_ORDERED(UnitTest::Collections::Range(p, n), "[IsOrdered]");	// p[0] <= p[1] <= ... <= p[n-1]
+//
+//	//-------------------------------------------------------------------------
+//	// FileAssert and DirectoryAssert (paths - the files are mapped, pipes are streamed)
+//	//-------------------------------------------------------------------------
+//	TEST_FILE_EQUAL("golden/out.bin", outputPath, "[AreEqual]");	// same bytes - prints the offset and a hexdump
+//	TEST_DIRECTORY_EQUAL("golden/tree", outputDir, "[AreEqual]");	// same paths and bytes - lists every difference
 //
 //	//-------------------------------------------------------------------------
 //	// Utility Methods
@@ -88,140 +205,446 @@
 //	TEST_PASS("This line will always pass");
 //	TEST_FAIL("This line will always fail");
 //
+//	//-------------------------------------------------------------------------
+//	// Test cases and Runner
+//	//-------------------------------------------------------------------------
+//	TEST_CASE(Math, Addition)
+//	{
+//		ASSERT_EQUAL(2, 1+1, "[Addition]");	// a throwing assertion aborts only this case
+//		TEST_LESS(1, 2, "[Less]");
+//	}
+//
+//	TEST_CASE_TAGS(Math, Division, "fast,core")	// --tags "fast & !io" selects it
+//	{
+//		TEST_EQUAL(2, 4/2, "[Division]");
+//	}
+//
+//	TEST_CASE(Parser, Golden)
+//	{
+//		TEST_INPUT("golden/input.txt");		// --changed-only runs the case again when the file changes
+//		TEST_FILE_EQUAL("golden/output.txt", Parse("golden/input.txt"), "[Golden]");
+//	}
+//
+//	TEST_CASE(Network, Reconnect)
+//	{
+//		TEST_TIMEOUT(30);					// fails as [TIMEOUT] after 30 s instead of the --timeout limit
+//		TEST_IS_TRUE(Reconnect(), "[Reconnect]");
+//	}
+//
+//	BENCHMARK(VectorPushBack)
+//	{	// min/median/mean/stddev/p99 per iteration are reported as a [PASS] record
+//		std::vector<int> v;
+//		while(state.KeepRunning())
+//		{
+//			v.push_back(1);
+//			UnitTest::Benchmark::DoNotOptimize(v.data());
+//		}
+//	}
+//
+//	int main(int argc, char* argv[])
+//	{	// runs every registered case on a work-stealing thread pool (--threads N)
+//		return UnitTest::Runner::Main(argc, argv);
+//	}
+//
 ///////////////////////////////////////////////////////////////////////////////
 #pragma once
 
+#include <cstddef>		// ptrdiff_t
+#include <cstdint>		// intptr_t
 #include <sstream>		// std::ostringstream
 #include <iostream>		// cout, cerr
+#include <atomic>		// std::atomic (Statistics counters, Reporter ring)
+#include <string>		// std::string
+#include <memory>		// std::unique_ptr
+#include <thread>		// std::thread (Reporter thread)
+#include <chrono>		// std::chrono::microseconds
+#include <vector>		// std::vector (Registry)
+#include <deque>		// std::deque (Runner work queues)
+#include <bitset>		// std::bitset::count (CaseIndex)
+#include <mutex>		// std::mutex (Runner work queues)
+#include <condition_variable>	// std::condition_variable (Watchdog)
+#include <functional>	// std::ref
+#include <stdexcept>	// std::runtime_error
+#include <exception>	// std::uncaught_exceptions (SiteProfile)
+#include <cstdlib>		// atoi, atof, malloc, free
+#include <cstring>		// strcmp, strncpy
+#include <cstdio>		// snprintf, fread (FileAssert streams)
+#include <cerrno>		// errno (FileAssert)
+#include <new>			// placement new
+#include <algorithm>	// std::sort
+#include <cmath>		// sqrt, fabs
+#include <map>			// std::map (Performance baselines)
+#include <fstream>		// std::ifstream, std::ofstream (Performance baselines)
+#include <type_traits>	// std::true_type (Expression operands)
+#include <utility>		// std::declval
+#include <iterator>		// std::data, std::size (CollectionAssert)
+#include <limits>		// std::numeric_limits
+#include <charconv>		// std::to_chars (ValueFormatter)
+#include <string_view>	// std::string_view (StringAssert)
+#include <regex>			// std::regex (StringAssert IsMatch)
+#if defined(_WIN32)
 #include <tchar.h>		// _T("...")
 #include <windows.h>
+#include <io.h>			// _isatty, _write (class Console)
+#include <sys/stat.h>	// _stat64 (ResultCache)
+#else
+#include <unistd.h>		// isatty, write (class Console)
+#include <sys/stat.h>	// stat (ResultCache), fstat (FileAssert)
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>		// _ReadWriteBarrier, _BitScanForward
+#endif
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>	// SSE2 and AVX2 (Collections kernels)
+#define UNITTEST_SSE2
+#endif
+#if defined(_WIN32)
+#include <psapi.h>		// K32GetProcessMemoryInfo
+#endif
+#if defined(__linux__)
+#include <unistd.h>		// fork, _exit
+#include <signal.h>		// WTERMSIG
+#include <time.h>		// clock_gettime
+#include <sched.h>		// sched_setaffinity (Performance CPU pinning)
+#include <fcntl.h>		// open (/proc/self/statm)
+#include <sys/resource.h>	// getrusage
+#include <sys/syscall.h>	// syscall(__NR_perf_event_open)
+#include <linux/perf_event.h>	// perf_event_attr
+#include <sys/mman.h>	// mmap (forked Runner result region, FileAssert)
+#include <dirent.h>		// opendir (DirectoryAssert)
+#include <sys/wait.h>	// waitpid
+#endif
 
+#if defined(_MSC_VER)
 #pragma warning(disable:4267) // converting X to Y, possible loss of data
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// The TCHAR names of <tchar.h> and <windows.h> on the other platforms, where the
+// strings are always narrow
+///////////////////////////////////////////////////////////////////////////////
+#if !defined(_WIN32)
+typedef char			TCHAR;
+typedef char*			LPTSTR;
+typedef const char*		LPCTSTR;
+typedef const char*		LPCSTR;
+#ifndef _T
+#define _T(x)			x
+#endif
+#define _tcscmp			strcmp
+#define _tcsclen		strlen
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// Assertion sites - every assertion macro below declares one constant UnitTest::Site
+// (file, line, the text of the arguments, ASSERT/TEST) and passes it as one argument;
+// the message stays an argument because it does not have to be a literal.
+// alignas(8) keeps each constant at 24 bytes (GCC rounds it up to 32 otherwise).
+// Declaring the constant makes every macro a statement. An immediately invoked
+// lambda would keep the old expression form, but it adds one closure type per
+// assertion to the compile time and cannot capture structured bindings in C++17.
+///////////////////////////////////////////////////////////////////////////////
+#define UNITTEST_SITE(text,throws)				alignas(8) static constexpr UnitTest::Site unittest_site = UnitTest::Site::At(__FILE__,__LINE__,_T(text),throws)
+#if defined(UNITTEST_PROFILE_SITES)		// counts and times every assertion site - see class SiteProfile
+#define UNITTEST_PROFILE						UnitTest::SiteProfile::Scope unittest_profile(unittest_site)
+#else
+#define UNITTEST_PROFILE						(void)0
+#endif
+#define UNITTEST_AT(text,throws,call)			do { UNITTEST_SITE(text,throws); UNITTEST_PROFILE; call; } while(false)
+
+#if defined(_MSC_VER)	// one out of line copy of the shared assertion paths instead of one per call site
+#define UNITTEST_NOINLINE			__declspec(noinline)
+#define UNITTEST_COLD				__declspec(noinline)
+#else					// the failure paths are also moved to .text.unlikely, away from the passing code
+#define UNITTEST_NOINLINE			__attribute__((noinline))
+#define UNITTEST_COLD				__attribute__((cold, noinline))
+#endif
+
+#if defined(UNITTEST_SSE2) && defined(__GNUC__)	// AVX2 kernels compiled for the target and selected at run time
+#define UNITTEST_AVX2
+#define UNITTEST_TARGET_AVX2		__attribute__((target("avx2")))
+#elif defined(UNITTEST_SSE2) && defined(__AVX2__)	// MSVC /arch:AVX2
+#define UNITTEST_AVX2
+#define UNITTEST_TARGET_AVX2
+#endif
 
 ///////////////////////////////////////////////////////////////////////////////
 // Equality Asserts
 ///////////////////////////////////////////////////////////////////////////////
-#define ASSERT_EQUAL0(a,b)						UnitTest::Assert::AreEqual(a,b,		true,__FILE__,__LINE__)
-#define ASSERT_EQUAL(a,b,msg)					UnitTest::Assert::AreEqual(a,b,msg,	true,__FILE__,__LINE__)
-#define TEST_EQUAL0(a,b)						UnitTest::Assert::AreEqual(a,b,		false,__FILE__,__LINE__)
-#define TEST_EQUAL(a,b,msg)						UnitTest::Assert::AreEqual(a,b,msg,	false,__FILE__,__LINE__)
+#define ASSERT_EQUAL0(a,b)						UNITTEST_AT(#a ", " #b, true, UnitTest::Assert::AreEqual(a,b,unittest_site))
+#define ASSERT_EQUAL(a,b,msg)					UNITTEST_AT(#a ", " #b, true, UnitTest::Assert::AreEqual(a,b,msg,unittest_site))
+#define TEST_EQUAL0(a,b)						UNITTEST_AT(#a ", " #b, false, UnitTest::Assert::AreEqual(a,b,unittest_site))
+#define TEST_EQUAL(a,b,msg)						UNITTEST_AT(#a ", " #b, false, UnitTest::Assert::AreEqual(a,b,msg,unittest_site))
 
-#define ASSERT_NOT_EQUAL0(a,b)					UnitTest::Assert::AreNotEqual(a,b,		true,__FILE__,__LINE__)
-#define ASSERT_NOT_EQUAL(a,b,msg)				UnitTest::Assert::AreNotEqual(a,b,msg,	true,__FILE__,__LINE__)
-#define TEST_NOT_EQUAL0(a,b)					UnitTest::Assert::AreNotEqual(a,b,		false,__FILE__,__LINE__)
-#define TEST_NOT_EQUAL(a,b,msg)					UnitTest::Assert::AreNotEqual(a,b,msg,	false,__FILE__,__LINE__)
+#define ASSERT_NOT_EQUAL0(a,b)					UNITTEST_AT(#a ", " #b, true, UnitTest::Assert::AreNotEqual(a,b,unittest_site))
+#define ASSERT_NOT_EQUAL(a,b,msg)				UNITTEST_AT(#a ", " #b, true, UnitTest::Assert::AreNotEqual(a,b,msg,unittest_site))
+#define TEST_NOT_EQUAL0(a,b)					UNITTEST_AT(#a ", " #b, false, UnitTest::Assert::AreNotEqual(a,b,unittest_site))
+#define TEST_NOT_EQUAL(a,b,msg)					UNITTEST_AT(#a ", " #b, false, UnitTest::Assert::AreNotEqual(a,b,msg,unittest_site))
 
 ///////////////////////////////////////////////////////////////////////////////
 // Condition Tests
 ///////////////////////////////////////////////////////////////////////////////
-#define ASSERT_IS_TRUE0(condition)				UnitTest::Assert::IsTrue(condition,		true,__FILE__,__LINE__)
-#define ASSERT_IS_TRUE(condition,msg)			UnitTest::Assert::IsTrue(condition,msg,	true,__FILE__,__LINE__)
-#define TEST_IS_TRUE0(condition)				UnitTest::Assert::IsTrue(condition,		false,__FILE__,__LINE__)
-#define TEST_IS_TRUE(condition,msg)				UnitTest::Assert::IsTrue(condition,msg,	false,__FILE__,__LINE__)
-
-#define ASSERT_TRUE0(condition)					UnitTest::Assert::True(condition,		true,__FILE__,__LINE__)
-#define ASSERT_TRUE(condition,msg)				UnitTest::Assert::True(condition,msg,	true,__FILE__,__LINE__)
-#define TEST_TRUE0(condition)					UnitTest::Assert::True(condition,		false,__FILE__,__LINE__)
-#define TEST_TRUE(condition,msg)				UnitTest::Assert::True(condition,msg,	false,__FILE__,__LINE__)
-
-#define ASSERT_IS_FALSE0(condition)				UnitTest::Assert::IsFalse(condition,		true,__FILE__,__LINE__)
-#define ASSERT_IS_FALSE(condition,msg)			UnitTest::Assert::IsFalse(condition,msg,	true,__FILE__,__LINE__)
-#define TEST_IS_FALSE0(condition)				UnitTest::Assert::IsFalse(condition,		false,__FILE__,__LINE__)
-#define TEST_IS_FALSE(condition,msg)			UnitTest::Assert::IsFalse(condition,msg,	false,__FILE__,__LINE__)
-
-#define ASSERT_FALSE0(condition)				UnitTest::Assert::False(condition,		true,__FILE__,__LINE__)
-#define ASSERT_FALSE(condition,msg)				UnitTest::Assert::False(condition,msg,	true,__FILE__,__LINE__)
-#define TEST_FALSE0(condition)					UnitTest::Assert::False(condition,		false,__FILE__,__LINE__)
-#define TEST_FALSE(condition,msg)				UnitTest::Assert::False(condition,msg,	false,__FILE__,__LINE__)
-
-#define ASSERT_IS_NULL0(p)						UnitTest::Assert::IsNull(p,		true,__FILE__,__LINE__)
-#define ASSERT_IS_NULL(p,msg)					UnitTest::Assert::IsNull(p,msg,	true,__FILE__,__LINE__)
-#define TEST_IS_NULL0(p)						UnitTest::Assert::IsNull(p,		false,__FILE__,__LINE__)
-#define TEST_IS_NULL(p,msg)						UnitTest::Assert::IsNull(p,msg,	false,__FILE__,__LINE__)
-
-#define ASSERT_NULL0(p)							UnitTest::Assert::Null(p,		true,__FILE__,__LINE__)
-#define ASSERT_NULL(p,msg)						UnitTest::Assert::Null(p,msg,	true,__FILE__,__LINE__)
-#define TEST_NULL0(p)							UnitTest::Assert::Null(p,		false,__FILE__,__LINE__)
-#define TEST_NULL(p,msg)						UnitTest::Assert::Null(p,msg,	false,__FILE__,__LINE__)
-
-#define ASSERT_IS_NOT_NULL0(p)					UnitTest::Assert::IsNotNull(p,		true,__FILE__,__LINE__)
-#define ASSERT_IS_NOT_NULL(p,msg)				UnitTest::Assert::IsNotNull(p,msg,	true,__FILE__,__LINE__)
-#define TEST_IS_NOT_NULL0(p)					UnitTest::Assert::IsNotNull(p,		false,__FILE__,__LINE__)
-#define TEST_IS_NOT_NULL(p,msg)					UnitTest::Assert::IsNotNull(p,msg,	false,__FILE__,__LINE__)
-
-#define ASSERT_NOT_NULL0(p)						UnitTest::Assert::NotNull(p,		true,__FILE__,__LINE__)
-#define ASSERT_NOT_NULL(p,msg)					UnitTest::Assert::NotNull(p,msg,	true,__FILE__,__LINE__)
-#define TEST_NOT_NULL0(p)						UnitTest::Assert::NotNull(p,		false,__FILE__,__LINE__)
-#define TEST_NOT_NULL(p,msg)					UnitTest::Assert::NotNull(p,msg,	false,__FILE__,__LINE__)
-
-#define ASSERT_IS_EMPTY_STRING0(str)			UnitTest::Assert::IsEmpty(str,		true,__FILE__,__LINE__)
-#define ASSERT_IS_EMPTY_STRING(str,msg)			UnitTest::Assert::IsEmpty(str,msg,	true,__FILE__,__LINE__)
-#define TEST_IS_EMPTY_STRING0(str)				UnitTest::Assert::IsEmpty(str,		false,__FILE__,__LINE__)
-#define TEST_IS_EMPTY_STRING(str,msg)			UnitTest::Assert::IsEmpty(str,msg,	false,__FILE__,__LINE__)
-
-#define ASSERT_IS_NOT_EMPTY_STRING0(str)		UnitTest::Assert::IsNotEmpty(str,		true,__FILE__,__LINE__)
-#define ASSERT_IS_NOT_EMPTY_STRING(str,msg)		UnitTest::Assert::IsNotEmpty(str,msg,	true,__FILE__,__LINE__)
-#define TEST_IS_NOT_EMPTY_STRING0(str)			UnitTest::Assert::IsNotEmpty(str,		false,__FILE__,__LINE__)
-#define TEST_IS_NOT_EMPTY_STRING(str,msg)		UnitTest::Assert::IsNotEmpty(str,msg,	false,__FILE__,__LINE__)
+#define ASSERT_IS_TRUE0(condition)				UNITTEST_AT(#condition, true, UnitTest::Assert::IsTrue(condition,NULL,unittest_site))
+#define ASSERT_IS_TRUE(condition,msg)			UNITTEST_AT(#condition, true, UnitTest::Assert::IsTrue(condition,msg,unittest_site))
+#define TEST_IS_TRUE0(condition)				UNITTEST_AT(#condition, false, UnitTest::Assert::IsTrue(condition,NULL,unittest_site))
+#define TEST_IS_TRUE(condition,msg)				UNITTEST_AT(#condition, false, UnitTest::Assert::IsTrue(condition,msg,unittest_site))
+
+#define ASSERT_TRUE0(condition)					UNITTEST_AT(#condition, true, UnitTest::Assert::True(condition,NULL,unittest_site))
+#define ASSERT_TRUE(condition,msg)				UNITTEST_AT(#condition, true, UnitTest::Assert::True(condition,msg,unittest_site))
+#define TEST_TRUE0(condition)					UNITTEST_AT(#condition, false, UnitTest::Assert::True(condition,NULL,unittest_site))
+#define TEST_TRUE(condition,msg)				UNITTEST_AT(#condition, false, UnitTest::Assert::True(condition,msg,unittest_site))
+
+#define ASSERT_IS_FALSE0(condition)				UNITTEST_AT(#condition, true, UnitTest::Assert::IsFalse(condition,NULL,unittest_site))
+#define ASSERT_IS_FALSE(condition,msg)			UNITTEST_AT(#condition, true, UnitTest::Assert::IsFalse(condition,msg,unittest_site))
+#define TEST_IS_FALSE0(condition)				UNITTEST_AT(#condition, false, UnitTest::Assert::IsFalse(condition,NULL,unittest_site))
+#define TEST_IS_FALSE(condition,msg)			UNITTEST_AT(#condition, false, UnitTest::Assert::IsFalse(condition,msg,unittest_site))
+
+#define ASSERT_FALSE0(condition)				UNITTEST_AT(#condition, true, UnitTest::Assert::False(condition,NULL,unittest_site))
+#define ASSERT_FALSE(condition,msg)				UNITTEST_AT(#condition, true, UnitTest::Assert::False(condition,msg,unittest_site))
+#define TEST_FALSE0(condition)					UNITTEST_AT(#condition, false, UnitTest::Assert::False(condition,NULL,unittest_site))
+#define TEST_FALSE(condition,msg)				UNITTEST_AT(#condition, false, UnitTest::Assert::False(condition,msg,unittest_site))
+
+#define ASSERT_IS_NULL0(p)						UNITTEST_AT(#p, true, UnitTest::Assert::IsNull(p,NULL,unittest_site))
+#define ASSERT_IS_NULL(p,msg)					UNITTEST_AT(#p, true, UnitTest::Assert::IsNull(p,msg,unittest_site))
+#define TEST_IS_NULL0(p)						UNITTEST_AT(#p, false, UnitTest::Assert::IsNull(p,NULL,unittest_site))
+#define TEST_IS_NULL(p,msg)						UNITTEST_AT(#p, false, UnitTest::Assert::IsNull(p,msg,unittest_site))
+
+#define ASSERT_NULL0(p)							UNITTEST_AT(#p, true, UnitTest::Assert::Null(p,NULL,unittest_site))
+#define ASSERT_NULL(p,msg)						UNITTEST_AT(#p, true, UnitTest::Assert::Null(p,msg,unittest_site))
+#define TEST_NULL0(p)							UNITTEST_AT(#p, false, UnitTest::Assert::Null(p,NULL,unittest_site))
+#define TEST_NULL(p,msg)						UNITTEST_AT(#p, false, UnitTest::Assert::Null(p,msg,unittest_site))
+
+#define ASSERT_IS_NOT_NULL0(p)					UNITTEST_AT(#p, true, UnitTest::Assert::IsNotNull(p,NULL,unittest_site))
+#define ASSERT_IS_NOT_NULL(p,msg)				UNITTEST_AT(#p, true, UnitTest::Assert::IsNotNull(p,msg,unittest_site))
+#define TEST_IS_NOT_NULL0(p)					UNITTEST_AT(#p, false, UnitTest::Assert::IsNotNull(p,NULL,unittest_site))
+#define TEST_IS_NOT_NULL(p,msg)					UNITTEST_AT(#p, false, UnitTest::Assert::IsNotNull(p,msg,unittest_site))
+
+#define ASSERT_NOT_NULL0(p)						UNITTEST_AT(#p, true, UnitTest::Assert::NotNull(p,NULL,unittest_site))
+#define ASSERT_NOT_NULL(p,msg)					UNITTEST_AT(#p, true, UnitTest::Assert::NotNull(p,msg,unittest_site))
+#define TEST_NOT_NULL0(p)						UNITTEST_AT(#p, false, UnitTest::Assert::NotNull(p,NULL,unittest_site))
+#define TEST_NOT_NULL(p,msg)					UNITTEST_AT(#p, false, UnitTest::Assert::NotNull(p,msg,unittest_site))
+
+#define ASSERT_IS_EMPTY_STRING0(str)			UNITTEST_AT(#str, true, UnitTest::Assert::IsEmpty(str,NULL,unittest_site))
+#define ASSERT_IS_EMPTY_STRING(str,msg)			UNITTEST_AT(#str, true, UnitTest::Assert::IsEmpty(str,msg,unittest_site))
+#define TEST_IS_EMPTY_STRING0(str)				UNITTEST_AT(#str, false, UnitTest::Assert::IsEmpty(str,NULL,unittest_site))
+#define TEST_IS_EMPTY_STRING(str,msg)			UNITTEST_AT(#str, false, UnitTest::Assert::IsEmpty(str,msg,unittest_site))
+
+#define ASSERT_IS_NOT_EMPTY_STRING0(str)		UNITTEST_AT(#str, true, UnitTest::Assert::IsNotEmpty(str,NULL,unittest_site))
+#define ASSERT_IS_NOT_EMPTY_STRING(str,msg)		UNITTEST_AT(#str, true, UnitTest::Assert::IsNotEmpty(str,msg,unittest_site))
+#define TEST_IS_NOT_EMPTY_STRING0(str)			UNITTEST_AT(#str, false, UnitTest::Assert::IsNotEmpty(str,NULL,unittest_site))
+#define TEST_IS_NOT_EMPTY_STRING(str,msg)		UNITTEST_AT(#str, false, UnitTest::Assert::IsNotEmpty(str,msg,unittest_site))
 
 ///////////////////////////////////////////////////////////////////////////////
 // Comparisons
 ///////////////////////////////////////////////////////////////////////////////
-#define ASSERT_GREATER0(a,b)					UnitTest::Assert::Greater(a,b,		true,__FILE__,__LINE__)
-#define ASSERT_GREATER(a,b,msg)					UnitTest::Assert::Greater(a,b,msg,	true,__FILE__,__LINE__)
-#define TEST_GREATER0(a,b)						UnitTest::Assert::Greater(a,b,		false,__FILE__,__LINE__)
-#define TEST_GREATER(a,b,msg)					UnitTest::Assert::Greater(a,b,msg,	false,__FILE__,__LINE__)
+#define ASSERT_GREATER0(a,b)					UNITTEST_AT(#a ", " #b, true, UnitTest::Assert::Greater(a,b,NULL,unittest_site))
+#define ASSERT_GREATER(a,b,msg)					UNITTEST_AT(#a ", " #b, true, UnitTest::Assert::Greater(a,b,msg,unittest_site))
+#define TEST_GREATER0(a,b)						UNITTEST_AT(#a ", " #b, false, UnitTest::Assert::Greater(a,b,NULL,unittest_site))
+#define TEST_GREATER(a,b,msg)					UNITTEST_AT(#a ", " #b, false, UnitTest::Assert::Greater(a,b,msg,unittest_site))
+
+#define ASSERT_GREATER_OR_EQUAL0(a,b)			UNITTEST_AT(#a ", " #b, true, UnitTest::Assert::GreaterOrEqual(a,b,NULL,unittest_site))
+#define ASSERT_GREATER_OR_EQUAL(a,b,msg)		UNITTEST_AT(#a ", " #b, true, UnitTest::Assert::GreaterOrEqual(a,b,msg,unittest_site))
+#define TEST_GREATER_OR_EQUAL0(a,b)				UNITTEST_AT(#a ", " #b, false, UnitTest::Assert::GreaterOrEqual(a,b,NULL,unittest_site))
+#define TEST_GREATER_OR_EQUAL(a,b,msg)			UNITTEST_AT(#a ", " #b, false, UnitTest::Assert::GreaterOrEqual(a,b,msg,unittest_site))
+
+#define ASSERT_LESS0(a,b)						UNITTEST_AT(#a ", " #b, true, UnitTest::Assert::Less(a,b,NULL,unittest_site))
+#define ASSERT_LESS(a,b,msg)					UNITTEST_AT(#a ", " #b, true, UnitTest::Assert::Less(a,b,msg,unittest_site))
+#define TEST_LESS0(a,b)							UNITTEST_AT(#a ", " #b, false, UnitTest::Assert::Less(a,b,NULL,unittest_site))
+#define TEST_LESS(a,b,msg)						UNITTEST_AT(#a ", " #b, false, UnitTest::Assert::Less(a,b,msg,unittest_site))
+
+#define ASSERT_LESS_OR_EQUAL0(a,b)				UNITTEST_AT(#a ", " #b, true, UnitTest::Assert::LessOrEqual(a,b,NULL,unittest_site))
+#define ASSERT_LESS_OR_EQUAL(a,b,msg)			UNITTEST_AT(#a ", " #b, true, UnitTest::Assert::LessOrEqual(a,b,msg,unittest_site))
+#define TEST_LESS_OR_EQUAL0(a,b)				UNITTEST_AT(#a ", " #b, false, UnitTest::Assert::LessOrEqual(a,b,NULL,unittest_site))
+#define TEST_LESS_OR_EQUAL(a,b,msg)				UNITTEST_AT(#a ", " #b, false, UnitTest::Assert::LessOrEqual(a,b,msg,unittest_site))
+
+///////////////////////////////////////////////////////////////////////////////
+// Near - floating point values within a tolerance: a number (absolute),
+// UnitTest::Tolerance::Relative(r) or UnitTest::Tolerance::Ulps(n)
+///////////////////////////////////////////////////////////////////////////////
+#define ASSERT_NEAR0(a,b,tolerance)				UNITTEST_AT(#a ", " #b ", " #tolerance, true, UnitTest::Assert::AreNear(a,b,tolerance,NULL,unittest_site))
+#define ASSERT_NEAR(a,b,tolerance,msg)			UNITTEST_AT(#a ", " #b ", " #tolerance, true, UnitTest::Assert::AreNear(a,b,tolerance,msg,unittest_site))
+#define TEST_NEAR0(a,b,tolerance)				UNITTEST_AT(#a ", " #b ", " #tolerance, false, UnitTest::Assert::AreNear(a,b,tolerance,NULL,unittest_site))
+#define TEST_NEAR(a,b,tolerance,msg)			UNITTEST_AT(#a ", " #b ", " #tolerance, false, UnitTest::Assert::AreNear(a,b,tolerance,msg,unittest_site))
+
+///////////////////////////////////////////////////////////////////////////////
+// Performance - the median duration of a callable (function, functor or lambda)
+///////////////////////////////////////////////////////////////////////////////
+#define ASSERT_DURATION_LESS0(function,ms)			UNITTEST_AT(#function ", " #ms, true, UnitTest::Assert::DurationLess(function,ms,NULL,unittest_site))
+#define ASSERT_DURATION_LESS(function,ms,msg)		UNITTEST_AT(#function ", " #ms, true, UnitTest::Assert::DurationLess(function,ms,msg,unittest_site))
+#define TEST_DURATION_LESS0(function,ms)			UNITTEST_AT(#function ", " #ms, false, UnitTest::Assert::DurationLess(function,ms,NULL,unittest_site))
+#define TEST_DURATION_LESS(function,ms,msg)			UNITTEST_AT(#function ", " #ms, false, UnitTest::Assert::DurationLess(function,ms,msg,unittest_site))
+
+#define ASSERT_NOT_SLOWER0(function,key,tolerance)		UNITTEST_AT(#function ", " #key ", " #tolerance, true, UnitTest::Assert::NotSlower(function,key,tolerance,NULL,unittest_site))
+#define ASSERT_NOT_SLOWER(function,key,tolerance,msg)	UNITTEST_AT(#function ", " #key ", " #tolerance, true, UnitTest::Assert::NotSlower(function,key,tolerance,msg,unittest_site))
+#define TEST_NOT_SLOWER0(function,key,tolerance)		UNITTEST_AT(#function ", " #key ", " #tolerance, false, UnitTest::Assert::NotSlower(function,key,tolerance,NULL,unittest_site))
+#define TEST_NOT_SLOWER(function,key,tolerance,msg)		UNITTEST_AT(#function ", " #key ", " #tolerance, false, UnitTest::Assert::NotSlower(function,key,tolerance,msg,unittest_site))
+
+///////////////////////////////////////////////////////////////////////////////
+// Allocations - scoped: ASSERT_NO_ALLOCATIONS("hot path") { ... }
+// Needs UNITTEST_TRACK_ALLOCATIONS defined before including this header in one source file.
+///////////////////////////////////////////////////////////////////////////////
+#define ASSERT_NO_ALLOCATIONS0						ASSERT_MAX_ALLOCATIONS0(0)
+#define ASSERT_NO_ALLOCATIONS(msg)					ASSERT_MAX_ALLOCATIONS(0,msg)
+#define TEST_NO_ALLOCATIONS0						TEST_MAX_ALLOCATIONS0(0)
+#define TEST_NO_ALLOCATIONS(msg)					TEST_MAX_ALLOCATIONS(0,msg)
+
+#define ASSERT_MAX_ALLOCATIONS0(n)					for(UnitTest::AllocationScope unittest_scope(n,NULL,	true,__FILE__,__LINE__); unittest_scope.Once(); )
+#define ASSERT_MAX_ALLOCATIONS(n,msg)				for(UnitTest::AllocationScope unittest_scope(n,msg,		true,__FILE__,__LINE__); unittest_scope.Once(); )
+#define TEST_MAX_ALLOCATIONS0(n)					for(UnitTest::AllocationScope unittest_scope(n,NULL,	false,__FILE__,__LINE__); unittest_scope.Once(); )
+#define TEST_MAX_ALLOCATIONS(n,msg)					for(UnitTest::AllocationScope unittest_scope(n,msg,		false,__FILE__,__LINE__); unittest_scope.Once(); )
+
+///////////////////////////////////////////////////////////////////////////////
+// Resources - scoped: ASSERT_MAX_CPU_TIME(5, "parse") { ... } / ASSERT_MAX_RSS_DELTA(64, "load") { ... }
+// CPU time (ms) is of the calling thread; RSS (MB) is of the whole process.
+///////////////////////////////////////////////////////////////////////////////
+#define ASSERT_MAX_CPU_TIME0(ms)					for(UnitTest::ResourceScope unittest_scope(UnitTest::ResourceScope::CpuTime,ms,NULL,	true,__FILE__,__LINE__); unittest_scope.Once(); )
+#define ASSERT_MAX_CPU_TIME(ms,msg)					for(UnitTest::ResourceScope unittest_scope(UnitTest::ResourceScope::CpuTime,ms,msg,		true,__FILE__,__LINE__); unittest_scope.Once(); )
+#define TEST_MAX_CPU_TIME0(ms)						for(UnitTest::ResourceScope unittest_scope(UnitTest::ResourceScope::CpuTime,ms,NULL,	false,__FILE__,__LINE__); unittest_scope.Once(); )
+#define TEST_MAX_CPU_TIME(ms,msg)					for(UnitTest::ResourceScope unittest_scope(UnitTest::ResourceScope::CpuTime,ms,msg,		false,__FILE__,__LINE__); unittest_scope.Once(); )
 
-#define ASSERT_GREATER_OR_EQUAL0(a,b)			UnitTest::Assert::GreaterOrEqual(a,b,		true,__FILE__,__LINE__)
-#define ASSERT_GREATER_OR_EQUAL(a,b,msg)		UnitTest::Assert::GreaterOrEqual(a,b,msg,	true,__FILE__,__LINE__)
-#define TEST_GREATER_OR_EQUAL0(a,b)				UnitTest::Assert::GreaterOrEqual(a,b,		false,__FILE__,__LINE__)
-#define TEST_GREATER_OR_EQUAL(a,b,msg)			UnitTest::Assert::GreaterOrEqual(a,b,msg,	false,__FILE__,__LINE__)
+#define ASSERT_MAX_RSS_DELTA0(mb)					for(UnitTest::ResourceScope unittest_scope(UnitTest::ResourceScope::RssDelta,mb,NULL,	true,__FILE__,__LINE__); unittest_scope.Once(); )
+#define ASSERT_MAX_RSS_DELTA(mb,msg)				for(UnitTest::ResourceScope unittest_scope(UnitTest::ResourceScope::RssDelta,mb,msg,	true,__FILE__,__LINE__); unittest_scope.Once(); )
+#define TEST_MAX_RSS_DELTA0(mb)						for(UnitTest::ResourceScope unittest_scope(UnitTest::ResourceScope::RssDelta,mb,NULL,	false,__FILE__,__LINE__); unittest_scope.Once(); )
+#define TEST_MAX_RSS_DELTA(mb,msg)					for(UnitTest::ResourceScope unittest_scope(UnitTest::ResourceScope::RssDelta,mb,msg,	false,__FILE__,__LINE__); unittest_scope.Once(); )
 
-#define ASSERT_LESS0(a,b)						UnitTest::Assert::Less(a,b,		true,__FILE__,__LINE__)
-#define ASSERT_LESS(a,b,msg)					UnitTest::Assert::Less(a,b,msg,	true,__FILE__,__LINE__)
-#define TEST_LESS0(a,b)							UnitTest::Assert::Less(a,b,		false,__FILE__,__LINE__)
-#define TEST_LESS(a,b,msg)						UnitTest::Assert::Less(a,b,msg,	false,__FILE__,__LINE__)
+///////////////////////////////////////////////////////////////////////////////
+// Expressions - CHECK(a == b) / REQUIRE(a == b) decompose a comparison (==, !=, <, <=,
+// >, >=) or a single value and print both operands on failure. Wrap && and || in
+// parentheses: CHECK((a && b)). Compare pointers with nullptr, CHECK(p == nullptr):
+// NULL and 0 reach the comparison as plain integers and do not compile.
+///////////////////////////////////////////////////////////////////////////////
+#define REQUIRE(expression)						UNITTEST_DECOMPOSE(#expression, true, UnitTest::Assert::That(UnitTest::Decomposer() <= expression,unittest_site))
+#define CHECK(expression)						UNITTEST_DECOMPOSE(#expression, false, UnitTest::Assert::That(UnitTest::Decomposer() <= expression,unittest_site))
 
-#define ASSERT_LESS_OR_EQUAL0(a,b)				UnitTest::Assert::LessOrEqual(a,b,		true,__FILE__,__LINE__)
-#define ASSERT_LESS_OR_EQUAL(a,b,msg)			UnitTest::Assert::LessOrEqual(a,b,msg,	true,__FILE__,__LINE__)
-#define TEST_LESS_OR_EQUAL0(a,b)				UnitTest::Assert::LessOrEqual(a,b,		false,__FILE__,__LINE__)
-#define TEST_LESS_OR_EQUAL(a,b,msg)				UnitTest::Assert::LessOrEqual(a,b,msg,	false,__FILE__,__LINE__)
+#if defined(__GNUC__)	// a == b inside the decomposition is not a precedence mistake
+#define UNITTEST_DECOMPOSE(text,throws,call)	do { UNITTEST_SITE(text,throws); UNITTEST_PROFILE; _Pragma("GCC diagnostic push") _Pragma("GCC diagnostic ignored \"-Wparentheses\"") call; _Pragma("GCC diagnostic pop") } while(false)
+#else
+#define UNITTEST_DECOMPOSE(text,throws,call)	UNITTEST_AT(text,throws,call)
+#endif
 
 ///////////////////////////////////////////////////////////////////////////////
 // StringAssert
 ///////////////////////////////////////////////////////////////////////////////
-#define ASSERT_CONTAINS0(substr,str)			UnitTest::Assert::Contains(substr,str,		true,__FILE__,__LINE__)
-#define ASSERT_CONTAINS(substr,str,msg)			UnitTest::Assert::Contains(substr,str,msg,	true,__FILE__,__LINE__)
-//[DISABLE] - TEST_CONTAINS - is disabled because it use more than one assertion in the test
+#define ASSERT_CONTAINS0(substr,str)			UNITTEST_AT(#substr ", " #str, true, UnitTest::Assert::Contains(substr,str,NULL,unittest_site))
+#define ASSERT_CONTAINS(substr,str,msg)			UNITTEST_AT(#substr ", " #str, true, UnitTest::Assert::Contains(substr,str,msg,unittest_site))
+#define TEST_CONTAINS0(substr,str)				UNITTEST_AT(#substr ", " #str, false, UnitTest::Assert::Contains(substr,str,NULL,unittest_site))
+#define TEST_CONTAINS(substr,str,msg)			UNITTEST_AT(#substr ", " #str, false, UnitTest::Assert::Contains(substr,str,msg,unittest_site))
+
+#define ASSERT_STARTS_WITH0(substr,str)			UNITTEST_AT(#substr ", " #str, true, UnitTest::Assert::StartsWith(substr,str,NULL,unittest_site))
+#define ASSERT_STARTS_WITH(substr,str,msg)		UNITTEST_AT(#substr ", " #str, true, UnitTest::Assert::StartsWith(substr,str,msg,unittest_site))
+#define TEST_STARTS_WITH0(substr,str)			UNITTEST_AT(#substr ", " #str, false, UnitTest::Assert::StartsWith(substr,str,NULL,unittest_site))
+#define TEST_STARTS_WITH(substr,str,msg)		UNITTEST_AT(#substr ", " #str, false, UnitTest::Assert::StartsWith(substr,str,msg,unittest_site))
+
+#define ASSERT_ENDS_WITH0(substr,str)			UNITTEST_AT(#substr ", " #str, true, UnitTest::Assert::EndsWith(substr,str,NULL,unittest_site))
+#define ASSERT_ENDS_WITH(substr,str,msg)		UNITTEST_AT(#substr ", " #str, true, UnitTest::Assert::EndsWith(substr,str,msg,unittest_site))
+#define TEST_ENDS_WITH0(substr,str)				UNITTEST_AT(#substr ", " #str, false, UnitTest::Assert::EndsWith(substr,str,NULL,unittest_site))
+#define TEST_ENDS_WITH(substr,str,msg)			UNITTEST_AT(#substr ", " #str, false, UnitTest::Assert::EndsWith(substr,str,msg,unittest_site))
+
+#define ASSERT_EQUAL_IGNORING_CASE0(str1,str2)		UNITTEST_AT(#str1 ", " #str2, true, UnitTest::Assert::AreEqualIgnoringCase(str1,str2,NULL,unittest_site))
+#define ASSERT_EQUAL_IGNORING_CASE(str1,str2,msg)	UNITTEST_AT(#str1 ", " #str2, true, UnitTest::Assert::AreEqualIgnoringCase(str1,str2,msg,unittest_site))
+#define TEST_EQUAL_IGNORING_CASE0(str1,str2)		UNITTEST_AT(#str1 ", " #str2, false, UnitTest::Assert::AreEqualIgnoringCase(str1,str2,NULL,unittest_site))
+#define TEST_EQUAL_IGNORING_CASE(str1,str2,msg)		UNITTEST_AT(#str1 ", " #str2, false, UnitTest::Assert::AreEqualIgnoringCase(str1,str2,msg,unittest_site))
+
+#define ASSERT_IS_MATCH0(pattern,str)			UNITTEST_AT(#pattern ", " #str, true, UnitTest::Assert::IsMatch(pattern,str,NULL,unittest_site))
+#define ASSERT_IS_MATCH(pattern,str,msg)		UNITTEST_AT(#pattern ", " #str, true, UnitTest::Assert::IsMatch(pattern,str,msg,unittest_site))
+#define TEST_IS_MATCH0(pattern,str)				UNITTEST_AT(#pattern ", " #str, false, UnitTest::Assert::IsMatch(pattern,str,NULL,unittest_site))
+#define TEST_IS_MATCH(pattern,str,msg)			UNITTEST_AT(#pattern ", " #str, false, UnitTest::Assert::IsMatch(pattern,str,msg,unittest_site))
+
+///////////////////////////////////////////////////////////////////////////////
+// CollectionAssert - contiguous ranges (C arrays, std::vector, std::array, std::string or
+// UnitTest::Collections::Range(pointer, count)); a whole range is one assertion
+///////////////////////////////////////////////////////////////////////////////
+#define ASSERT_COLLECTION_EQUAL0(expected,actual)				UNITTEST_AT(#expected ", " #actual, true, UnitTest::Assert::CollectionAreEqual(expected,actual,NULL,unittest_site))
+#define ASSERT_COLLECTION_EQUAL(expected,actual,msg)			UNITTEST_AT(#expected ", " #actual, true, UnitTest::Assert::CollectionAreEqual(expected,actual,msg,unittest_site))
+#define TEST_COLLECTION_EQUAL0(expected,actual)					UNITTEST_AT(#expected ", " #actual, false, UnitTest::Assert::CollectionAreEqual(expected,actual,NULL,unittest_site))
+#define TEST_COLLECTION_EQUAL(expected,actual,msg)				UNITTEST_AT(#expected ", " #actual, false, UnitTest::Assert::CollectionAreEqual(expected,actual,msg,unittest_site))
+
+#define ASSERT_COLLECTION_EQUIVALENT0(expected,actual)			UNITTEST_AT(#expected ", " #actual, true, UnitTest::Assert::CollectionAreEquivalent(expected,actual,NULL,unittest_site))
+#define ASSERT_COLLECTION_EQUIVALENT(expected,actual,msg)		UNITTEST_AT(#expected ", " #actual, true, UnitTest::Assert::CollectionAreEquivalent(expected,actual,msg,unittest_site))
+#define TEST_COLLECTION_EQUIVALENT0(expected,actual)			UNITTEST_AT(#expected ", " #actual, false, UnitTest::Assert::CollectionAreEquivalent(expected,actual,NULL,unittest_site))
+#define TEST_COLLECTION_EQUIVALENT(expected,actual,msg)			UNITTEST_AT(#expected ", " #actual, false, UnitTest::Assert::CollectionAreEquivalent(expected,actual,msg,unittest_site))
+
+#define ASSERT_COLLECTION_CONTAINS0(collection,value)			UNITTEST_AT(#collection ", " #value, true, UnitTest::Assert::CollectionContains(collection,value,NULL,unittest_site))
+#define ASSERT_COLLECTION_CONTAINS(collection,value,msg)		UNITTEST_AT(#collection ", " #value, true, UnitTest::Assert::CollectionContains(collection,value,msg,unittest_site))
+#define TEST_COLLECTION_CONTAINS0(collection,value)				UNITTEST_AT(#collection ", " #value, false, UnitTest::Assert::CollectionContains(collection,value,NULL,unittest_site))
+#define TEST_COLLECTION_CONTAINS(collection,value,msg)			UNITTEST_AT(#collection ", " #value, false, UnitTest::Assert::CollectionContains(collection,value,msg,unittest_site))
 
-#define ASSERT_STARTS_WITH0(substr,str)			UnitTest::Assert::StartsWith(substr,str,		true,__FILE__,__LINE__)
-#define ASSERT_STARTS_WITH(substr,str,msg)		UnitTest::Assert::StartsWith(substr,str,msg,	true,__FILE__,__LINE__)
-//[DISABLE] - TEST_STARTS_WITH - is disabled because it use more than one assertion in the test
+#define ASSERT_COLLECTION_ORDERED0(collection)					UNITTEST_AT(#collection, true, UnitTest::Assert::CollectionIsOrdered(collection,NULL,unittest_site))
+#define ASSERT_COLLECTION_ORDERED(collection,msg)				UNITTEST_AT(#collection, true, UnitTest::Assert::CollectionIsOrdered(collection,msg,unittest_site))
+#define TEST_COLLECTION_ORDERED0(collection)					UNITTEST_AT(#collection, false, UnitTest::Assert::CollectionIsOrdered(collection,NULL,unittest_site))
+#define TEST_COLLECTION_ORDERED(collection,msg)					UNITTEST_AT(#collection, false, UnitTest::Assert::CollectionIsOrdered(collection,msg,unittest_site))
 
-#define ASSERT_EQUAL_IGNORING_CASE0(str1,str2)		UnitTest::Assert::AreEqualIgnoringCase(str1,str2,		true,__FILE__,__LINE__)
-#define ASSERT_EQUAL_IGNORING_CASE(str1,str2,msg)	UnitTest::Assert::AreEqualIgnoringCase(str1,str2,msg,	true,__FILE__,__LINE__)
-//[DISABLE] - TEST_EQUAL_IGNORING_CASE - is disabled because it use more than one assertion in the test
+#define ASSERT_COLLECTION_NEAR0(expected,actual,tolerance)		UNITTEST_AT(#expected ", " #actual ", " #tolerance, true, UnitTest::Assert::CollectionAreNear(expected,actual,tolerance,NULL,unittest_site))
+#define ASSERT_COLLECTION_NEAR(expected,actual,tolerance,msg)	UNITTEST_AT(#expected ", " #actual ", " #tolerance, true, UnitTest::Assert::CollectionAreNear(expected,actual,tolerance,msg,unittest_site))
+#define TEST_COLLECTION_NEAR0(expected,actual,tolerance)		UNITTEST_AT(#expected ", " #actual ", " #tolerance, false, UnitTest::Assert::CollectionAreNear(expected,actual,tolerance,NULL,unittest_site))
+#define TEST_COLLECTION_NEAR(expected,actual,tolerance,msg)		UNITTEST_AT(#expected ", " #actual ", " #tolerance, false, UnitTest::Assert::CollectionAreNear(expected,actual,tolerance,msg,unittest_site))
 
-#define ASSERT_IS_MATCH0(str1,str2)				UnitTest::Assert::IsMatch(str1,str2,		true,__FILE__,__LINE__)
-#define ASSERT_IS_MATCH(str1,str2,msg)			UnitTest::Assert::IsMatch(str1,str2,msg,	true,__FILE__,__LINE__)
-//[DISABLE] - TEST_IS_MATCH - is disabled because it use more than one assertion in the test
+///////////////////////////////////////////////////////////////////////////////
+// FileAssert - two files given by their paths (LPCSTR or std::string)
+///////////////////////////////////////////////////////////////////////////////
+#define ASSERT_FILE_EQUAL0(expected,actual)		UNITTEST_AT(#expected ", " #actual, true, UnitTest::Assert::FileAreEqual(expected,actual,NULL,unittest_site))
+#define ASSERT_FILE_EQUAL(expected,actual,msg)	UNITTEST_AT(#expected ", " #actual, true, UnitTest::Assert::FileAreEqual(expected,actual,msg,unittest_site))
+#define TEST_FILE_EQUAL0(expected,actual)		UNITTEST_AT(#expected ", " #actual, false, UnitTest::Assert::FileAreEqual(expected,actual,NULL,unittest_site))
+#define TEST_FILE_EQUAL(expected,actual,msg)	UNITTEST_AT(#expected ", " #actual, false, UnitTest::Assert::FileAreEqual(expected,actual,msg,unittest_site))
+
+///////////////////////////////////////////////////////////////////////////////
+// DirectoryAssert - two directory trees given by their paths (LPCSTR or std::string)
+///////////////////////////////////////////////////////////////////////////////
+#define ASSERT_DIRECTORY_EQUAL0(expected,actual)		UNITTEST_AT(#expected ", " #actual, true, UnitTest::Assert::DirectoryAreEqual(expected,actual,NULL,unittest_site))
+#define ASSERT_DIRECTORY_EQUAL(expected,actual,msg)	UNITTEST_AT(#expected ", " #actual, true, UnitTest::Assert::DirectoryAreEqual(expected,actual,msg,unittest_site))
+#define TEST_DIRECTORY_EQUAL0(expected,actual)		UNITTEST_AT(#expected ", " #actual, false, UnitTest::Assert::DirectoryAreEqual(expected,actual,NULL,unittest_site))
+#define TEST_DIRECTORY_EQUAL(expected,actual,msg)		UNITTEST_AT(#expected ", " #actual, false, UnitTest::Assert::DirectoryAreEqual(expected,actual,msg,unittest_site))
 
 ///////////////////////////////////////////////////////////////////////////////
 // Utility Methods
 ///////////////////////////////////////////////////////////////////////////////
-#define ASSERT_PASS(msg)						UnitTest::Assert::Pass(msg, true,__FILE__,__LINE__)
-#define TEST_PASS(msg)							UnitTest::Assert::Pass(msg, false,__FILE__,__LINE__)
+#define ASSERT_PASS(msg)						UNITTEST_AT(#msg, true, UnitTest::Assert::Pass(msg,unittest_site))
+#define TEST_PASS(msg)							UNITTEST_AT(#msg, false, UnitTest::Assert::Pass(msg,unittest_site))
 
-#define ASSERT_FAIL(msg)						UnitTest::Assert::Fail(msg, true,__FILE__,__LINE__)
-#define TEST_FAIL(msg)							UnitTest::Assert::Fail(msg, false,__FILE__,__LINE__)
+#define ASSERT_FAIL(msg)						UNITTEST_AT(#msg, true, UnitTest::Assert::Fail(msg,unittest_site))
+#define TEST_FAIL(msg)							UNITTEST_AT(#msg, false, UnitTest::Assert::Fail(msg,unittest_site))
 
 ///////////////////////////////////////////////////////////////////////////////
-// Wrapper for assert functions - for example: ASSERT_WRAPPER( ASSERT_IS_TRUE(1==1) );
-#define ASSERT_WRAPPER(pFunction) try{ pFunction; } catch(const std::runtime_error& e) { std::cout << e.what() << std::endl; }
+// Test cases - TEST_CASE(suite, name) { ... } defines a test body and registers it in
+// the static registry. UnitTest::Runner::Main(argc, argv) runs all the registered cases.
+#define TEST_CASE(suite,name)																		\
+	static void UnitTest_##suite##_##name();														\
+	static const UnitTest::Registrar UnitTest_Registrar_##suite##_##name(#suite, #name,			\
+										&UnitTest_##suite##_##name, __FILE__, __LINE__);			\
+	static void UnitTest_##suite##_##name()
+
+// TEST_CASE_TAGS(suite, name, "fast,io") { ... } - a test case with tags, which --tags selects
+#define TEST_CASE_TAGS(suite,name,tags)																\
+	static void UnitTest_##suite##_##name();														\
+	static const UnitTest::Registrar UnitTest_Registrar_##suite##_##name(#suite, #name,			\
+									&UnitTest_##suite##_##name, __FILE__, __LINE__, false, tags);	\
+	static void UnitTest_##suite##_##name()
+
+// TEST_INPUT(path) inside a test case adds a data file to the files the case depends on:
+// with --changed-only the case is run again when the file changes (see class ResultCache)
+#define TEST_INPUT(path)						UnitTest::ResultCache::Input(path)
+
+// TEST_TIMEOUT(seconds) inside a test case replaces the --timeout limit of the case,
+// counted from its start (0 = no limit; see class Watchdog)
+#define TEST_TIMEOUT(seconds)					UnitTest::Watchdog::SetLimit(seconds)
+
+///////////////////////////////////////////////////////////////////////////////
+// Benchmarks - BENCHMARK(name) { setup; while(state.KeepRunning()) { ... } } registers a
+// microbenchmark which the Runner executes alone, after the test cases. Only the loop is
+// timed; DoNotOptimize(value) / ClobberMemory() keep the measured work from being removed.
+#define BENCHMARK(name)																				\
+	static void UnitTest_Benchmark_##name(UnitTest::BenchmarkState& state);							\
+	static void UnitTest_BenchmarkCase_##name()														\
+	{																								\
+		UnitTest::Benchmark::Run(#name, &UnitTest_Benchmark_##name, __FILE__, __LINE__);			\
+	}																								\
+	static const UnitTest::Registrar UnitTest_Registrar_Benchmark_##name("Benchmark", #name,		\
+										&UnitTest_BenchmarkCase_##name, __FILE__, __LINE__, true);	\
+	static void UnitTest_Benchmark_##name(UnitTest::BenchmarkState& state)
 
 ///////////////////////////////////////////////////////////////////////////////
-// Console color
-#define SET_CONSOLE_COLOR(color) SetConsoleTextAttribute( GetStdHandle(STD_OUTPUT_HANDLE), color)
+// Wrapper for assert functions - for example: ASSERT_WRAPPER( ASSERT_IS_TRUE(1==1) );
+#define ASSERT_WRAPPER(pFunction) try{ pFunction; } catch(const std::runtime_error& e) { std::cout << e.what() << std::endl; }
 
 ///////////////////////////////////////////////////////////////////////////////
 // namespace for UnitTest Framework - implementation for most of the NUnit functionality
@@ -230,712 +653,8690 @@ namespace UnitTest
 {
 
 ///////////////////////////////////////////////////////////////////////////////
-// class Assert implements all compare methods
+// class Statistics - PASS/FAIL counters and the quiet run mode
 ///////////////////////////////////////////////////////////////////////////////
-class Assert
+class Statistics
 {
 public:
-	///////////////////////////////////////////////////////////////////////////
-	// Equality Asserts - These methods test whether the two arguments are equal.
-	// Overloaded methods are provided for null terminated strings
-	///////////////////////////////////////////////////////////////////////////
-	template <class T1, class T2>
-	static void AreEqual(const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	static void SetQuiet(bool quiet)
 	{
-		Assert::AreEqual(expected, actual, NULL, throws, file, line);
+		Statistics::Quiet().store(quiet, std::memory_order_relaxed);
 	}
-
-	template <class T1, class T2>
-	static void AreEqual(const T1& expected, const T2& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	static bool IsQuiet()
 	{
-		Assert::Test( (expected == actual), message, 
-			/*[PASS]*/ _T("AreEqual: Expression was equal"),
-			/*[FAIL]*/ _T("AreEqual: Expression was not equal"),
-						expected, actual, throws, file, line);
+		return Statistics::Quiet().load(std::memory_order_relaxed);
 	}
 
-	template <class T1, class T2>
-	static void AreNotEqual(const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	static unsigned long Passed()
 	{
-		Assert::AreNotEqual(expected, actual, NULL, throws, file, line);
+		return Statistics::PassCounter().load(std::memory_order_relaxed);
 	}
-
-	template <class T1, class T2>
-	static void AreNotEqual(const T1& expected, const T2& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	static unsigned long Failed()
 	{
-		Assert::Test( (expected != actual), message,
-			/*[PASS]*/ _T("AreNotEqual: Expression was not equal"),
-			/*[FAIL]*/ _T("AreNotEqual: Expression was equal"),
-						expected, actual, throws, file, line);
+		return Statistics::FailCounter().load(std::memory_order_relaxed);
 	}
-
-	// AreEqual for null terminated strings: (LPCTSTR)x2 and (LPTSTR)x2 - with and without a message
-	static void AreEqual(LPCTSTR expected, LPCTSTR actual, bool throws, LPCSTR file, int line)
+	static void Reset()
 	{
-		Assert::AreEqual(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), NULL, throws, file, line);
+		Statistics::PassCounter().store(0, std::memory_order_relaxed);
+		Statistics::FailCounter().store(0, std::memory_order_relaxed);
 	}
-	static void AreEqual(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+
+	// the site of the assertion is kept as the last one of the running case (see Watchdog)
+	static void AddPass(LPCSTR file, int line)
 	{
-		Assert::AreEqual(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), message, throws, file, line);
+		if(Counters* counters = Statistics::Current())
+		{	// a test case is running on this thread - no shared cache line is touched
+			counters->passed.store(counters->passed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			counters->file.store(file, std::memory_order_relaxed);
+			counters->line.store(line, std::memory_order_relaxed);
+		}
+		else
+		{
+			Statistics::PassCounter().fetch_add(1, std::memory_order_relaxed);
+		}
 	}
-	static void AreEqual(LPTSTR expected, LPTSTR actual, bool throws, LPCSTR file, int line)
+	static void AddFail(LPCSTR file, int line)
 	{
-		Assert::AreEqual(expected, actual, NULL, throws, file, line);
-	}
-	static void AreEqual(LPTSTR expected, LPTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
-	{	// test _tcscmp only if the expected and actual buffers points to a string
-		if(expected && actual)
+		if(Counters* counters = Statistics::Current())
 		{
-			Assert::Test( (_tcscmp(expected, actual) == 0 ), message,
-				/*[PASS]*/ _T("AreEqual: Expression was equal"),
-				/*[FAIL]*/ _T("AreEqual: Expression was not equal"),
-							expected, actual, throws, file, line);
+			counters->failed.store(counters->failed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			counters->file.store(file, std::memory_order_relaxed);
+			counters->line.store(line, std::memory_order_relaxed);
 		}
 		else
-		{	// otherwise fail
-			Assert::Fail( message, _T("AreEqual: Expected a non-NULL pointers"), throws, file, line);
+		{
+			Statistics::FailCounter().fetch_add(1, std::memory_order_relaxed);
 		}
 	}
 
-	// AreNotEqual for null terminated strings: (LPCTSTR)x2 and (LPTSTR)x2 - with and without a message
-	static void AreNotEqual(LPCTSTR expected, LPCTSTR actual, bool throws, LPCSTR file, int line)
+	// per test case counters - the Runner points the current thread to the counters of the
+	// running case and adds them to the global totals when the case completes
+	// the fields are written by the worker and read by the Watchdog thread while the case
+	// runs, so they are atomics; relaxed loads and stores compile to plain moves
+	struct Counters
 	{
-		Assert::AreNotEqual(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), NULL, throws, file, line);
-	}
-	static void AreNotEqual(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+		Counters() : passed(0), failed(0), file(NULL), line(0) {}
+		Counters(const Counters& other) : passed(other.passed.load(std::memory_order_relaxed)),
+			failed(other.failed.load(std::memory_order_relaxed)),
+			file(other.file.load(std::memory_order_relaxed)),
+			line(other.line.load(std::memory_order_relaxed)) {}
+		Counters& operator=(const Counters& other)
+		{
+			passed.store(other.passed.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			failed.store(other.failed.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			file.store(other.file.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			line.store(other.line.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			return *this;
+		}
+
+		std::atomic<unsigned long> passed;
+		std::atomic<unsigned long> failed;
+		std::atomic<LPCSTR> file;	// the last assertion of the case, NULL before the first one
+		std::atomic<int> line;
+	};
+	static void Begin(Counters* counters)
 	{
-		Assert::AreNotEqual(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), message, throws, file, line);
+		counters->passed.store(0, std::memory_order_relaxed);
+		counters->failed.store(0, std::memory_order_relaxed);
+		counters->file.store(NULL, std::memory_order_relaxed);
+		counters->line.store(0, std::memory_order_relaxed);
+		Statistics::Current() = counters;
 	}
-	static void AreNotEqual(LPTSTR expected, LPTSTR actual, bool throws, LPCSTR file, int line)
+	static void End(Counters* counters)
 	{
-		Assert::AreNotEqual(expected, actual, NULL, throws, file, line);
+		Statistics::Current() = NULL;
+		Statistics::Add(*counters);
 	}
-	static void AreNotEqual(LPTSTR expected, LPTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
-	{	// test _tcscmp only if the expected and actual buffers points to a string
-		if(expected && actual)
-		{
-			Assert::Test( (_tcscmp(expected, actual) != 0 ), message, 
-				/*[PASS]*/ _T("AreNotEqual: Expression was not equal"),
-				/*[FAIL]*/ _T("AreNotEqual: Expression was equal"),
-							expected, actual, throws, file, line);
-		}
-		else
-		{	// otherwise fail
-			Assert::Fail( message, _T("AreEqual: Expected a non-NULL pointers"), throws, file, line);
-		}
+	static void Add(const Counters& counters)
+	{
+		Statistics::PassCounter().fetch_add(counters.passed.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		Statistics::FailCounter().fetch_add(counters.failed.load(std::memory_order_relaxed), std::memory_order_relaxed);
 	}
 
-	///////////////////////////////////////////////////////////////////////////
-	// Identity Asserts - test whether the same objects are referenced by the two arguments.
-	///////////////////////////////////////////////////////////////////////////
-	// [TODO] Not implemented - because its not relevant for C++
-	///////////////////////////////////////////////////////////////////////////
-	// static void AreSame(T1 const& expected, T2 const& actual, bool throws, LPCSTR file, int line);
-	//
-	// static void AreNotSame(T1 const& expected, T2 const& actual, bool throws, LPCSTR file, int line);
- 	///////////////////////////////////////////////////////////////////////////
-
-	///////////////////////////////////////////////////////////////////////////
-	// Condition Tests - Methods that test a specific condition are named for the condition
-	// they test and take the value tested as their first argument and, optionally a message
-	// as the second.
-	// Two forms are provided for the True, False, Null and NotNull conditions.
-	// With or without the "Is" prefix.
-	///////////////////////////////////////////////////////////////////////////
-	static void IsTrue (int condition, bool throws, LPCSTR file, int line)
+private:
+	// function local statics keep the header self contained (no .cpp is needed)
+	static std::atomic<bool>& Quiet()
 	{
-	    Assert::IsTrue(condition, NULL, throws, file, line);
+#ifdef UNITTEST_QUIET
+		static std::atomic<bool> quiet(true);
+#else
+		static std::atomic<bool> quiet(false);
+#endif
+		return quiet;
 	}
-	static void IsTrue (int condition, LPCTSTR message, bool throws, LPCSTR file, int line)
+	static std::atomic<unsigned long>& PassCounter()
 	{
-	    Assert::Test( (condition == 1), message, 
-			/*[PASS]*/ _T("IsTrue: Condition was true"),
-			/*[FAIL]*/ _T("IsTrue: Condition was not true"),
-						throws, file, line);
+		static std::atomic<unsigned long> counter(0);
+		return counter;
 	}
-	static void True (int condition, bool throws, LPCSTR file, int line)
+	static std::atomic<unsigned long>& FailCounter()
 	{
-	    Assert::True(condition, NULL, throws, file, line);
+		static std::atomic<unsigned long> counter(0);
+		return counter;
 	}
-	static void True (int condition, LPCTSTR message, bool throws, LPCSTR file, int line)
+	static Counters*& Current()
 	{
-	    Assert::Test( (condition == 1), message, 
-			/*[PASS]*/ _T("True: Condition was true"),
-			/*[FAIL]*/ _T("True: Condition was not true"),
-						throws, file, line);
+		static thread_local Counters* current = NULL;
+		return current;
 	}
+};	// Statistics
 
-	static void IsFalse(int condition, bool throws, LPCSTR file, int line)
+///////////////////////////////////////////////////////////////////////////////
+// class Allocations - per thread operator new/delete counters
+// The counting operators are defined at the end of this header in the source
+// file which defines UNITTEST_TRACK_ALLOCATIONS before including it. Each block
+// carries a small header with its size (padded to the alignment of an over-
+// aligned type), so delete knows how many bytes to subtract. Allocations made
+// by the framework itself (formatting the PASS/FAIL messages) are not counted.
+///////////////////////////////////////////////////////////////////////////////
+class Allocations
+{
+public:
+	struct Counters
 	{
-	    Assert::IsFalse(condition, NULL, throws, file, line);
-	}
-	static void IsFalse(int condition, LPCTSTR message, bool throws, LPCSTR file, int line)
+		unsigned long long	calls;		// operator new calls
+		unsigned long long	bytes;		// bytes requested by operator new
+		long long			current;	// bytes allocated minus bytes freed on this thread
+		long long			peak;		// highest 'current'
+	};
+
+	static bool IsTracking()
 	{
-	    Assert::Test( (condition == 0), message, 
-			/*[PASS]*/ _T("IsFalse: Condition was false"),
-			/*[FAIL]*/ _T("IsFalse: Condition was not false"),
-						throws, file, line);
+		return Allocations::Tracking();
 	}
-	static void False(int condition, bool throws, LPCSTR file, int line)
+	static bool Enable()
 	{
-	    Assert::False(condition, NULL, throws, file, line);
+		Allocations::Tracking() = true;
+		return true;
 	}
-	static void False(int condition, LPCTSTR message, bool throws, LPCSTR file, int line)
+
+	// the counters of the calling thread
+	static Counters& Thread()
 	{
-	    Assert::Test( (condition == 0), message, 
-			/*[PASS]*/ _T("False: Condition was false"),
-			/*[FAIL]*/ _T("False: Condition was not false"),
-						throws, file, line);
+		static thread_local Counters counters;	// zero initialized
+		return counters;
 	}
 
-	template <class T>
-	static void IsNull(T* pointer, bool throws, LPCSTR file, int line)
+	// snapshot at the start of a measured region - the peak restarts from the current value
+	static Counters Begin()
 	{
-	    Assert::IsNull(pointer, NULL, throws, file, line);
+		Counters& counters = Allocations::Thread();
+		counters.peak = counters.current;
+		return counters;
 	}
-	template <class T>
-	static void IsNull(T* pointer, LPCTSTR message, bool throws, LPCSTR file, int line)
+	// the usage since Begin(): calls, bytes and peak above the start; 'current' holds the leaked bytes
+	static Counters Since(const Counters& begin)
 	{
-		Assert::Test( (pointer == 0), message,
-			/*[PASS]*/ _T("IsNull: Actual pointer was a NULL pointer"),
-			/*[FAIL]*/ _T("IsNull: Expected a NULL pointer"),
-						throws, file, line );
+		const Counters& now = Allocations::Thread();
+		Counters usage = { now.calls - begin.calls, now.bytes - begin.bytes,
+						   now.current - begin.current, now.peak - begin.current };
+		return usage;
 	}
-	template <class T>
-	static void Null(T* pointer, bool throws, LPCSTR file, int line)
+
+	// the framework's own allocations inside this scope are not counted
+	class Ignore
 	{
-	    Assert::Null(pointer, NULL, throws, file, line);
+	public:
+		Ignore()	{ ++Allocations::Depth(); }
+		~Ignore()	{ --Allocations::Depth(); }
+	};
+
+	// NULL if the size with the header does not fit in a size_t or malloc fails. Allocate and
+	// Free stay out of line: inlined into the replacement operators, GCC pairs 'new' with
+	// free() and the header reads with the user block (-Wmismatched-new-delete, -Warray-bounds)
+	UNITTEST_NOINLINE static void* Allocate(size_t size)
+	{
+		if(size > std::numeric_limits<size_t>::max() - Header)
+		{
+			return NULL;
+		}
+		char* block = static_cast<char*>(malloc(size + Header));
+		if(!block)
+		{
+			return NULL;
+		}
+		return Allocations::Track(block, Header, size);
 	}
-	template <class T>
-	static void Null(T* pointer, LPCTSTR message, bool throws, LPCSTR file, int line)
+	// over-aligned blocks (operator new with std::align_val_t) - the header is padded to the alignment
+	UNITTEST_NOINLINE static void* Allocate(size_t size, size_t alignment)
 	{
-		Assert::Test( (pointer == 0), message,
-			/*[PASS]*/ _T("Null: Actual pointer was a NULL pointer"),
-			/*[FAIL]*/ _T("Null: Expected a NULL pointer"),
-						throws, file, line );
+		if(alignment < Header)
+		{
+			alignment = Header;
+		}
+		if(size > std::numeric_limits<size_t>::max() - 2 * alignment)
+		{
+			return NULL;
+		}
+		const size_t total = (alignment + size + alignment - 1) / alignment * alignment;	// aligned_alloc wants a multiple
+#if defined(_WIN32)
+		char* block = static_cast<char*>(_aligned_malloc(total, alignment));
+#else
+		char* block = static_cast<char*>(aligned_alloc(alignment, total));
+#endif
+		if(!block)
+		{
+			return NULL;
+		}
+		return Allocations::Track(block, alignment, size);
 	}
 
-	template <class T>
-	static void IsNotNull(T* pointer, bool throws, LPCSTR file, int line)
+	UNITTEST_NOINLINE static void Free(void* pointer)
 	{
-	    Assert::IsNotNull(pointer, NULL, throws, file, line);
+		if(!pointer)
+		{
+			return;
+		}
+		free(Allocations::Untrack(pointer, Header));
 	}
- 	template <class T>
-	static void IsNotNull(T* pointer, LPCTSTR message, bool throws, LPCSTR file, int line)
+	UNITTEST_NOINLINE static void Free(void* pointer, size_t alignment)
 	{
-		Assert::Test( (pointer != 0), message,
-			/*[PASS]*/ _T("IsNotNull: Actual pointer was a non-NULL pointer"),
-			/*[FAIL]*/ _T("IsNotNull: Expected a non-NULL pointer"),
-						throws, file, line);
+		if(!pointer)
+		{
+			return;
+		}
+		char* block = Allocations::Untrack(pointer, alignment < Header ? static_cast<size_t>(Header) : alignment);
+#if defined(_WIN32)
+		_aligned_free(block);
+#else
+		free(block);
+#endif
 	}
-	template <class T>
-	static void NotNull(T* pointer, bool throws, LPCSTR file, int line)
+
+private:
+	enum { Header = 2 * sizeof(size_t) < 16 ? 16 : 2 * sizeof(size_t) };	// keeps the malloc alignment
+
+	// the header is the last Header bytes before the user block, which starts 'offset' bytes into the block
+	static void* Track(char* block, size_t offset, size_t size)
 	{
-	    Assert::NotNull(pointer, NULL, throws, file, line);
+		size_t* header = reinterpret_cast<size_t*>(reinterpret_cast<uintptr_t>(block) + offset - Header);
+		header[0] = size;
+		header[1] = Allocations::Depth() == 0;	// counted
+		if(header[1])
+		{
+			Counters& counters = Allocations::Thread();
+			++counters.calls;
+			counters.bytes += size;
+			counters.current += static_cast<long long>(size);
+			if(counters.current > counters.peak)
+			{
+				counters.peak = counters.current;
+			}
+		}
+		return block + offset;
 	}
-	template <class T>
-	static void NotNull(T* pointer, LPCTSTR message, bool throws, LPCSTR file, int line)
+	static char* Untrack(void* pointer, size_t offset)
 	{
-		Assert::Test( (pointer != 0), message,
-			/*[PASS]*/ _T("NotNull: Actual pointer was a non-NULL pointer"),
-			/*[FAIL]*/ _T("NotNull: Expected a non-NULL pointer"),
-						throws, file, line);
+		const uintptr_t user = reinterpret_cast<uintptr_t>(pointer);
+		const size_t* header = reinterpret_cast<const size_t*>(user - Header);
+		if(header[1])
+		{
+			Allocations::Thread().current -= static_cast<long long>(header[0]);
+		}
+		return reinterpret_cast<char*>(user - offset);
 	}
 
-	// IsEmpty for null terminated strings: (LPCTSTR)x2 and (LPTSTR)x2 - with and without a message
-	static void IsEmpty(LPCTSTR buffer, bool throws, LPCSTR file, int line)
+	static bool& Tracking()
 	{
-	    Assert::IsEmpty(const_cast<LPTSTR>(buffer), NULL, throws, file, line);
+		static bool tracking = false;
+		return tracking;
 	}
-	static void IsEmpty(LPCTSTR buffer, LPCTSTR message, bool throws, LPCSTR file, int line)
+	static unsigned& Depth()
 	{
-	    Assert::IsEmpty(const_cast<LPTSTR>(buffer), message, throws, file, line);
+		static thread_local unsigned depth;
+		return depth;
 	}
-	static void IsEmpty(LPTSTR buffer, bool throws, LPCSTR file, int line)
+};	// Allocations
+
+///////////////////////////////////////////////////////////////////////////////
+// class Resources - CPU time, resident set size and context switches
+// Linux: getrusage(RUSAGE_THREAD) for the CPU time and the context switches of
+// the calling thread and /proc/self/statm for the RSS of the process.
+// Windows: GetThreadTimes and K32GetProcessMemoryInfo (no context switches).
+///////////////////////////////////////////////////////////////////////////////
+class Resources
+{
+public:
+	struct Usage
 	{
-	    Assert::IsEmpty(buffer, NULL, throws, file, line);
-	}
-	static void IsEmpty(LPTSTR buffer, LPCTSTR message, bool throws, LPCSTR file, int line)
-	{	// test _tcsclen only if the buffer points to a string
-		if(buffer)
+		double		userTime;				// milliseconds
+		double		systemTime;				// milliseconds
+		long long	rss;					// bytes
+		long long	voluntarySwitches;
+		long long	involuntarySwitches;
+	};
+
+	static Usage Sample()
+	{
+		Usage usage = { 0, 0, 0, 0, 0 };
+#if defined(__linux__)
+		struct rusage ru;
+#if defined(RUSAGE_THREAD)
+		if(getrusage(RUSAGE_THREAD, &ru) == 0)
+#else
+		if(getrusage(RUSAGE_SELF, &ru) == 0)
+#endif
 		{
-			Assert::Test( (_tcsclen(buffer) == 0), message, 
-				/*[PASS]*/ _T("IsEmpty: Actual string was empty"),
-				/*[FAIL]*/ _T("IsEmpty: Expected an empty string"),
-							throws, file, line);
+			usage.userTime = ru.ru_utime.tv_sec * 1e3 + ru.ru_utime.tv_usec / 1e3;
+			usage.systemTime = ru.ru_stime.tv_sec * 1e3 + ru.ru_stime.tv_usec / 1e3;
+			usage.voluntarySwitches = ru.ru_nvcsw;
+			usage.involuntarySwitches = ru.ru_nivcsw;
 		}
-		else
-		{	// otherwise pass
-			Assert::Pass( message, _T("IsEmpty: Actual string was empty"), throws, file, line);
+		int fd = open("/proc/self/statm", O_RDONLY);
+		if(fd >= 0)
+		{	// "size resident shared ..." in pages
+			char buffer[128];
+			ssize_t length = read(fd, buffer, sizeof(buffer) - 1);
+			close(fd);
+			if(length > 0)
+			{
+				buffer[length] = 0;
+				char* resident = strchr(buffer, ' ');
+				if(resident)
+				{
+					usage.rss = strtoll(resident + 1, NULL, 10) * sysconf(_SC_PAGESIZE);
+				}
+			}
+		}
+#elif defined(_WIN32)
+		FILETIME creation, exit, kernel, user;
+		if(GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+		{	// 100 ns units
+			usage.userTime = ((static_cast<ULONGLONG>(user.dwHighDateTime) << 32) | user.dwLowDateTime) / 1e4;
+			usage.systemTime = ((static_cast<ULONGLONG>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime) / 1e4;
+		}
+		PROCESS_MEMORY_COUNTERS counters;
+		if(K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		{
+			usage.rss = static_cast<long long>(counters.WorkingSetSize);
 		}
+#endif
+		return usage;
 	}
 
-	// IsNotEmpty for null terminated strings: (LPCTSTR)x2 and (LPTSTR)x2 - with and without a message
-	static void IsNotEmpty(LPCTSTR buffer, bool throws, LPCSTR file, int line)
+	// the usage since 'begin' - 'rss' is the growth (negative if the process shrank)
+	static Usage Since(const Usage& begin)
 	{
-	    Assert::IsNotEmpty(const_cast<LPTSTR>(buffer), NULL, throws, file, line);
+		Usage now = Resources::Sample();
+		Usage usage = { now.userTime - begin.userTime, now.systemTime - begin.systemTime, now.rss - begin.rss,
+						now.voluntarySwitches - begin.voluntarySwitches, now.involuntarySwitches - begin.involuntarySwitches };
+		return usage;
 	}
-	static void IsNotEmpty(LPCTSTR buffer, LPCTSTR message, bool throws, LPCSTR file, int line)
+
+	// the highest RSS of the process so far in bytes
+	static long long PeakRss()
 	{
-	    Assert::IsNotEmpty(const_cast<LPTSTR>(buffer), message, throws, file, line);
+#if defined(__linux__)
+		struct rusage ru;
+		return getrusage(RUSAGE_SELF, &ru) == 0 ? ru.ru_maxrss * 1024LL : 0;
+#elif defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters;
+		return K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)) ?
+				static_cast<long long>(counters.PeakWorkingSetSize) : 0;
+#else
+		return 0;
+#endif
 	}
-	static void IsNotEmpty(LPTSTR buffer, bool throws, LPCSTR file, int line)
+};	// Resources
+
+///////////////////////////////////////////////////////////////////////////////
+// class PerfCounters - hardware performance counters (Linux perf_event_open)
+// Each thread opens two counter groups once, on first use: the hardware group
+// (cycles, instructions, branch misses, L1d and LLC read misses) and the
+// software group (task-clock, page-faults); a sample is one read() per group.
+// Events which cannot be opened (no PMU in containers or VMs, perf_event_paranoid)
+// are left out, so in the worst case only the software counters are reported;
+// when even those are refused, kernel time is excluded and they are retried.
+// A run in which no event opens at all prints one notice.
+// Disabled by default - PerfCounters::SetEnabled(true) or --perf-counters.
+///////////////////////////////////////////////////////////////////////////////
+class PerfCounters
+{
+public:
+	enum Event { Cycles, Instructions, BranchMisses, L1dMisses, LlcMisses, TaskClock, PageFaults, Count };
+
+	struct Counters
 	{
-	    Assert::IsNotEmpty(buffer, NULL, throws, file, line);
+		unsigned long long	value[Count];
+		unsigned			available;		// bit mask of the events in 'value'
+	};
+
+	static void SetEnabled(bool enabled)	{ PerfCounters::Enabled() = enabled; }
+	static bool IsEnabled()					{ return PerfCounters::Enabled(); }
+
+	static LPCTSTR Name(int event)
+	{
+		static const LPCTSTR names[Count] = { _T("cycles"), _T("instructions"), _T("branch-misses"),
+											  _T("L1d-misses"), _T("LLC-misses"), _T("task-clock-ns"), _T("page-faults") };
+		return names[event];
 	}
-	static void IsNotEmpty(LPTSTR buffer, LPCTSTR message, bool throws, LPCSTR file, int line)
-	{	// test _tcsclen only if the buffer points to a string
-		if(buffer)
+
+	static Counters Sample()
+	{
+		Counters counters;
+		memset(&counters, 0, sizeof(counters));
+#if defined(__linux__)
+		if(!PerfCounters::IsEnabled())
 		{
-			Assert::Test( (_tcsclen(buffer) > 0), message, 
-				/*[PASS]*/ _T("IsNotEmpty: Actual string was not empty"),
-				/*[FAIL]*/ _T("IsNotEmpty: Expected a non-empty string"),
-							throws, file, line);
+			return counters;
 		}
-		else
-		{	// otherwise fail
-			Assert::Fail( message, _T("IsEmpty: Expected an empty string"), throws, file, line);
+		ThreadGroups& groups = PerfCounters::Groups();
+		if(!groups.opened)
+		{
+			groups.Open();
 		}
+		groups.hardware.Read(counters);
+		groups.software.Read(counters);
+#endif
+		return counters;
 	}
 
-	///////////////////////////////////////////////////////////////////////////
-	// Comparisons (NUnit 2.2.4) - The following methods test whether one object is:
-	// Greater(>) / GreaterOrEqual(>=) / Less(<) / LessOrEqual(<=) than another
-	template <class T1, class T2>
-	static void Greater(const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	static Counters Since(const Counters& begin)
 	{
-		Assert::Greater(expected, actual, NULL, throws, file, line);
+		Counters now = PerfCounters::Sample();
+		now.available &= begin.available;
+		for(int i = 0; i < Count; ++i)
+		{
+			now.value[i] -= begin.value[i];
+		}
+		return now;
 	}
 
-	template <class T1, class T2>
-	static void Greater(const T1& expected, const T2& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	// ", cycles 123, instructions 456, ..." - every available counter divided by 'per'
+	static std::string Format(const Counters& counters, double per)
 	{
-		Assert::Test( (expected > actual), message,
-			/*[PASS]*/ _T("Greater: Condition was Greater"),
-			/*[FAIL]*/ _T("Greater: Condition was not Greater"),
-						expected, actual, throws, file, line);
+		std::ostringstream ostr;
+		ostr.setf(std::ios::fixed);
+		ostr.precision(per == 1 ? 0 : 2);
+		for(int i = 0; i < Count; ++i)
+		{
+			if(counters.available & (1u << i))
+			{
+				ostr << _T(", ") << Name(i) << _T(" ") << counters.value[i] / per;
+			}
+		}
+		const unsigned ipc = (1u << Cycles) | (1u << Instructions);
+		if((counters.available & ipc) == ipc && counters.value[Cycles])
+		{
+			ostr.precision(2);
+			ostr << _T(", IPC ") << static_cast<double>(counters.value[Instructions]) / counters.value[Cycles];
+		}
+		return ostr.str();
 	}
 
-	template <class T1, class T2>
-	static void GreaterOrEqual(const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	// a forked child counts a different thread - the inherited descriptors are closed and reopened
+	static void ResetThread()
 	{
-		Assert::GreaterOrEqual(expected, actual, NULL, throws, file, line);
+#if defined(__linux__)
+		PerfCounters::Groups().Close();
+#endif
 	}
 
-	template <class T1, class T2>
-	static void GreaterOrEqual(const T1& expected, const T2& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+private:
+	static bool& Enabled()
 	{
-		Assert::Test( (expected >= actual), message,
-			/*[PASS]*/ _T("GreaterOrEqual: Condition was Greater or equal"),
-			/*[FAIL]*/ _T("GreaterOrEqual: Condition was not Greater or equal"),
-						expected, actual, throws, file, line);
+		static bool enabled = false;
+		return enabled;
 	}
 
-	template <class T1, class T2>
-	static void Less(const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+#if defined(__linux__)
+	struct Group
 	{
-		Assert::Less(expected, actual, NULL, throws, file, line);
-	}
+		int	leader;
+		int	size;
+		int	event[Count];	// the event of every position in the group read
+		int	fd[Count];
 
-	template <class T1, class T2>
-	static void Less(const T1& expected, const T2& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+		void Add(Event id, unsigned type, unsigned long long config, bool hardware)
+		{
+			struct perf_event_attr attr;
+			memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = type;
+			attr.config = config;
+			attr.exclude_kernel = hardware ? 1 : 0;
+			attr.exclude_hv = 1;
+			attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			int fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0));
+			if(fd < 0 && (errno == EACCES || errno == EPERM) && !attr.exclude_kernel)
+			{	// perf_event_paranoid=2 allows an unprivileged process only its user space
+				attr.exclude_kernel = 1;
+				fd = static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, leader, 0));
+			}
+			if(fd < 0)
+			{
+				return;
+			}
+			if(leader < 0)
+			{
+				leader = fd;
+			}
+			this->fd[size] = fd;
+			event[size++] = id;
+		}
+
+		void Close()
+		{
+			for(int i = 0; i < size; ++i)
+			{
+				close(fd[i]);
+			}
+			leader = -1;
+			size = 0;
+		}
+
+		void Read(Counters& counters) const
+		{
+			if(leader < 0)
+			{
+				return;
+			}
+			unsigned long long buffer[3 + Count];	// nr, time_enabled, time_running, values
+			if(read(leader, buffer, sizeof(buffer)) < static_cast<ssize_t>(3 * sizeof(unsigned long long)))
+			{
+				return;
+			}
+			// scale up if the group was multiplexed with other perf users
+			double scale = buffer[2] ? static_cast<double>(buffer[1]) / buffer[2] : 0;
+			for(unsigned long long i = 0; i < buffer[0] && i < static_cast<unsigned long long>(size); ++i)
+			{
+				counters.value[event[i]] = static_cast<unsigned long long>(buffer[3 + i] * scale);
+				counters.available |= 1u << event[i];
+			}
+		}
+	};
+
+	struct ThreadGroups
 	{
-		Assert::Test( (expected < actual), message,
-			/*[PASS]*/ _T("Less: Condition was Less"),
-			/*[FAIL]*/ _T("Less: Condition was not Less"),
-						expected, actual, throws, file, line);
+		bool	opened;
+		Group	hardware;
+		Group	software;
+
+		~ThreadGroups()
+		{	// a pool worker closes its descriptors when it exits
+			Close();
+		}
+
+		void Open()
+		{
+			opened = true;
+			hardware.leader = software.leader = -1;
+			hardware.size = software.size = 0;
+			const unsigned long long read_miss = (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+			hardware.Add(Cycles,		PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, true);
+			hardware.Add(Instructions,	PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, true);
+			hardware.Add(BranchMisses,	PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, true);
+			hardware.Add(L1dMisses,		PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | read_miss, true);
+			hardware.Add(LlcMisses,		PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | read_miss, true);
+			software.Add(TaskClock,		PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, false);
+			software.Add(PageFaults,	PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, false);
+			static std::atomic<bool> noticed(false);
+			if(hardware.leader < 0 && software.leader < 0 && !noticed.exchange(true))
+			{	// once per process, so --perf-counters does not silently do nothing
+				Allocations::Ignore ignore;
+				std::cerr << std::string(_T("--perf-counters: no perf event could be opened (")) + strerror(errno)
+							 + _T("), the cases are reported without counters\n") << std::flush;
+			}
+		}
+
+		void Close()
+		{
+			if(opened)
+			{
+				hardware.Close();
+				software.Close();
+			}
+			opened = false;
+		}
+	};
+
+	static ThreadGroups& Groups()
+	{
+		static thread_local ThreadGroups groups;	// zero initialized - opened on first Sample()
+		return groups;
 	}
+#endif
+};	// PerfCounters
 
-	template <class T1, class T2>
-	static void LessOrEqual(const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+///////////////////////////////////////////////////////////////////////////////
+// Test case records - shared by the Registry, the Runner and the report writers
+///////////////////////////////////////////////////////////////////////////////
+typedef void (*TestFunction)();
+
+struct TestCase
+{
+	LPCSTR			suite;
+	LPCSTR			name;
+	TestFunction	function;
+	LPCSTR			file;
+	int				line;
+	bool			benchmark;	// run alone after the test cases
+	LPCSTR			tags;		// TEST_CASE_TAGS - "fast,io", NULL without tags
+};
+
+// resource usage of one case (plain data - copied through the forked result region)
+struct CaseMetrics
+{
+	Allocations::Counters	allocations;	// calls, bytes and peak of the case; 'current' = leaked bytes
+	Resources::Usage		resources;		// CPU time and context switches of the case, RSS growth
+	PerfCounters::Counters	counters;		// hardware/software counters of the case (--perf-counters)
+};
+
+struct CaseResult
+{
+	Statistics::Counters	counters;	// PASS/FAIL assertions of the case
+	bool					aborted;	// the case was ended by an exception
+	std::string				error;		// the exception text
+	double					seconds;
+	CaseMetrics				metrics;
+	std::vector<std::string>	inputs;		// the files declared with TEST_INPUT (ResultCache)
+};
+
+// the totals of a run - passed to the report writers when the run ends
+struct RunSummary
+{
+	size_t			cases;
+	size_t			failedCases;
+	unsigned long	passed;		// assertions
+	unsigned long	failed;
+	double			seconds;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Site - the constant descriptor of one assertion macro (see UNITTEST_SITE)
+// The id hashes file:line, so it is the same in every run and in every forked
+// worker - the reporters aggregate by it. A direct Assert:: call builds one on the fly.
+///////////////////////////////////////////////////////////////////////////////
+struct Site
+{
+	LPCSTR		file;
+	LPCTSTR		text;		// the macro arguments, NULL for a direct call
+	int			line;
+	bool		throws;		// ASSERT_ (true) or TEST_ (false)
+
+	static constexpr Site At(LPCSTR file, int line, LPCTSTR text, bool throws)
 	{
-		Assert::LessOrEqual(expected, actual, NULL, throws, file, line);
+		return Site{ file, text, line, throws };
 	}
 
-	template <class T1, class T2>
-	static void LessOrEqual(const T1& expected, const T2& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	// FNV-1a of the file name and the line number - computed when a record is
+	// written, so the constant stays 24 bytes
+	constexpr unsigned long long Id() const
 	{
-		Assert::Test( (expected <= actual), message,
-			/*[PASS]*/ _T("Less: Condition was Less or equal"),
-			/*[FAIL]*/ _T("Less: Condition was not Less or equal"),
-						expected, actual, throws, file, line);
+		unsigned long long hash = 14695981039346656037ULL;
+		for(LPCSTR c = file; *c; ++c)
+		{
+			hash = (hash ^ static_cast<unsigned char>(*c)) * 1099511628211ULL;
+		}
+		for(unsigned value = static_cast<unsigned>(line); value; value >>= 8)
+		{
+			hash = (hash ^ (value & 0xff)) * 1099511628211ULL;
+		}
+		return hash;
 	}
+};	// Site
 
- 	///////////////////////////////////////////////////////////////////////////
-	// Type Asserts (NUnit 2.2.3 / 2.5) - These methods allow us to make assertions 
-	// about the type of an object.
-	///////////////////////////////////////////////////////////////////////////
-	// [TODO] Not implemented - because the compilation should support RTTI 
-	//							#include <typeinfo.h> // compile with: /GR /EHsc
-	///////////////////////////////////////////////////////////////////////////
-	//static void IsInstanceOfType(const type_info& expected, const T& actual, bool throws, LPCSTR file, int line);
-	//
-	//static void IsNotInstanceOfType(const type_info& expected, const T& actual, bool throws, LPCSTR file, int line);
-	//
-	//static void IsAssignableFrom(const type_info& expected, const T& actual, bool throws, LPCSTR file, int line);
-	//
-	//static void IsNotAssignableFrom(const type_info& expected, const T& actual, bool throws, LPCSTR file, int line);
-	///////////////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////
+// class SiteProfile - hits, PASS/FAIL counts and time of every assertion site
+// Compiled into the assertion macros by defining UNITTEST_PROFILE_SITES before
+// including this header; recording is off until SiteProfile::SetEnabled(true)
+// (or --profile-sites N). The macro opens a Scope around the whole call, so the
+// time includes the evaluation of the arguments and the formatting of the
+// record, and a nested assertion (a DURATION_LESS body) is also counted in its
+// outer one. Every thread adds to its own table, keyed by the address of the
+// constant Site - no lock and no shared cache line on the assertion path - and
+// the table is merged into the process table when the thread exits (or on
+// Collect() for the calling thread). A forked worker writes its entries to a
+// file after every case, so a crash loses only the running case.
+///////////////////////////////////////////////////////////////////////////////
+class SiteProfile
+{
+public:
+	struct Entry
+	{
+		const Site*			site;		// NULL = empty slot
+		unsigned long long	hits;
+		unsigned long long	passed;
+		unsigned long long	failed;		// hits - passed - failed = left by another exception
+		unsigned long long	nanoseconds;
+	};
 
-	///////////////////////////////////////////////////////////////////////////
-	// Exception Asserts (NUnit 2.5) - When used with a Type argument, Assert::Throws requires
-	// that exact type to be thrown. If you want to test for any derived Type, use one of the
-	// forms that allows specifying a constraint.
-	// Alternatively, you may use Assert::Catch, which differs from Assert::Throws in allowing
-	// derived types
-	///////////////////////////////////////////////////////////////////////////
-	// [TODO] Not implemented - because its not relevant for C++
-	///////////////////////////////////////////////////////////////////////////
-	//static Exception Throws( Type expectedExceptionType, TestDelegate code, string message, params object[] parms);
-	//
-	//static Exception Throws( IResolveConstraint constraint, TestDelegate code, string message, params object[] parms);
-	//
-	//static T Throws<T>( TestDelegate code, string message, params object[] parms);
-	//
-	//static void DoesNotThrow( TestDelegate code, string message, params object[] parms);
-	//
-	//static Exception Catch( TestDelegate code, string message, params object[] parms);
-	//
-	//static Exception Catch( Type expectedExceptionType, TestDelegate code,  string message, params object[] parms);
-	//
-	//static T Catch<T>( TestDelegate code, string message,  params object[] parms);
-	///////////////////////////////////////////////////////////////////////////
+	static void SetEnabled(bool enabled)	{ SiteProfile::Enabled() = enabled; }
+	static bool IsEnabled()					{ return SiteProfile::Enabled(); }
 
-	///////////////////////////////////////////////////////////////////////////
-	// Utility Methods - Two utility methods, Pass(), Fail(),
-	// are provided in order to allow more direct control of the test process
-	///////////////////////////////////////////////////////////////////////////
-	// [TODO] Not implemented - because its not relevant for C++
-	///////////////////////////////////////////////////////////////////////////
-	//static void Ignore(LPCTSTR message, bool throws, LPCSTR file, int line)
-	//
-	//static void Inconclusive(LPCTSTR message, bool throws, LPCSTR file, int line)
-	///////////////////////////////////////////////////////////////////////////
-	static void Pass(LPCTSTR message, bool throws, LPCSTR file, int line)
+	// the object UNITTEST_PROFILE declares in front of every assertion call
+	class Scope
 	{
-		Assert::Pass(message, NULL, throws, file, line);
-	}
+	public:
+		explicit Scope(const Site& site) : m_site(NULL), m_failed(false)
+		{
+			if(!SiteProfile::IsEnabled())
+			{
+				return;
+			}
+			m_site = &site;
+			m_exceptions = std::uncaught_exceptions();
+			m_outer = SiteProfile::Current();
+			SiteProfile::Current() = this;
+			m_start = std::chrono::steady_clock::now();
+		}
+		~Scope()
+		{
+			if(m_site)
+			{
+				SiteProfile::Add(*this);
+			}
+		}
 
- 	static void Fail(LPCTSTR message, bool throws, LPCSTR file, int line)
+	private:
+		Scope(const Scope&);
+		Scope& operator=(const Scope&);
+
+		friend class SiteProfile;
+		const Site*								m_site;		// NULL = not recording
+		bool									m_failed;
+		int										m_exceptions;
+		Scope*									m_outer;
+		std::chrono::steady_clock::time_point	m_start;
+	};
+
+	// called by the failure paths of Assert - marks the open scope of the site on this thread
+	static void Failed(const Site& site)
 	{
-		Assert::Fail(message, NULL, throws, file, line);
+		Scope* scope = SiteProfile::Current();
+		if(scope && scope->m_site == &site)
+		{
+			scope->m_failed = true;
+		}
 	}
 
-	///////////////////////////////////////////////////////////////////////////
-	// StringAssert (NUnit 2.2.3) - The StringAssert class provides a number of methods that are
-	// useful when examining string values
-	///////////////////////////////////////////////////////////////////////////
+	// merges the table of the calling thread (the other threads merge when they exit)
+	static void Collect()
+	{
+		SiteProfile::Merge(SiteProfile::Thread());
+	}
 
-	// Contains for null terminated strings: (LPCTSTR)x2 and (LPTSTR)x2 - with and without a message
-	static void Contains(LPCTSTR expected, LPCTSTR actual, bool throws, LPCSTR file, int line)
+	// clears the tables - a forked worker starts without the entries of its parent
+	static void Reset()
 	{
-		Assert::Contains(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), NULL, throws, file, line);
+		SiteProfile::Thread().Clear();
+		std::lock_guard<std::mutex> guard(SiteProfile::Lock());
+		SiteProfile::Process().Clear();
 	}
-	static void Contains(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+
+	// the merged entries, in no particular order
+	static std::vector<Entry> Entries()
 	{
-		Assert::Contains(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), message, throws, file, line);
+		SiteProfile::Collect();
+		std::lock_guard<std::mutex> guard(SiteProfile::Lock());
+		const Table& table = SiteProfile::Process();
+		std::vector<Entry> entries;
+		for(size_t i = 0; i < table.capacity; ++i)
+		{
+			if(table.slots[i].site)
+			{
+				entries.push_back(table.slots[i]);
+			}
+		}
+		return entries;
+	}
+
+	// the top N sites by hits and by time; returns false if nothing was recorded
+	static bool Report(std::ostream& ostr, size_t top)
+	{
+		std::vector<Entry> entries = SiteProfile::Entries();
+		if(entries.empty())
+		{
+			return false;
+		}
+		unsigned long long hits = 0;
+		unsigned long long nanoseconds = 0;
+		for(size_t i = 0; i < entries.size(); ++i)
+		{
+			hits += entries[i].hits;
+			nanoseconds += entries[i].nanoseconds;
+		}
+		ostr << _T("Assertion sites: ") << entries.size() << _T(" sites, ") << hits << _T(" hits, ")
+			 << nanoseconds / 1e6 << _T(" ms") << std::endl;
+		top = std::min(top, entries.size());
+
+		std::sort(entries.begin(), entries.end(), SiteProfile::ByHits);
+		ostr << _T("Top ") << top << _T(" sites by hits:") << std::endl;
+		SiteProfile::Print(ostr, entries, top);
+
+		std::sort(entries.begin(), entries.end(), SiteProfile::ByTime);
+		ostr << _T("Top ") << top << _T(" sites by time:") << std::endl;
+		SiteProfile::Print(ostr, entries, top);
+		return true;
+	}
+
+#if defined(__linux__)
+	// forked worker: appends the entries of the process (its threads have exited) to 'fd' and clears them
+	static void Export(int fd)
+	{
+		SiteProfile::Collect();
+		std::lock_guard<std::mutex> guard(SiteProfile::Lock());
+		Table& table = SiteProfile::Process();
+		for(size_t i = 0; i < table.capacity; ++i)
+		{
+			if(table.slots[i].site && write(fd, &table.slots[i], sizeof(Entry)) != sizeof(Entry))
+			{
+				break;
+			}
+		}
+		table.Clear();
+	}
+
+	// parent: merges the entries the workers wrote (the sites have the same address after fork)
+	static void Import(int fd)
+	{
+		Table imported;
+		Entry entry;
+		lseek(fd, 0, SEEK_SET);
+		while(read(fd, &entry, sizeof(entry)) == sizeof(entry))
+		{
+			imported.Add(entry);
+		}
+		SiteProfile::Merge(imported);
+	}
+#endif
+
+private:
+	// open addressing on the address of the site; grows at half full
+	struct Table
+	{
+		Entry*	slots;
+		size_t	capacity;	// a power of 2
+		size_t	size;
+
+		Table() : slots(NULL), capacity(0), size(0)	{}
+		~Table()
+		{
+			if(this != &SiteProfile::Process())
+			{	// a thread is exiting
+				SiteProfile::Merge(*this);
+			}
+			free(slots);
+		}
+
+		Entry& Find(const Site* site)
+		{
+			if(2 * (size + 1) > capacity)
+			{
+				Table::Grow();
+			}
+			size_t mask = capacity - 1;
+			size_t i = (reinterpret_cast<uintptr_t>(site) >> 3) * 0x9E3779B97F4A7C15ULL >> 20 & mask;
+			while(slots[i].site != site)
+			{
+				if(!slots[i].site)
+				{
+					slots[i].site = site;
+					++size;
+					break;
+				}
+				i = (i + 1) & mask;
+			}
+			return slots[i];
+		}
+
+		void Add(const Entry& entry)
+		{
+			Entry& slot = Table::Find(entry.site);
+			slot.hits += entry.hits;
+			slot.passed += entry.passed;
+			slot.failed += entry.failed;
+			slot.nanoseconds += entry.nanoseconds;
+		}
+
+		void Grow()
+		{
+			Entry* old = slots;
+			size_t count = capacity;
+			capacity = capacity ? 2 * capacity : 64;
+			slots = static_cast<Entry*>(calloc(capacity, sizeof(Entry)));	// not counted by Allocations
+			size = 0;
+			for(size_t i = 0; i < count; ++i)
+			{
+				if(old[i].site)
+				{
+					Table::Add(old[i]);
+				}
+			}
+			free(old);
+		}
+
+		void Clear()
+		{
+			if(slots)
+			{
+				memset(slots, 0, capacity * sizeof(Entry));
+			}
+			size = 0;
+		}
+	};
+
+	UNITTEST_NOINLINE static void Add(const Scope& scope)
+	{
+		unsigned long long elapsed = static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - scope.m_start).count());
+		SiteProfile::Current() = scope.m_outer;
+		Entry& entry = SiteProfile::Thread().Find(scope.m_site);
+		++entry.hits;
+		if(scope.m_failed)
+		{
+			++entry.failed;
+		}
+		else if(std::uncaught_exceptions() == scope.m_exceptions)
+		{
+			++entry.passed;
+		}
+		entry.nanoseconds += elapsed;
+	}
+
+	static void Merge(Table& table)
+	{
+		std::lock_guard<std::mutex> guard(SiteProfile::Lock());
+		Table& process = SiteProfile::Process();
+		for(size_t i = 0; i < table.capacity; ++i)
+		{
+			if(table.slots[i].site)
+			{
+				process.Add(table.slots[i]);
+			}
+		}
+		table.Clear();
+	}
+
+	static bool ByHits(const Entry& left, const Entry& right)
+	{
+		return left.hits != right.hits ? left.hits > right.hits : left.nanoseconds > right.nanoseconds;
+	}
+	static bool ByTime(const Entry& left, const Entry& right)
+	{
+		return left.nanoseconds != right.nanoseconds ? left.nanoseconds > right.nanoseconds : left.hits > right.hits;
+	}
+
+	static void Print(std::ostream& ostr, const std::vector<Entry>& entries, size_t top)
+	{
+		char line[128];
+		snprintf(line, sizeof(line), "%12s %10s %8s %12s %10s  %s", "hits", "passed", "failed", "total ms", "ns/hit", "site");
+		ostr << line << std::endl;
+		for(size_t i = 0; i < top; ++i)
+		{
+			const Entry& entry = entries[i];
+			snprintf(line, sizeof(line), "%12llu %10llu %8llu %12.3f %10.1f  ", entry.hits, entry.passed, entry.failed,
+					 entry.nanoseconds / 1e6, static_cast<double>(entry.nanoseconds) / entry.hits);
+			ostr << line << entry.site->file << _T(" (") << entry.site->line << _T(")");
+			if(entry.site->text)
+			{
+				ostr << _T(": ") << entry.site->text;
+			}
+			ostr << std::endl;
+		}
+	}
+
+	static bool& Enabled()
+	{
+		static bool enabled = false;
+		return enabled;
+	}
+	static Scope*& Current()
+	{
+		static thread_local Scope* current = NULL;	// the innermost open scope of this thread
+		return current;
+	}
+	static Table& Thread()
+	{
+		static thread_local Table table;	// merged by its destructor when the thread exits
+		return table;
+	}
+	static Table& Process()
+	{
+		static Table table;
+		return table;
+	}
+	static std::mutex& Lock()
+	{
+		static std::mutex lock;
+		return lock;
+	}
+};	// SiteProfile
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Record - one entry of the report stream
+///////////////////////////////////////////////////////////////////////////////
+struct Record
+{
+	enum Kind { Assertion = 0, Message = 1, CaseEnd = 2 };
+
+	Kind				kind;
+	bool				passed;
+	LPCTSTR				message1;	// passed assertion - the writer formats the free text messages
+	LPCTSTR				message2;
+	LPCSTR				file;
+	int					line;
+	unsigned long long	site;		// assertion - Site::id
+	LPCTSTR				expression;	// assertion - Site::text (a literal or NULL)
+	std::string			text;		// failed assertion - the formatted failure; message - the text
+	const TestCase*		test;		// the running case, NULL outside the Runner
+	const CaseResult*	result;		// case end only
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class ReportWriter - the interface of the report outputs
+// The Reporter calls the writers from one thread at a time (the reporter
+// thread in async mode), so a writer needs no locking of its own. The records
+// of a case always come before the CaseEnd record of the case.
+///////////////////////////////////////////////////////////////////////////////
+class ReportWriter
+{
+public:
+	virtual ~ReportWriter() {}
+	virtual void Write(const Record& record) = 0;
+	virtual void Flush() {}								// end of a batch of records
+	virtual void Close(const RunSummary& /*summary*/) {}	// end of the run
+
+	// one line of the case metrics - shared by the console and the JUnit output
+	static std::string FormatMetrics(const CaseMetrics& metrics)
+	{
+		const Resources::Usage& resources = metrics.resources;
+		std::ostringstream ostr;
+		ostr << _T("cpu ") << resources.userTime << _T(" ms user ") << resources.systemTime
+			 << _T(" ms system, rss ") << (resources.rss >= 0 ? _T("+") : _T("")) << resources.rss / 1024
+			 << _T(" KB, ") << resources.voluntarySwitches + resources.involuntarySwitches << _T(" context switches");
+		ostr << PerfCounters::Format(metrics.counters, 1);
+		if(Allocations::IsTracking())
+		{
+			const Allocations::Counters& allocations = metrics.allocations;
+			ostr << _T(", ") << allocations.calls << _T(" allocations (") << allocations.bytes
+				 << _T(" bytes, peak ") << allocations.peak << _T(" bytes), ")
+				 << allocations.current << _T(" bytes leaked");
+		}
+		return ostr.str();
+	}
+};	// ReportWriter
+
+///////////////////////////////////////////////////////////////////////////////
+// class Console - the platform layer of the console output
+// The colors are decided once: the ANSI escapes go to a terminal unless
+// NO_COLOR is set (https://no-color.org), never to a pipe or a file. Write
+// hands a whole buffer to the descriptor, so a record costs one write() and
+// the color is part of the text instead of a console call around it.
+///////////////////////////////////////////////////////////////////////////////
+class Console
+{
+public:
+	enum Stream { Output = 1, Error = 2 };	// the descriptors of stdout and stderr
+
+	static bool IsTerminal(Stream stream)
+	{
+		static const bool terminals[] = { false, Console::Terminal(Output), Console::Terminal(Error) };
+		return terminals[stream];
+	}
+	static bool IsColored(Stream stream)
+	{
+		static const bool colored = Console::Colors();
+		return colored && Console::IsTerminal(stream);
+	}
+
+	static void Write(Stream stream, const char* data, size_t size)
+	{
+		while(size > 0)
+		{
+#if defined(_WIN32)
+			const int written = _write(stream, data, static_cast<unsigned>(size < 0x40000000 ? size : 0x40000000));
+#else
+			const ssize_t written = write(stream, data, size);
+			if(written < 0 && errno == EINTR)
+			{
+				continue;
+			}
+#endif
+			if(written <= 0)
+			{	// the stream was closed - nothing more to do about it
+				return;
+			}
+			data += written;
+			size -= static_cast<size_t>(written);
+		}
+	}
+
+private:
+	static bool Terminal(Stream stream)
+	{
+#if defined(_WIN32)
+		return _isatty(stream) != 0;
+#else
+		return isatty(stream) != 0;
+#endif
+	}
+	static bool Colors()
+	{
+		const char* noColor = getenv("NO_COLOR");
+		if(noColor && *noColor)
+		{
+			return false;
+		}
+#if defined(_WIN32)
+		// the console interprets the escapes only when asked to (Windows 10 and later)
+		const DWORD handles[] = { STD_OUTPUT_HANDLE, STD_ERROR_HANDLE };
+		for(size_t i = 0; i < 2; ++i)
+		{
+			HANDLE handle = GetStdHandle(handles[i]);
+			DWORD mode = 0;
+			if(GetConsoleMode(handle, &mode) && !SetConsoleMode(handle, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING))
+			{
+				return false;
+			}
+		}
+#endif
+		return true;
+	}
+};	// Console
+
+///////////////////////////////////////////////////////////////////////////////
+// class ConsoleWriter - the colored [PASS] / [FAIL] console output (always installed)
+// Each record is assembled with its colors into one buffer. A terminal gets
+// it at once; a pipe or a file gets the records of a batch in one write()
+// when the reporter flushes (or when 64 KB are pending).
+///////////////////////////////////////////////////////////////////////////////
+class ConsoleWriter : public ReportWriter
+{
+public:
+	ConsoleWriter() : m_stream(Console::Output) {}
+
+	virtual void Write(const Record& record)
+	{
+		if(record.kind == Record::CaseEnd)
+		{	// the cases are listed by Runner::Summary
+			return;
+		}
+		Allocations::Ignore ignore;	// sync mode writes on the thread of the case
+		const Console::Stream stream = record.passed ? Console::Output : Console::Error;
+		if(stream != m_stream)
+		{	// keeps the order of the records when both streams go to the same file
+			this->Emit();
+			m_stream = stream;
+		}
+		const bool colored = Console::IsColored(stream);
+		if(record.passed)
+		{
+			m_buffer += colored ? _T("\x1b[92m[PASS]\x1b[0m ") : _T("[PASS] ");
+			if(record.message1)
+			{
+				m_buffer += record.message1;
+			}
+			else
+			{
+				m_buffer += record.text;
+			}
+			m_buffer += _T(' ');
+			if(record.message2)
+			{
+				m_buffer += record.message2;
+				m_buffer += _T(' ');
+			}
+			m_buffer += _T("at ");
+			m_buffer += record.file;
+			m_buffer += _T(" (");
+			char line[16];
+			m_buffer.append(line, std::to_chars(line, line + sizeof(line), record.line).ptr - line);
+			m_buffer += _T(")\n");
+		}
+		else
+		{
+			if(colored)
+			{
+				m_buffer += _T("\x1b[91m");
+			}
+			if(record.kind == Record::Assertion)
+			{	// the other writers get the failure text without the console decoration
+				m_buffer += _T("[FAIL]");
+			}
+			m_buffer += record.text;
+			m_buffer += colored ? _T("\x1b[0m\n") : _T("\n");
+		}
+		if(Console::IsTerminal(stream) || m_buffer.size() >= Pending)
+		{
+			this->Emit();
+		}
+	}
+
+	virtual void Flush()
+	{
+		this->Emit();
+	}
+
+private:
+	static const size_t Pending = 64 * 1024;
+
+	void Emit()
+	{
+		if(m_buffer.empty())
+		{
+			return;
+		}
+		std::cout.flush();	// the text streamed to std::cout by the cases comes first
+		Console::Write(m_stream, m_buffer.data(), m_buffer.size());
+		m_buffer.clear();
+	}
+
+	Console::Stream	m_stream;	// the stream of the pending records
+	std::string		m_buffer;
+};	// ConsoleWriter
+
+///////////////////////////////////////////////////////////////////////////////
+// class Reporter - asynchronous PASS/FAIL output
+// The producers (any thread calling TEST_XXX) claim a cell of a bounded MPSC
+// ring with a single CAS; the reporter thread drains the ring in batches and
+// hands every record to the installed writers, which flush once per batch. A
+// full ring makes the producer back off until the reporter catches up, so no
+// record is ever dropped.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef UNITTEST_REPORTER_CAPACITY
+#define UNITTEST_REPORTER_CAPACITY	4096	// must be a power of 2
+#endif
+
+class Reporter
+{
+public:
+	static void SetAsync(bool async)
+	{
+		if(!async)
+		{	// the records which were already posted are printed before going back to sync mode
+			Reporter::Flush();
+		}
+		Reporter::Async().store(async, std::memory_order_relaxed);
+	}
+	static bool IsAsync()
+	{
+		return Reporter::Async().load(std::memory_order_relaxed);
+	}
+
+	// the writer is owned by the caller and must stay alive until RemoveWriter
+	static void AddWriter(ReportWriter* writer)
+	{
+		Reporter::Flush();
+		std::lock_guard<std::mutex> guard(Reporter::Lock());
+		Reporter::Writers().push_back(writer);
+	}
+	static void RemoveWriter(ReportWriter* writer)
+	{
+		Reporter::Flush();
+		std::lock_guard<std::mutex> guard(Reporter::Lock());
+		std::vector<ReportWriter*>& writers = Reporter::Writers();
+		writers.erase(std::remove(writers.begin(), writers.end(), writer), writers.end());
+	}
+	// a forked worker keeps only the console - the parent reports its results
+	static void ConsoleOnly()
+	{
+		std::lock_guard<std::mutex> guard(Reporter::Lock());
+		Reporter::Writers().resize(1);
+	}
+
+	// the case which the calling thread runs (set by the Runner)
+	static void SetCase(const TestCase* test)
+	{
+		Reporter::Current() = test;
+	}
+
+	static void Pass(LPCTSTR message1, LPCTSTR message2, const Site& site)
+	{
+		Record record = { Record::Assertion, true, message1, message2, site.file, site.line, site.Id(), site.text,
+						  std::string(), Reporter::Current(), NULL };
+		Reporter::Post(record);
+	}
+	static void Fail(const std::string& text, const Site& site)
+	{
+		Record record = { Record::Assertion, false, NULL, NULL, site.file, site.line, site.Id(), site.text,
+						  text, Reporter::Current(), NULL };
+		Reporter::Post(record);
+	}
+
+	// a record with its own text (benchmark results) - printed even in quiet mode
+	static void Write(bool passed, const std::string& text, LPCSTR file, int line)
+	{
+		Record record = { Record::Message, passed, NULL, NULL, file, line, 0, NULL, text, Reporter::Current(), NULL };
+		Reporter::Post(record);
+	}
+
+	// the result must stay valid until the run is closed
+	static void CaseEnd(const TestCase& test, const CaseResult& result)
+	{
+		Record record = { Record::CaseEnd, result.counters.failed == 0 && !result.aborted, NULL, NULL,
+						  test.file, test.line, 0, NULL, std::string(), &test, &result };
+		Reporter::Post(record);
+	}
+
+	// end of the run - every writer writes its trailer
+	static void Close(const RunSummary& summary)
+	{
+		Reporter::Flush();
+		std::lock_guard<std::mutex> guard(Reporter::Lock());
+		std::vector<ReportWriter*>& writers = Reporter::Writers();
+		for(size_t i = 0; i < writers.size(); ++i)
+		{
+			writers[i]->Close(summary);
+		}
+	}
+
+	// false if the writers stay locked for 'milliseconds' - by a thread which hangs inside a writer
+	static bool Available(int milliseconds)
+	{
+		std::unique_lock<std::mutex> probe(Reporter::Lock(), std::defer_lock);
+		for(int waited = 0; !probe.try_lock(); waited += 10)
+		{
+			if(waited >= milliseconds)
+			{
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		}
+		return true;
+	}
+
+	// end of a run which cannot finish (Runner::Expired) - the writers write their trailers and
+	// only the console is kept for whatever the cases which are still running post
+	static void Abort(const RunSummary& summary)
+	{
+		Reporter::Flush();
+		std::lock_guard<std::mutex> guard(Reporter::Lock());
+		std::vector<ReportWriter*>& writers = Reporter::Writers();
+		for(size_t i = 0; i < writers.size(); ++i)
+		{
+			writers[i]->Close(summary);
+		}
+		writers.resize(1);
+	}
+
+	// wait until every record posted so far was written
+	static void Flush()
+	{
+		if(Reporter::Started().load(std::memory_order_acquire))
+		{	// nothing to wait for if the reporter thread was never started
+			Reporter::Instance().WaitDrained();
+		}
+	}
+
+private:
+	enum { Capacity = UNITTEST_REPORTER_CAPACITY, Mask = Capacity - 1, Batch = 256 };
+
+	struct Cell
+	{
+		std::atomic<size_t>	sequence;
+		Record				record;
+	};
+
+	class Ring
+	{
+	public:
+		Ring() : m_cells(new Cell[Capacity]), m_enqueue(0), m_dequeue(0), m_drained(0), m_stop(false)
+		{
+			for(size_t i = 0; i < Capacity; ++i)
+			{
+				m_cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+			m_thread = std::thread(&Ring::Run, this);
+		}
+
+		~Ring()
+		{	// called at exit - print everything which is still in the ring
+			m_stop.store(true, std::memory_order_release);
+			m_thread.join();
+		}
+
+		void Push(Record& record)
+		{
+			size_t pos = m_enqueue.load(std::memory_order_relaxed);
+			unsigned spins = 0;
+			for(;;)
+			{
+				Cell& cell = m_cells[pos & Mask];
+				size_t sequence = cell.sequence.load(std::memory_order_acquire);
+				ptrdiff_t diff = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(pos);
+				if(diff == 0)
+				{
+					if(m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						cell.record = std::move(record);
+						cell.sequence.store(pos + 1, std::memory_order_release);
+						return;
+					}
+				}
+				else if(diff < 0)
+				{	// the ring is full - wait for the reporter thread
+					Backoff(spins++);
+					pos = m_enqueue.load(std::memory_order_relaxed);
+				}
+				else
+				{
+					pos = m_enqueue.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		void WaitDrained()
+		{
+			size_t target = m_enqueue.load(std::memory_order_acquire);
+			unsigned spins = 0;
+			while(m_drained.load(std::memory_order_acquire) < target)
+			{
+				Backoff(spins++);
+			}
+		}
+
+	private:
+		static void Backoff(unsigned spins)
+		{
+			if(spins < 64)
+			{
+				std::this_thread::yield();
+			}
+			else
+			{
+				std::this_thread::sleep_for(std::chrono::microseconds(spins < 1024 ? 50 : 1000));
+			}
+		}
+
+		// single consumer - the only thread which touches m_dequeue
+		size_t Drain()
+		{
+			size_t count = 0;
+			std::lock_guard<std::mutex> guard(Reporter::Lock());
+			while(count < Batch)
+			{
+				Cell& cell = m_cells[m_dequeue & Mask];
+				if(cell.sequence.load(std::memory_order_acquire) != m_dequeue + 1)
+				{
+					break;	// empty (or the producer did not publish the cell yet)
+				}
+				Reporter::Dispatch(cell.record);
+				cell.record.text.clear();
+				cell.sequence.store(m_dequeue + Capacity, std::memory_order_release);
+				++m_dequeue;
+				++count;
+			}
+			if(count)
+			{	// one flush per batch
+				Reporter::FlushWriters();
+				m_drained.store(m_dequeue, std::memory_order_release);
+			}
+			return count;
+		}
+
+		void Run()
+		{
+			unsigned idle = 0;
+			for(;;)
+			{
+				if(Drain())
+				{
+					idle = 0;
+				}
+				else if(m_stop.load(std::memory_order_acquire) &&
+						m_dequeue == m_enqueue.load(std::memory_order_acquire))
+				{
+					return;
+				}
+				else
+				{
+					Backoff(idle++);
+				}
+			}
+		}
+
+		std::unique_ptr<Cell[]>	m_cells;
+		std::atomic<size_t>		m_enqueue;
+		size_t					m_dequeue;
+		std::atomic<size_t>		m_drained;
+		std::atomic<bool>		m_stop;
+		std::thread				m_thread;
+	};
+
+	static void Post(Record& record)
+	{
+		if(Reporter::IsAsync())
+		{
+			Reporter::Instance().Push(record);
+			return;
+		}
+		std::lock_guard<std::mutex> guard(Reporter::Lock());
+		Reporter::Dispatch(record);
+		Reporter::FlushWriters();	// sync mode writes every record through, as std::endl did
+	}
+
+	// called with Lock() held
+	static void Dispatch(const Record& record)
+	{
+		std::vector<ReportWriter*>& writers = Reporter::Writers();
+		for(size_t i = 0; i < writers.size(); ++i)
+		{
+			writers[i]->Write(record);
+		}
+	}
+	static void FlushWriters()
+	{
+		std::vector<ReportWriter*>& writers = Reporter::Writers();
+		for(size_t i = 0; i < writers.size(); ++i)
+		{
+			writers[i]->Flush();
+		}
+	}
+
+	static std::vector<ReportWriter*>& Writers()
+	{
+		static ConsoleWriter console;
+		static std::vector<ReportWriter*> writers(1, &console);
+		return writers;
+	}
+	static std::mutex& Lock()
+	{
+		static std::mutex lock;
+		return lock;
+	}
+	static const TestCase*& Current()
+	{
+		static thread_local const TestCase* test = NULL;
+		return test;
+	}
+
+	static std::atomic<bool>& Async()
+	{
+#ifdef UNITTEST_ASYNC
+		static std::atomic<bool> async(true);
+#else
+		static std::atomic<bool> async(false);
+#endif
+		return async;
+	}
+
+	// the reporter thread is started on first use and joined by the static destructor at exit;
+	// the lock and the writers are built first so that they outlive the ring's final drain
+	static Ring& Instance()
+	{
+		Reporter::Lock();
+		Reporter::Writers();
+		static Ring ring;
+		Reporter::Started().store(true, std::memory_order_release);
+		return ring;
+	}
+	static std::atomic<bool>& Started()
+	{
+		static std::atomic<bool> started(false);
+		return started;
+	}
+};	// Reporter
+
+///////////////////////////////////////////////////////////////////////////////
+// class JUnitWriter - streaming JUnit XML (--junit FILE)
+// Each <testcase> element is written when its case ends; only the failure
+// texts of the running cases are kept. The <testsuite> totals are written as
+// fixed width placeholders and patched in place when the run is closed.
+///////////////////////////////////////////////////////////////////////////////
+class JUnitWriter : public ReportWriter
+{
+public:
+	static JUnitWriter* Open(LPCSTR path)
+	{
+		FILE* file = fopen(path, "w");
+		return file ? new JUnitWriter(file) : NULL;
+	}
+
+	virtual ~JUnitWriter()
+	{
+		if(m_file)
+		{
+			fclose(m_file);
+		}
+	}
+
+	virtual void Write(const Record& record)
+	{
+		if(record.kind == Record::CaseEnd)
+		{
+			WriteCase(*record.test, *record.result);
+			m_failures.erase(record.test);
+		}
+		else if(!record.passed && record.test)
+		{	// kept until the case ends
+			std::string& failures = m_failures[record.test];
+			failures += record.text;
+			failures += '\n';
+		}
+	}
+
+	virtual void Flush()
+	{
+		fflush(m_file);
+	}
+
+	virtual void Close(const RunSummary& summary)
+	{
+		fputs("</testsuite>\n</testsuites>\n", m_file);
+		if(fseek(m_file, m_header, SEEK_SET) == 0)
+		{	// same width as the placeholders
+			WriteHeader(summary.cases, summary.failedCases, summary.seconds);
+		}
+		fclose(m_file);
+		m_file = NULL;
+	}
+
+private:
+	explicit JUnitWriter(FILE* file) : m_file(file)
+	{
+		fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites>\n", m_file);
+		m_header = ftell(m_file);
+		WriteHeader(0, 0, 0);
+	}
+
+	void WriteHeader(size_t cases, size_t failures, double seconds)
+	{
+		fprintf(m_file, "<testsuite name=\"UnitTest\" tests=\"%010lu\" failures=\"%010lu\" errors=\"0\" time=\"%014.6f\">\n",
+				static_cast<unsigned long>(cases), static_cast<unsigned long>(failures), seconds);
+	}
+
+	void WriteCase(const TestCase& test, const CaseResult& result)
+	{
+		fprintf(m_file, "  <testcase classname=\"%s\" name=\"%s\" file=\"%s\" line=\"%d\" time=\"%.6f\">\n",
+				Escape(test.suite).c_str(), Escape(test.name).c_str(), Escape(test.file).c_str(), test.line, result.seconds);
+		if(result.counters.failed || result.aborted)
+		{
+			std::map<const TestCase*, std::string>::const_iterator found = m_failures.find(&test);
+			std::string text = (found != m_failures.end()) ? found->second : std::string();
+			if(result.aborted)
+			{
+				text += result.error;
+			}
+			else if(text.empty())
+			{	// the failure texts of a forked worker stay on its console
+				std::ostringstream ostr;
+				ostr << result.counters.failed << _T(" assertions failed");
+				text = ostr.str();
+			}
+			const std::string& reason = result.aborted ? result.error : text;
+			std::string message = reason.substr(0, reason.find('\n'));	// the first line
+			fprintf(m_file, "    <failure message=\"%s\">%s</failure>\n", Escape(message).c_str(), Escape(text).c_str());
+		}
+		fprintf(m_file, "    <system-out>%s</system-out>\n  </testcase>\n", Escape(FormatMetrics(result.metrics)).c_str());
+	}
+
+	static std::string Escape(const std::string& text)
+	{
+		std::string escaped;
+		escaped.reserve(text.size());
+		for(size_t i = 0; i < text.size(); ++i)
+		{
+			char c = text[i];
+			switch(c)
+			{
+			case '&':	escaped += "&amp;";		break;
+			case '<':	escaped += "&lt;";		break;
+			case '>':	escaped += "&gt;";		break;
+			case '"':	escaped += "&quot;";	break;
+			case '\'':	escaped += "&apos;";	break;
+			default:
+				if(static_cast<unsigned char>(c) >= 0x20 || c == '\t' || c == '\n' || c == '\r')
+				{	// the other control characters are not allowed in XML 1.0
+					escaped += c;
+				}
+			}
+		}
+		return escaped;
+	}
+
+	FILE*									m_file;
+	long									m_header;	// offset of the <testsuite> element
+	std::map<const TestCase*, std::string>	m_failures;	// failure texts of the running cases
+};	// JUnitWriter
+
+///////////////////////////////////////////////////////////////////////////////
+// class JsonLinesWriter - one JSON object per line (--jsonl FILE)
+// {"type":"assertion"|"message"|"case"|"summary", ...} - flushed per batch, so
+// the file can be followed while the run is in progress. An assertion has the
+// "site" id and the "expression" text of its macro.
+///////////////////////////////////////////////////////////////////////////////
+class JsonLinesWriter : public ReportWriter
+{
+public:
+	static JsonLinesWriter* Open(LPCSTR path)
+	{
+		FILE* file = fopen(path, "w");
+		return file ? new JsonLinesWriter(file) : NULL;
+	}
+
+	virtual ~JsonLinesWriter()
+	{
+		if(m_file)
+		{
+			fclose(m_file);
+		}
+	}
+
+	virtual void Write(const Record& record)
+	{
+		m_line.clear();
+		if(record.kind == Record::CaseEnd)
+		{
+			WriteCase(*record.test, *record.result);
+		}
+		else
+		{
+			m_line += record.kind == Record::Assertion ? "{\"type\":\"assertion\"" : "{\"type\":\"message\"";
+			if(record.test)
+			{
+				m_line += ",\"case\":";
+				AppendName(*record.test);
+			}
+			m_line += record.passed ? ",\"passed\":true" : ",\"passed\":false";
+			m_line += ",\"file\":";
+			AppendString(record.file);
+			AppendNumber(",\"line\":", record.line);
+			if(record.kind == Record::Assertion)
+			{
+				char site[32];
+				snprintf(site, sizeof(site), ",\"site\":\"%016llx\"", record.site);
+				m_line += site;
+				if(record.expression)
+				{
+					m_line += ",\"expression\":";
+					AppendString(record.expression);
+				}
+			}
+			m_line += ",\"message\":";
+			if(record.message1)
+			{
+				std::string message = record.message1;
+				if(record.message2)
+				{
+					message += ' ';
+					message += record.message2;
+				}
+				AppendString(message);
+			}
+			else
+			{
+				AppendString(record.text);
+			}
+			m_line += "}\n";
+		}
+		fwrite(m_line.data(), 1, m_line.size(), m_file);
+	}
+
+	virtual void Flush()
+	{
+		fflush(m_file);
+	}
+
+	virtual void Close(const RunSummary& summary)
+	{
+		fprintf(m_file, "{\"type\":\"summary\",\"cases\":%lu,\"failed_cases\":%lu,\"passed\":%lu,\"failed\":%lu,\"seconds\":%.6f}\n",
+				static_cast<unsigned long>(summary.cases), static_cast<unsigned long>(summary.failedCases),
+				summary.passed, summary.failed, summary.seconds);
+		fclose(m_file);
+		m_file = NULL;
+	}
+
+private:
+	explicit JsonLinesWriter(FILE* file) : m_file(file)
+	{
+	}
+
+	void WriteCase(const TestCase& test, const CaseResult& result)
+	{
+		const CaseMetrics& metrics = result.metrics;
+		m_line += "{\"type\":\"case\",\"case\":";
+		AppendName(test);
+		m_line += ",\"file\":";
+		AppendString(test.file);
+		AppendNumber(",\"line\":", test.line);
+		m_line += (result.counters.failed || result.aborted) ? ",\"passed\":false" : ",\"passed\":true";
+		AppendNumber(",\"assertions_passed\":", result.counters.passed.load(std::memory_order_relaxed));
+		AppendNumber(",\"assertions_failed\":", result.counters.failed.load(std::memory_order_relaxed));
+		m_line += result.aborted ? ",\"aborted\":true,\"error\":" : ",\"aborted\":false,\"error\":";
+		AppendString(result.error);
+		AppendNumber(",\"seconds\":", result.seconds);
+		AppendNumber(",\"user_ms\":", metrics.resources.userTime);
+		AppendNumber(",\"system_ms\":", metrics.resources.systemTime);
+		AppendNumber(",\"rss_delta\":", metrics.resources.rss);
+		AppendNumber(",\"voluntary_switches\":", metrics.resources.voluntarySwitches);
+		AppendNumber(",\"involuntary_switches\":", metrics.resources.involuntarySwitches);
+		if(Allocations::IsTracking())
+		{
+			AppendNumber(",\"allocations\":", metrics.allocations.calls);
+			AppendNumber(",\"allocated_bytes\":", metrics.allocations.bytes);
+			AppendNumber(",\"peak_bytes\":", metrics.allocations.peak);
+			AppendNumber(",\"leaked_bytes\":", metrics.allocations.current);
+		}
+		for(unsigned i = 0; i < PerfCounters::Count; ++i)
+		{
+			if(metrics.counters.available & (1u << i))
+			{
+				m_line += ",\"";
+				m_line += PerfCounters::Name(i);
+				AppendNumber("\":", metrics.counters.value[i]);
+			}
+		}
+		m_line += "}\n";
+	}
+
+	template <class T>
+	void AppendNumber(LPCSTR key, T value)
+	{
+		std::ostringstream ostr;
+		ostr << key << value;
+		m_line += ostr.str();
+	}
+
+	void AppendName(const TestCase& test)
+	{
+		std::string name = test.suite;
+		name += '.';
+		name += test.name;
+		AppendString(name);
+	}
+
+	void AppendString(const std::string& text)
+	{
+		m_line += '"';
+		for(size_t i = 0; i < text.size(); ++i)
+		{
+			unsigned char c = static_cast<unsigned char>(text[i]);
+			switch(c)
+			{
+			case '"':	m_line += "\\\"";	break;
+			case '\\':	m_line += "\\\\";	break;
+			case '\n':	m_line += "\\n";	break;
+			case '\r':	m_line += "\\r";	break;
+			case '\t':	m_line += "\\t";	break;
+			default:
+				if(c < 0x20)
+				{
+					char escaped[8];
+					snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+					m_line += escaped;
+				}
+				else
+				{
+					m_line += static_cast<char>(c);
+				}
+			}
+		}
+		m_line += '"';
+	}
+
+	FILE*		m_file;
+	std::string	m_line;		// reused - one allocation for the whole run
+};	// JsonLinesWriter
+
+///////////////////////////////////////////////////////////////////////////////
+// class Mapping - a whole file, read only: mapped on Linux, read into memory
+// elsewhere. Shared by the BinaryLog reader and the ResultCache.
+///////////////////////////////////////////////////////////////////////////////
+class Mapping
+{
+public:
+	explicit Mapping(LPCSTR path) : m_data(NULL), m_size(0)
+	{
+#if defined(__linux__)
+		int fd = open(path, O_RDONLY);
+		if(fd < 0)
+		{
+			return;
+		}
+		off_t size = lseek(fd, 0, SEEK_END);
+		if(size > 0)
+		{
+			void* data = mmap(NULL, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, fd, 0);
+			if(data != MAP_FAILED)
+			{
+				madvise(data, static_cast<size_t>(size), MADV_SEQUENTIAL);
+				m_data = static_cast<const char*>(data);
+				m_size = static_cast<size_t>(size);
+			}
+		}
+		close(fd);
+#else
+		std::ifstream file(path, std::ios::binary);
+		m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		m_data = m_buffer.empty() ? NULL : &m_buffer[0];
+		m_size = m_buffer.size();
+#endif
+	}
+	~Mapping()
+	{
+#if defined(__linux__)
+		if(m_data)
+		{
+			munmap(const_cast<char*>(m_data), m_size);
+		}
+#endif
+	}
+	const char* Data() const { return m_data; }
+	size_t Size() const { return m_size; }
+
+private:
+	Mapping(const Mapping&);
+	Mapping& operator=(const Mapping&);
+
+	const char*			m_data;
+	size_t				m_size;
+#if !defined(__linux__)
+	std::vector<char>	m_buffer;
+#endif
+};	// Mapping
+
+///////////////////////////////////////////////////////////////////////////////
+// class BinaryLog - compact result log (--binary-log FILE) and its reader
+// Layout: a Header, Header::records fixed size Entry records, then the string
+// table: Header::strings offsets (64 bit, relative to the table) followed by
+// the NUL terminated strings. String id 0 is the empty string. Literals
+// (messages, file names) are interned by address and the other texts by
+// content, so the log of a million passing assertions is about 48 MB of
+// records plus a few strings. Summarize() maps the file and walks the records;
+// the log is read on the machine which wrote it, so the raw host layout is kept.
+// The passes are not logged in quiet mode and an assertion which throws is
+// logged only through the error of its case, so Summarize() takes the totals
+// of a case from its CaseEnd record and counts only the assertion records made
+// outside the cases.
+///////////////////////////////////////////////////////////////////////////////
+class BinaryLog : public ReportWriter
+{
+public:
+	struct Header
+	{
+		char				magic[8];		// "UTLOG01"
+		unsigned			recordSize;		// sizeof(Entry)
+		unsigned			reserved;
+		unsigned long long	records;
+		unsigned long long	table;			// file offset of the string table
+		unsigned long long	strings;		// entries of the string table
+		unsigned long long	cases;			// RunSummary
+		unsigned long long	failedCases;
+		double				seconds;
+	};
+
+	struct Entry
+	{
+		unsigned char		kind;			// Record::Kind
+		unsigned char		passed;
+		unsigned short		reserved;
+		unsigned			line;
+		unsigned			file;			// string ids
+		unsigned			text;			// message1 / failure / message text / case error
+		unsigned			detail;			// message2
+		unsigned			test;			// "suite.name" of the case
+		unsigned			failed;			// case end: failed assertions
+		unsigned			aborted;		// case end
+		unsigned long long	value;			// case end: passed assertions, assertion: Site::id
+		double				seconds;		// case end
+	};
+
+	static BinaryLog* Open(LPCSTR path)
+	{
+		FILE* file = fopen(path, "wb");
+		return file ? new BinaryLog(file) : NULL;
+	}
+
+	virtual ~BinaryLog()
+	{
+		if(m_file)
+		{
+			fclose(m_file);
+		}
+	}
+
+	virtual void Write(const Record& record)
+	{
+		Entry entry;
+		memset(&entry, 0, sizeof(entry));
+		entry.kind = static_cast<unsigned char>(record.kind);
+		entry.passed = record.passed ? 1 : 0;
+		entry.line = static_cast<unsigned>(record.line);
+		entry.file = Intern(record.file);
+		entry.test = record.test ? Intern(*record.test) : 0;
+		if(record.kind == Record::CaseEnd)
+		{
+			entry.text = Intern(record.result->error);
+			entry.failed = static_cast<unsigned>(record.result->counters.failed);
+			entry.aborted = record.result->aborted ? 1 : 0;
+			entry.value = record.result->counters.passed;
+			entry.seconds = record.result->seconds;
+		}
+		else if(record.message1)
+		{
+			entry.value = record.site;
+			entry.text = Intern(record.message1);
+			entry.detail = Intern(record.message2);
+		}
+		else
+		{
+			entry.value = record.site;
+			entry.text = Intern(record.text);
+		}
+		fwrite(&entry, sizeof(entry), 1, m_file);
+		++m_header.records;
+	}
+
+	virtual void Flush()
+	{
+		fflush(m_file);
+	}
+
+	virtual void Close(const RunSummary& summary)
+	{
+		m_header.table = sizeof(Header) + m_header.records * sizeof(Entry);
+		m_header.strings = m_offsets.size();
+		m_header.cases = summary.cases;
+		m_header.failedCases = summary.failedCases;
+		m_header.seconds = summary.seconds;
+		fwrite(&m_offsets[0], sizeof(unsigned long long), m_offsets.size(), m_file);
+		fwrite(m_blob.data(), 1, m_blob.size(), m_file);
+		if(fseek(m_file, 0, SEEK_SET) == 0)
+		{
+			fwrite(&m_header, sizeof(m_header), 1, m_file);
+		}
+		fclose(m_file);
+		m_file = NULL;
+	}
+
+	// prints the totals and the failures of a log, returns 1 if it has failures (2 if unreadable)
+	static int Summarize(LPCSTR path)
+	{
+		Mapping mapping(path);
+		const char* data = mapping.Data();
+		size_t size = mapping.Size();
+		const Header* header = reinterpret_cast<const Header*>(data);
+		if(!data || size < sizeof(Header) || memcmp(header->magic, "UTLOG01", 8) != 0 ||
+		   header->recordSize != sizeof(Entry) || header->records > size / sizeof(Entry) ||
+		   header->table != sizeof(Header) + header->records * sizeof(Entry) || header->table > size ||
+		   (size - header->table) / sizeof(unsigned long long) < header->strings)
+		{
+			std::cerr << _T("Not a complete UnitTest log: ") << path << std::endl;
+			return 2;
+		}
+		const Entry* entries = reinterpret_cast<const Entry*>(data + sizeof(Header));
+		const unsigned long long* offsets = reinterpret_cast<const unsigned long long*>(data + header->table);
+		const char* strings = reinterpret_cast<const char*>(offsets + header->strings);
+		size_t stringsSize = size - (strings - data);
+
+		unsigned long long passed = 0, failed = 0, messages = 0, cases = 0, failedCases = 0;
+		for(unsigned long long i = 0; i < header->records; ++i)
+		{
+			const Entry& entry = entries[i];
+			if(entry.kind == Record::Assertion)
+			{
+				if(!entry.test)
+				{	// outside the Runner - no CaseEnd counts it
+					++(entry.passed ? passed : failed);
+				}
+			}
+			else if(entry.kind == Record::Message)
+			{
+				++messages;
+			}
+			else if(entry.kind == Record::CaseEnd)
+			{
+				++cases;
+				passed += entry.value;
+				failed += entry.failed;
+				if(!entry.passed)
+				{
+					++failedCases;
+					std::cerr << _T("[FAIL] ") << String(offsets, header->strings, strings, stringsSize, entry.test)
+							  << _T(" (") << entry.failed << _T(" failed)");
+					if(entry.aborted)
+					{
+						std::cerr << _T(": ") << String(offsets, header->strings, strings, stringsSize, entry.text);
+					}
+					std::cerr << std::endl << _T("at ") << String(offsets, header->strings, strings, stringsSize, entry.file)
+							  << _T(" (") << entry.line << _T(")") << std::endl;
+				}
+			}
+		}
+		std::cout << _T("Records: ") << header->records << _T(", ") << header->strings << _T(" strings") << std::endl
+				  << _T("Test cases: ") << cases - failedCases << _T(" passed, ") << failedCases << _T(" failed") << std::endl
+				  << _T("Assertions: ") << passed << _T(" passed, ") << failed << _T(" failed") << std::endl
+				  << _T("Messages: ") << messages << std::endl
+				  << _T("Time: ") << header->seconds << _T(" s") << std::endl;
+		return (failedCases || failed) ? 1 : 0;
+	}
+
+private:
+	explicit BinaryLog(FILE* file) : m_file(file), m_offsets(1, 0), m_blob(1, '\0')
+	{
+		memset(&m_header, 0, sizeof(m_header));
+		memcpy(m_header.magic, "UTLOG01", 8);
+		m_header.recordSize = sizeof(Entry);
+		fwrite(&m_header, sizeof(m_header), 1, m_file);	// patched by Close
+	}
+
+	static std::string String(const unsigned long long* offsets, unsigned long long count, const char* strings, size_t size, unsigned id)
+	{
+		if(id >= count || offsets[id] >= size)
+		{
+			return std::string();
+		}
+		const char* text = strings + offsets[id];
+		return std::string(text, strnlen(text, size - offsets[id]));
+	}
+
+	unsigned Add(const std::string& text)
+	{
+		m_offsets.push_back(m_blob.size());
+		m_blob.append(text.c_str(), text.size() + 1);
+		return static_cast<unsigned>(m_offsets.size() - 1);
+	}
+
+	// literals - the address identifies the string
+	unsigned Intern(LPCSTR text)
+	{
+		if(!text || !*text)
+		{
+			return 0;
+		}
+		std::map<const void*, unsigned>::iterator found = m_literals.find(text);
+		if(found != m_literals.end() && strcmp(m_blob.c_str() + m_offsets[found->second], text) == 0)
+		{	// a reused buffer (not a literal) fails the compare and is interned by content
+			return found->second;
+		}
+		unsigned id = Intern(std::string(text));
+		m_literals[text] = id;
+		return id;
+	}
+
+	unsigned Intern(const std::string& text)
+	{
+		if(text.empty())
+		{
+			return 0;
+		}
+		std::map<std::string, unsigned>::iterator found = m_texts.find(text);
+		if(found != m_texts.end())
+		{
+			return found->second;
+		}
+		unsigned id = Add(text);
+		m_texts[text] = id;
+		return id;
+	}
+
+	unsigned Intern(const TestCase& test)
+	{
+		std::map<const void*, unsigned>::iterator found = m_literals.find(&test);
+		if(found != m_literals.end())
+		{
+			return found->second;
+		}
+		unsigned id = Intern(std::string(test.suite) + '.' + test.name);
+		m_literals[&test] = id;
+		return id;
+	}
+
+	FILE*								m_file;
+	Header								m_header;
+	std::vector<unsigned long long>		m_offsets;
+	std::string							m_blob;
+	std::map<const void*, unsigned>		m_literals;
+	std::map<std::string, unsigned>		m_texts;
+};	// BinaryLog
+
+///////////////////////////////////////////////////////////////////////////////
+// class BenchmarkState - the iteration counter of one timed batch
+///////////////////////////////////////////////////////////////////////////////
+class BenchmarkState
+{
+public:
+	// the first call starts the clock and the last one stops it, the others only decrement
+	bool KeepRunning()
+	{
+		if(m_remaining != 0)
+		{
+			--m_remaining;
+			return true;
+		}
+		return BenchmarkState::StartOrStop();
+	}
+	size_t Iterations() const
+	{
+		return m_iterations;
+	}
+
+	// monotonic clock in nanoseconds
+	static double Now()
+	{
+#if defined(__linux__)
+		struct timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec * 1e9 + ts.tv_nsec;
+#else
+		return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+	}
+
+private:
+	friend class Benchmark;
+
+	explicit BenchmarkState(size_t iterations) :
+		m_remaining(0), m_iterations(iterations), m_started(false), m_start(0), m_stop(0)
+	{
+	}
+
+	bool StartOrStop()
+	{
+		if(!m_started)
+		{
+			m_started = true;
+			m_remaining = m_iterations - 1;
+			m_start = BenchmarkState::Now();
+			return true;
+		}
+		m_stop = BenchmarkState::Now();
+		return false;
+	}
+
+	size_t	m_remaining;
+	size_t	m_iterations;
+	bool	m_started;
+	double	m_start;
+	double	m_stop;
+};	// BenchmarkState
+
+///////////////////////////////////////////////////////////////////////////////
+// class Benchmark - warmup, iteration count calibration and statistics
+// The body is first run for the warmup time, then the iteration count is grown
+// until one batch lasts at least the minimal batch time, and finally the
+// configured number of batches is timed; each batch gives one sample of the
+// time per iteration.
+///////////////////////////////////////////////////////////////////////////////
+typedef void (*BenchmarkFunction)(BenchmarkState&);
+
+class Benchmark
+{
+public:
+	struct Result
+	{
+		double	min;		// nanoseconds per iteration
+		double	median;
+		double	mean;
+		double	stddev;
+		double	p99;
+		size_t	iterations;	// per sample, 0 = a batch did not run the state.KeepRunning() loop to its end
+		size_t	samples;
+		PerfCounters::Counters	counters;	// of all the samples (--perf-counters)
+	};
+
+	static void SetWarmup(double milliseconds)			{ Benchmark::Settings().warmup = milliseconds * 1e6; }
+	static void SetMinBatchTime(double milliseconds)	{ Benchmark::Settings().batch = milliseconds * 1e6; }
+	static void SetSamples(size_t samples)				{ Benchmark::Settings().samples = samples ? samples : 1; }
+
+	template <class T>
+	static void DoNotOptimize(const T& value)
+	{
+#if defined(__GNUC__)
+		asm volatile("" : : "r,m"(value) : "memory");
+#else
+		static volatile const void* sink;
+		sink = &value;
+		_ReadWriteBarrier();
+#endif
+	}
+	static void ClobberMemory()
+	{
+#if defined(__GNUC__)
+		asm volatile("" : : : "memory");
+#else
+		_ReadWriteBarrier();
+#endif
+	}
+
+	static Result Measure(BenchmarkFunction function)
+	{
+		const Options& options = Benchmark::Settings();
+
+		Result result;
+		memset(&result, 0, sizeof(result));
+
+		// warmup and calibration - grow the batch until it lasts the minimal batch time
+		// (or reaches MaxIterations, for a body too fast for the clock)
+		size_t iterations = 1;
+		double warmupEnd = BenchmarkState::Now() + options.warmup;
+		for(;;)
+		{
+			double elapsed = Benchmark::Batch(function, iterations);
+			if(elapsed < 0)
+			{
+				return result;
+			}
+			if((elapsed >= options.batch || iterations == MaxIterations) && BenchmarkState::Now() >= warmupEnd)
+			{
+				break;
+			}
+			if(elapsed < options.batch && iterations < MaxIterations)
+			{
+				double scale = elapsed > 0 ? 1.2 * options.batch / elapsed : 10;
+				double grown = iterations * (scale < 10 ? (scale > 1.5 ? scale : 1.5) : 10) + 1;
+				iterations = grown < static_cast<double>(MaxIterations) ? static_cast<size_t>(grown) : static_cast<size_t>(MaxIterations);
+			}
+		}
+
+		std::vector<double> samples;
+		{	// only the body is charged to the case - the framework's vector is not counted (nor is its free)
+			Allocations::Ignore ignore;
+			samples.resize(options.samples);
+		}
+		PerfCounters::Counters counters = PerfCounters::Sample();
+		for(size_t i = 0; i < samples.size(); ++i)
+		{
+			double elapsed = Benchmark::Batch(function, iterations);
+			if(elapsed < 0)
+			{
+				return result;
+			}
+			samples[i] = elapsed / iterations;
+		}
+		std::sort(samples.begin(), samples.end());
+
+		result.counters = PerfCounters::Since(counters);
+		result.iterations = iterations;
+		result.samples = samples.size();
+		result.min = samples.front();
+		result.median = (samples[(samples.size() - 1) / 2] + samples[samples.size() / 2]) / 2;
+		result.mean = 0;
+		for(size_t i = 0; i < samples.size(); ++i)
+		{
+			result.mean += samples[i];
+		}
+		result.mean /= samples.size();
+		double variance = 0;
+		for(size_t i = 0; i < samples.size(); ++i)
+		{
+			variance += (samples[i] - result.mean) * (samples[i] - result.mean);
+		}
+		result.stddev = samples.size() > 1 ? sqrt(variance / (samples.size() - 1)) : 0;
+		result.p99 = samples[static_cast<size_t>(0.99 * (samples.size() - 1) + 0.5)];	// nearest rank
+		return result;
+	}
+
+	// called by the BENCHMARK case - measures and reports through the Reporter
+	static void Run(LPCSTR name, BenchmarkFunction function, LPCSTR file, int line)
+	{
+		Result result = Benchmark::Measure(function);
+		Allocations::Ignore ignore;		// the report is the framework's
+		std::ostringstream ostr;
+		if(result.iterations == 0)
+		{
+			Statistics::AddFail(file, line);
+			ostr << _T("Benchmark ") << name << _T(": the body must run while(state.KeepRunning()) until it returns false\n")
+				 << _T("at ") << file << _T(" (") << line << _T(")");
+			Reporter::Write(false, ostr.str(), file, line);
+			return;
+		}
+		ostr << _T("Benchmark ") << name << _T(": min ") << Benchmark::Time(result.min)
+			 << _T(", median ") << Benchmark::Time(result.median)
+			 << _T(", mean ") << Benchmark::Time(result.mean)
+			 << _T(", stddev ") << Benchmark::Time(result.stddev)
+			 << _T(", p99 ") << Benchmark::Time(result.p99)
+			 << _T(" (") << result.samples << _T(" samples x ") << result.iterations << _T(" iterations)");
+		if(result.counters.available)
+		{
+			ostr << _T(" per iteration") << PerfCounters::Format(result.counters, static_cast<double>(result.samples) * result.iterations);
+		}
+		Reporter::Write(true, ostr.str(), file, line);
+	}
+
+	// nanoseconds as text with a readable unit
+	static std::string Time(double nanoseconds)
+	{
+		static const LPCTSTR units[] = { _T("ns"), _T("us"), _T("ms"), _T("s") };
+		size_t unit = 0;
+		while(nanoseconds >= 1000 && unit < 3)
+		{
+			nanoseconds /= 1000;
+			++unit;
+		}
+		std::ostringstream ostr;
+		ostr.setf(std::ios::fixed);
+		ostr.precision(nanoseconds < 10 ? 2 : 1);
+		ostr << nanoseconds << _T(" ") << units[unit];
+		return ostr.str();
+	}
+
+private:
+	struct Options
+	{
+		double	warmup;		// nanoseconds
+		double	batch;		// nanoseconds
+		size_t	samples;
+	};
+
+	static Options& Settings()
+	{
+		static Options options = { 50e6, 1e6, 100 };	// 50 ms warmup, 1 ms batches, 100 samples
+		return options;
+	}
+
+	enum { MaxIterations = 1000000000 };	// per batch
+
+	// nanoseconds of the batch, -1 if the body never started the loop or left it early
+	static double Batch(BenchmarkFunction function, size_t iterations)
+	{
+		BenchmarkState state(iterations);
+		function(state);
+		if(!state.m_started || state.m_stop == 0)
+		{
+			return -1;
+		}
+		return state.m_stop - state.m_start;
+	}
+};	// Benchmark
+
+///////////////////////////////////////////////////////////////////////////////
+// class Performance - noise controlled duration measurement and the baselines
+// used by Assert::DurationLess / Assert::NotSlower. The callable is run once
+// to warm up and then the configured number of times (optionally pinned to one
+// CPU); samples further than 3 scaled MADs from the median are rejected as
+// outliers and the median of the remaining samples is the measured duration.
+// The baselines are "key<TAB>nanoseconds" lines of a text file.
+///////////////////////////////////////////////////////////////////////////////
+class Performance
+{
+public:
+	struct Measurement
+	{
+		double	median;		// nanoseconds
+		size_t	samples;	// samples used after the outlier rejection
+		size_t	rejected;
+	};
+
+	static void SetRepetitions(size_t repetitions)	{ Performance::Settings().repetitions = repetitions ? repetitions : 1; }
+	static void SetCpu(int cpu)						{ Performance::Settings().cpu = cpu; }	// -1 = no pinning
+	static void SetBaselineFile(LPCSTR path)
+	{
+		std::lock_guard<std::mutex> guard(Performance::Lock());
+		Performance::Settings().path = path ? path : "";
+		Performance::Settings().loaded = false;
+	}
+	static void SetUpdateBaseline(bool update)		{ Performance::Settings().update = update; }
+
+	template <class F>
+	static Measurement Measure(F& function)
+	{
+		const Options& options = Performance::Settings();
+		Pinning pinning(options.cpu);
+
+		function();	// warmup
+		std::vector<double> samples(options.repetitions);
+		for(size_t i = 0; i < samples.size(); ++i)
+		{
+			double start = BenchmarkState::Now();
+			function();
+			samples[i] = BenchmarkState::Now() - start;
+		}
+		return Performance::Reduce(samples);
+	}
+
+	// median of the samples after rejecting those outside median +/- 3 * 1.4826 * MAD
+	static Measurement Reduce(std::vector<double>& samples)
+	{
+		double median = Performance::Median(samples);
+		std::vector<double> deviations(samples.size());
+		for(size_t i = 0; i < samples.size(); ++i)
+		{
+			deviations[i] = fabs(samples[i] - median);
+		}
+		double limit = 3 * 1.4826 * Performance::Median(deviations);
+
+		std::vector<double> kept;
+		for(size_t i = 0; i < samples.size(); ++i)
+		{
+			if(limit == 0 || fabs(samples[i] - median) <= limit)
+			{
+				kept.push_back(samples[i]);
+			}
+		}
+		Measurement measurement = { Performance::Median(kept), kept.size(), samples.size() - kept.size() };
+		return measurement;
+	}
+
+	// returns false if there is no baseline for the key
+	static bool Baseline(LPCSTR key, double& nanoseconds)
+	{
+		std::lock_guard<std::mutex> guard(Performance::Lock());
+		Performance::Load();
+		std::map<std::string, double>::const_iterator it = Performance::Baselines().find(key);
+		if(it == Performance::Baselines().end() || Performance::Settings().update)
+		{
+			return false;
+		}
+		nanoseconds = it->second;
+		return true;
+	}
+	static void Record(LPCSTR key, double nanoseconds)
+	{
+		std::lock_guard<std::mutex> guard(Performance::Lock());
+		Performance::Load();
+		Performance::Baselines()[key] = nanoseconds;
+		Performance::Settings().dirty = true;
+	}
+
+	// writes the new baselines - called by the Runner at the end of the run
+	static void SaveBaselines()
+	{
+		std::lock_guard<std::mutex> guard(Performance::Lock());
+		Options& options = Performance::Settings();
+		if(!options.dirty || options.path.empty())
+		{
+			return;
+		}
+		std::ofstream file(options.path.c_str());
+		file.precision(17);
+		for(std::map<std::string, double>::const_iterator it = Performance::Baselines().begin(); it != Performance::Baselines().end(); ++it)
+		{
+			file << it->first << '\t' << it->second << '\n';
+		}
+		options.dirty = false;
+	}
+
+private:
+	struct Options
+	{
+		size_t		repetitions;
+		int			cpu;
+		std::string	path;
+		bool		update;
+		bool		loaded;
+		bool		dirty;
+	};
+
+	// pins the calling thread to one CPU for the lifetime of the object
+	class Pinning
+	{
+	public:
+		explicit Pinning(int cpu) : m_pinned(false)
+		{
+			if(cpu < 0)
+			{
+				return;
+			}
+#if defined(__linux__)
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			CPU_SET(cpu, &set);
+			m_pinned = sched_getaffinity(0, sizeof(m_previous), &m_previous) == 0 &&
+					   sched_setaffinity(0, sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+			m_previous = SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu);
+			m_pinned = m_previous != 0;
+#endif
+		}
+		~Pinning()
+		{
+			if(!m_pinned)
+			{
+				return;
+			}
+#if defined(__linux__)
+			sched_setaffinity(0, sizeof(m_previous), &m_previous);
+#elif defined(_WIN32)
+			SetThreadAffinityMask(GetCurrentThread(), m_previous);
+#endif
+		}
+	private:
+		bool		m_pinned;
+#if defined(__linux__)
+		cpu_set_t	m_previous;
+#elif defined(_WIN32)
+		DWORD_PTR	m_previous;
+#endif
+	};
+
+	static double Median(std::vector<double> values)
+	{
+		if(values.empty())
+		{
+			return 0;
+		}
+		std::sort(values.begin(), values.end());
+		return (values[(values.size() - 1) / 2] + values[values.size() / 2]) / 2;
+	}
+
+	static void Load()
+	{
+		Options& options = Performance::Settings();
+		if(options.loaded)
+		{
+			return;
+		}
+		options.loaded = true;
+		std::ifstream file(options.path.c_str());
+		std::string key;
+		double nanoseconds;
+		while(std::getline(file, key, '\t') && file >> nanoseconds)
+		{
+			Performance::Baselines()[key] = nanoseconds;
+			file.ignore(1);	// '\n'
+		}
+	}
+
+	static Options& Settings()
+	{
+		static Options options = { 15, -1, "UnitTest.baseline", false, false, false };
+		return options;
+	}
+	static std::map<std::string, double>& Baselines()
+	{
+		static std::map<std::string, double> baselines;
+		return baselines;
+	}
+	static std::mutex& Lock()
+	{
+		static std::mutex lock;
+		return lock;
+	}
+};	// Performance
+
+///////////////////////////////////////////////////////////////////////////////
+// struct ValueFormatter<T> - the text of a value in a failure message
+// Format writes a value into a FormatBuffer, a fixed buffer of the caller, with
+// no stream and no locale: integers and floating point values with
+// std::to_chars (a float as the shortest text which reads back as the same
+// value), pointers and Bytes in hex, bool as true / false. A value without a
+// ValueFormatter is printed with its operator<<. A type of your own:
+//
+//	namespace UnitTest {
+//	template <>
+//	struct ValueFormatter<Point>
+//	{
+//		static void Format(const Point& point, FormatBuffer& out)
+//		{
+//			out << "(" << point.x << ", " << point.y << ")";
+//		}
+//	};
+//	}
+///////////////////////////////////////////////////////////////////////////////
+template <class T, class Enable = void>
+struct ValueFormatter
+{	// none - see Formattable
+};
+
+class FormatBuffer
+{
+public:
+	// each time the buffer is full its characters go to 'sink' - without one only the first 'capacity' are kept
+	FormatBuffer(char* data, size_t capacity, std::streambuf* sink = NULL)
+		: m_data(data), m_capacity(capacity), m_size(0), m_length(0), m_sink(sink)	{}
+
+	const char* Data() const			{ return m_data; }
+	size_t Size() const					{ return m_size; }		// the characters in the buffer
+	unsigned long long Length() const	{ return m_length; }	// all characters written - more than Size() when some did not fit
+
+	FormatBuffer& Write(const char* data, size_t size)
+	{
+		m_length += size;
+		while(size > 0)
+		{
+			if(m_size == m_capacity)
+			{
+				if(!m_sink)
+				{
+					break;
+				}
+				FormatBuffer::Flush();
+			}
+			size_t count = std::min(size, m_capacity - m_size);
+			memcpy(m_data + m_size, data, count);
+			m_size += count;
+			data += count;
+			size -= count;
+		}
+		return *this;
+	}
+
+	// the characters in the buffer to the sink
+	void Flush()
+	{
+		if(m_sink && m_size > 0)
+		{
+			m_sink->sputn(m_data, static_cast<std::streamsize>(m_size));
+			m_size = 0;
+		}
+	}
+
+	FormatBuffer& operator<<(const char* text)
+	{
+		return text ? Write(text, strlen(text)) : Write(_T("NULL"), 4);
+	}
+	FormatBuffer& operator<<(char* text)
+	{
+		return *this << const_cast<const char*>(text);
+	}
+	FormatBuffer& operator<<(const std::string& text)
+	{
+		return Write(text.data(), text.size());
+	}
+	template <class T>
+	FormatBuffer& operator<<(const T& value)
+	{
+		ValueFormatter<T>::Format(value, *this);
+		return *this;
+	}
+
+	// an ostream target which writes to a FormatBuffer - for the operator<< of a type without a ValueFormatter
+	class Output : public std::streambuf
+	{
+	public:
+		explicit Output(FormatBuffer& out) : m_out(out)	{}
+
+	protected:
+		virtual int_type overflow(int_type c)
+		{
+			if(c != traits_type::eof())
+			{
+				char character = traits_type::to_char_type(c);
+				m_out.Write(&character, 1);
+			}
+			return traits_type::not_eof(c);
+		}
+		virtual std::streamsize xsputn(const char* data, std::streamsize count)
+		{
+			m_out.Write(data, static_cast<size_t>(count));
+			return count;
+		}
+
+	private:
+		FormatBuffer&	m_out;
+	};
+
+private:
+	FormatBuffer(const FormatBuffer&);
+
+	char*				m_data;
+	size_t				m_capacity;
+	size_t				m_size;
+	unsigned long long	m_length;
+	std::streambuf*		m_sink;
+};	// FormatBuffer
+
+// true when ValueFormatter<T> has a Format
+template <class T, class = void>
+struct Formattable : std::false_type {};
+template <class T>
+struct Formattable<T, decltype(ValueFormatter<T>::Format(std::declval<const T&>(), std::declval<FormatBuffer&>()))> : std::true_type {};
+
+template <>
+struct ValueFormatter<bool>
+{
+	static void Format(const bool& value, FormatBuffer& out)
+	{
+		value ? out.Write(_T("true"), 4) : out.Write(_T("false"), 5);
+	}
+};
+
+template <>
+struct ValueFormatter<char>
+{	// the character - signed char and unsigned char are numbers
+	static void Format(const char& value, FormatBuffer& out)
+	{
+		out.Write(&value, 1);
+	}
+};
+
+template <class T>
+struct ValueFormatter<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value && !std::is_same<T, char>::value>::type>
+{	// in decimal
+	static void Format(const T& value, FormatBuffer& out)
+	{
+		char text[24];
+		std::to_chars_result result = std::is_signed<T>::value
+			? std::to_chars(text, text + sizeof(text), static_cast<long long>(value))
+			: std::to_chars(text, text + sizeof(text), static_cast<unsigned long long>(value));
+		out.Write(text, result.ptr - text);
+	}
+};
+
+template <class T>
+struct ValueFormatter<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+{	// the shortest text which reads back as the same value, so two values which differ never print the same
+	static void Format(const T& value, FormatBuffer& out)
+	{
+		char text[128];
+#if defined(__cpp_lib_to_chars)
+		std::to_chars_result result = std::to_chars(text, text + sizeof(text), value);
+		out.Write(text, (result.ec == std::errc()) ? result.ptr - text : 0);
+#else	// no floating point to_chars in the library - every digit which tells two values apart
+		int size = snprintf(text, sizeof(text), "%.*Lg", std::numeric_limits<T>::max_digits10, static_cast<long double>(value));
+		out.Write(text, (size > 0) ? std::min<size_t>(size, sizeof(text) - 1) : 0);
+#endif
+	}
+};
+
+template <class T>
+struct ValueFormatter<T*, typename std::enable_if<!std::is_same<typename std::remove_cv<T>::type, char>::value &&
+												  !std::is_same<typename std::remove_cv<T>::type, signed char>::value &&
+												  !std::is_same<typename std::remove_cv<T>::type, unsigned char>::value>::type>
+{	// the address in hex - a char pointer is a string, which operator<< prints
+	static void Format(T* const& value, FormatBuffer& out)
+	{
+		if(!value)
+		{
+			out.Write(_T("NULL"), 4);
+			return;
+		}
+		char text[2 + 2 * sizeof(uintptr_t)] = { '0', 'x' };
+		std::to_chars_result result = std::to_chars(text + 2, text + sizeof(text), reinterpret_cast<uintptr_t>(value), 16);
+		out.Write(text, result.ptr - text);
+	}
+};
+
+template <>
+struct ValueFormatter<std::nullptr_t>
+{
+	static void Format(const std::nullptr_t&, FormatBuffer& out)
+	{
+		out.Write(_T("NULL"), 4);
+	}
+};
+
+// a span of bytes which compares and prints as bytes - TEST_EQUAL(UnitTest::Bytes(p, n), UnitTest::Bytes(q, n), "[Bytes]")
+struct Bytes
+{
+	const void*	data;
+	size_t		size;
+
+	Bytes(const void* data, size_t size) : data(data), size(size)	{}
+
+	bool operator==(const Bytes& other) const
+	{
+		return size == other.size && (size == 0 || memcmp(data, other.data, size) == 0);
+	}
+	bool operator!=(const Bytes& other) const
+	{
+		return !(*this == other);
+	}
+};
+
+template <>
+struct ValueFormatter<Bytes>
+{	// "0a 1b 2c" - a few hundred bytes at a time
+	static void Format(const Bytes& value, FormatBuffer& out)
+	{
+		static const char digits[] = "0123456789abcdef";
+		const unsigned char* bytes = static_cast<const unsigned char*>(value.data);
+		char text[3 * 128];
+		for(size_t first = 0; first < value.size; first += 128)
+		{
+			size_t count = std::min<size_t>(128, value.size - first);
+			for(size_t i = 0; i < count; ++i)
+			{
+				text[3 * i] = digits[bytes[first + i] >> 4];
+				text[3 * i + 1] = digits[bytes[first + i] & 15];
+				text[3 * i + 2] = ' ';
+			}
+			out.Write(text, 3 * count - ((first + count == value.size) ? 1 : 0));
+		}
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Expression - the result of a decomposed CHECK / REQUIRE expression
+// The operands are kept by address together with a static descriptor of their
+// print functions, so a call site passes three pointers and a flag, the pass
+// path runs no type specific code and only a failure prints the operands
+// (through the non-template Assert::That slow path). The expression types are
+// aggregates, so a debug build calls no constructors at the call site either.
+///////////////////////////////////////////////////////////////////////////////
+struct Expression
+{
+	typedef void (*Printer)(FormatBuffer& out, const void* value);
+	typedef bool (*Viewer)(const void* value, const char*& data, size_t& size);	// the characters of a string operand
+
+	enum Operator { Single, Equal, NotEqual, Less, LessOrEqual, Greater, GreaterOrEqual };
+
+	// one per operand types and operator which is actually used - right is NULL for a single value
+	struct Operation
+	{
+		Printer		left;
+		Printer		right;
+		Viewer		leftText;
+		Viewer		rightText;
+		Operator	op;
+	};
+
+	template <class T, class R, Operator Op>
+	struct Operations
+	{
+		static const Operation operation;
+	};
+
+	bool				result;
+	const void*			left;
+	const void*			right;
+	const Operation*	operation;
+
+	static LPCSTR Symbol(Operator op)
+	{
+		static const LPCSTR symbols[] = { _T(""), _T("=="), _T("!="), _T("<"), _T("<="), _T(">"), _T(">=") };
+		return symbols[op];
+	}
+
+	template <class T>
+	static void Print(FormatBuffer& out, const void* value)
+	{
+		Expression::Write(out, *static_cast<const T*>(value), Formattable<T>(), Streamable<T>());
+	}
+
+	template <class T>
+	static bool View(const void* value, const char*& data, size_t& size)
+	{
+		return Expression::Text(*static_cast<const T*>(value), data, size);
+	}
+
+private:
+	template <class T, class = void>
+	struct Streamable : std::false_type {};
+	template <class T>
+	struct Streamable<T, decltype(void(std::declval<std::ostream&>() << std::declval<const T&>()))> : std::true_type {};
+
+	template <class T, class S>
+	static void Write(FormatBuffer& out, const T& value, std::true_type, S)
+	{	// its ValueFormatter
+		out << value;
+	}
+	template <class T>
+	static void Write(FormatBuffer& out, const T& value, std::false_type, std::true_type)
+	{	// its operator<<
+		FormatBuffer::Output output(out);
+		std::ostream ostr(&output);
+		ostr << value;
+	}
+	template <class T>
+	static void Write(FormatBuffer& out, const T& /*value*/, std::false_type, std::false_type)
+	{	// no operator<< for the type
+		out << _T("{?}");
+	}
+	static void Write(FormatBuffer& out, const char* const& value, std::false_type, std::true_type)
+	{
+		(value) ? (out << _T("\"") << value << _T("\"")) : (out << _T("NULL"));
+	}
+	static void Write(FormatBuffer& out, char* const& value, std::false_type, std::true_type)
+	{
+		Expression::Write(out, const_cast<const char* const&>(value), std::false_type(), std::true_type());
+	}
+	static void Write(FormatBuffer& out, const std::string& value, std::false_type, std::true_type)
+	{
+		out << _T("\"") << value << _T("\"");
+	}
+
+	template <class T>
+	static bool Text(const T& /*value*/, const char*& /*data*/, size_t& /*size*/)
+	{	// not a string - printed instead
+		return false;
+	}
+	static bool Text(const std::string& value, const char*& data, size_t& size)
+	{
+		data = value.data();
+		size = value.size();
+		return true;
+	}
+	static bool Text(const std::string_view& value, const char*& data, size_t& size)
+	{
+		data = value.data();
+		size = value.size();
+		return true;
+	}
+	static bool Text(const char* const& value, const char*& data, size_t& size)
+	{
+		data = value;
+		size = value ? strlen(value) : 0;
+		return value != NULL;
+	}
+	static bool Text(char* const& value, const char*& data, size_t& size)
+	{
+		return Expression::Text(const_cast<const char* const&>(value), data, size);
+	}
+};	// Expression
+
+template <class T, class R, Expression::Operator Op>
+const Expression::Operation Expression::Operations<T, R, Op>::operation =
+{
+	&Expression::Print<T>, (Op == Expression::Single) ? NULL : &Expression::Print<R>,
+	&Expression::View<T>, (Op == Expression::Single) ? NULL : &Expression::View<R>, Op
+};
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-compare"	// CHECK(v.size() == 3) compares as the user wrote it
+#elif defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable:4018 4389)	// signed/unsigned mismatch
+#endif
+
+// the left operand of a decomposed expression - kept by reference
+template <class T>
+struct ExpressionLhs
+{
+	const T& left;
+
+	template <class R> Expression operator==(const R& right) const { Expression e = { Equal(left, right),	&left, &right, &Expression::Operations<T, R, Expression::Equal>::operation }; return e; }
+	template <class R> Expression operator!=(const R& right) const { Expression e = { !Equal(left, right),	&left, &right, &Expression::Operations<T, R, Expression::NotEqual>::operation }; return e; }
+	template <class R> Expression operator< (const R& right) const { Expression e = { left <  right,		&left, &right, &Expression::Operations<T, R, Expression::Less>::operation }; return e; }
+	template <class R> Expression operator<=(const R& right) const { Expression e = { left <= right,		&left, &right, &Expression::Operations<T, R, Expression::LessOrEqual>::operation }; return e; }
+	template <class R> Expression operator> (const R& right) const { Expression e = { left >  right,		&left, &right, &Expression::Operations<T, R, Expression::Greater>::operation }; return e; }
+	template <class R> Expression operator>=(const R& right) const { Expression e = { left >= right,		&left, &right, &Expression::Operations<T, R, Expression::GreaterOrEqual>::operation }; return e; }
+
+	// CHECK(value) - a single operand tested for true
+	operator Expression() const
+	{
+		Expression e = { left ? true : false, &left, NULL, &Expression::Operations<T, T, Expression::Single>::operation };
+		return e;
+	}
+
+	template <class L, class R>
+	static bool Equal(const L& first, const R& second)
+	{
+		return first == second;
+	}
+};	// ExpressionLhs
+
+// Decomposer() <= a == b parses as (Decomposer() <= a) == b: <= binds tighter than ==
+// and groups to the left with <, >, <= and >=
+struct Decomposer
+{
+	template <class T>
+	ExpressionLhs<T> operator<=(const T& left) const
+	{
+		ExpressionLhs<T> lhs = { left };
+		return lhs;
+	}
+};	// Decomposer
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#elif defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// class Collections - the search kernels of the CollectionAssert methods
+// Elements of a scalar type with unique object representations (integers,
+// enums, pointers - see Bitwise) are equal exactly when their bytes are, so
+// those ranges are compared 32 bytes (AVX2, selected at run time) or 16 bytes
+// (SSE2) at a time; any other type uses its own operator== and operator<.
+// A kernel returns the first hit, or the first element after its last full
+// vector, and a scalar loop finishes the search from there.
+///////////////////////////////////////////////////////////////////////////////
+class Collections
+{
+public:
+	// a pointer and a count as a collection: Collections::Range(data, size)
+	template <class T>
+	class Range
+	{
+	public:
+		Range(const T* data, size_t size) : m_data(data), m_size(size)	{}
+
+		const T*	data() const	{ return m_data; }
+		size_t		size() const	{ return m_size; }
+
+	private:
+		const T*	m_data;
+		size_t		m_size;
+	};
+
+	// == is a byte compare (not float: -0.0 == 0.0 and NaN != NaN; not classes: their own operator==)
+	template <class T>
+	struct Bitwise : std::integral_constant<bool, std::is_scalar<T>::value && std::has_unique_object_representations<T>::value> {};
+
+	static constexpr size_t Context = 4;			// elements printed on each side of a mismatch
+	static constexpr size_t NoIndex = ~size_t(0);	// Window() without a marked element
+
+	// the first index where the ranges differ, 'count' if they are equal
+	template <class T1, class T2>
+	static size_t Mismatch(const T1* expected, const T2* actual, size_t count)
+	{
+		if constexpr(std::is_same<T1, T2>::value && Bitwise<T1>::value)
+		{
+			const unsigned char* left = reinterpret_cast<const unsigned char*>(expected);
+			const unsigned char* right = reinterpret_cast<const unsigned char*>(actual);
+			size_t bytes = count * sizeof(T1);
+			size_t i = 0;
+#if defined(UNITTEST_SSE2)
+			i = Collections::MismatchVectors(left, right, bytes);
+#endif
+			while(i < bytes && left[i] == right[i])
+			{
+				++i;
+			}
+			return i / sizeof(T1);
+		}
+		else
+		{
+			size_t i = 0;
+			while(i < count && expected[i] == actual[i])
+			{
+				++i;
+			}
+			return i;
+		}
+	}
+
+	// the index of the first element equal to 'value', 'count' if there is none
+	template <class T, class V>
+	static size_t Find(const T* data, size_t count, const V& value)
+	{
+		size_t i = 0;
+		if constexpr(Bitwise<T>::value && (std::is_same<T, V>::value || (std::is_integral<T>::value && std::is_integral<V>::value)))
+		{
+			const T key = static_cast<T>(value);
+			if(!(static_cast<V>(key) == value))
+			{	// out of the range of T - no element is equal
+				return count;
+			}
+			if constexpr(sizeof(T) == 1)
+			{
+				const void* hit = memchr(data, *reinterpret_cast<const unsigned char*>(&key), count);
+				return hit ? static_cast<const T*>(hit) - data : count;
+			}
+#if defined(UNITTEST_SSE2)
+			else if constexpr(sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8)
+			{
+				i = Collections::FindVectors<sizeof(T)>(reinterpret_cast<const unsigned char*>(data), count * sizeof(T), &key) / sizeof(T);
+			}
+#endif
+			while(i < count && !(data[i] == key))
+			{
+				++i;
+			}
+			return i;
+		}
+		else
+		{
+			while(i < count && !(data[i] == value))
+			{
+				++i;
+			}
+			return i;
+		}
+	}
+
+	// the first index i with data[i + 1] < data[i], 'count' if the range is in ascending order
+	template <class T>
+	static size_t Descent(const T* data, size_t count)
+	{
+		size_t i = 0;
+#if defined(UNITTEST_SSE2)
+		if constexpr(std::is_integral<T>::value && (sizeof(T) == 4 || sizeof(T) == 8))
+		{
+			i = Collections::DescentVectors(data, count);
+		}
+#endif
+		for(; i + 1 < count; ++i)
+		{
+			if(data[i + 1] < data[i])
+			{
+				return i;
+			}
+		}
+		return count;
+	}
+
+	// true if both ranges hold the same elements in any order; otherwise 'value' is the
+	// first value (in sorted order) which occurs a different number of times in them
+	template <class T1, class T2>
+	static bool Equivalent(const T1* expected, size_t expectedCount, const T2* actual, size_t actualCount,
+						   std::string& value, size_t& expectedTimes, size_t& actualTimes)
+	{
+		Allocations::Ignore ignore;	// the sorted copies belong to the framework
+		if constexpr(std::is_same<T1, T2>::value && Bitwise<T1>::value && sizeof(T1) == 1)
+		{	// a histogram instead of sorting
+			size_t left[256];
+			size_t right[256];
+			Collections::Histogram(reinterpret_cast<const unsigned char*>(expected), expectedCount, left);
+			Collections::Histogram(reinterpret_cast<const unsigned char*>(actual), actualCount, right);
+			std::vector<T1> values;
+			for(unsigned i = 0; i < 256; ++i)
+			{
+				if(left[i] != right[i])
+				{	// the byte values in the order of T1
+					unsigned char byte = static_cast<unsigned char>(i);
+					T1 element;
+					memcpy(&element, &byte, 1);
+					values.push_back(element);
+				}
+			}
+			if(values.empty())
+			{
+				return true;
+			}
+			T1 first = *std::min_element(values.begin(), values.end());
+			unsigned char byte;
+			memcpy(&byte, &first, 1);
+			Collections::Describe(first, left[byte], right[byte], value, expectedTimes, actualTimes);
+			return false;
+		}
+		else
+		{
+			std::vector<T1> left(expected, expected + expectedCount);
+			std::vector<T2> right(actual, actual + actualCount);
+			std::sort(left.begin(), left.end());
+			std::sort(right.begin(), right.end());
+			size_t count = std::min(expectedCount, actualCount);
+			size_t index = Collections::Mismatch(left.data(), right.data(), count);
+			if(index == count && expectedCount == actualCount)
+			{
+				return true;
+			}
+			// the smaller one of the two elements at 'index' is missing on the other side
+			if(index < expectedCount && (index == actualCount || left[index] < right[index]))
+			{
+				const T1& element = left[index];
+				Collections::Describe(element, Collections::Count(left, element), Collections::Count(right, element),
+									  value, expectedTimes, actualTimes);
+			}
+			else
+			{
+				const T2& element = right[index];
+				Collections::Describe(element, Collections::Count(left, element), Collections::Count(right, element),
+									  value, expectedTimes, actualTimes);
+			}
+			return false;
+		}
+	}
+
+	// "... [first] a, b, >c<, d, e ... (N elements)" - the elements around 'index';
+	// an index past the end marks the end of the range (a shorter collection)
+	template <class T>
+	static std::string Window(const T* data, size_t count, size_t index)
+	{
+		size_t center = (index == NoIndex) ? Context : index;
+		size_t first = (center > Context) ? center - Context : 0;
+		size_t last = std::min(count, center + Context + 1);
+		std::ostringstream ostr;
+		if(first > 0)
+		{
+			ostr << _T("... ");
+		}
+		ostr << _T("[") << first << _T("] ");
+		for(size_t i = first; i < last; ++i)
+		{
+			ostr << ((i > first) ? _T(", ") : _T("")) << ((i == index) ? _T(">") : _T(""));
+			Collections::Print(ostr, data[i]);
+			ostr << ((i == index) ? _T("<") : _T(""));
+		}
+		if(index != NoIndex && index >= count)
+		{
+			ostr << ((count > first) ? _T(", ") : _T("")) << _T(">end<");
+		}
+		if(last < count)
+		{
+			ostr << _T(" ...");
+		}
+		ostr << _T(" (") << count << _T(" elements)");
+		return ostr.str();
+	}
+
+	// an element as CHECK prints an operand (the bytes of a buffer are numbers, see ValueFormatter)
+	template <class T>
+	static void Print(std::ostream& ostr, const T& value)
+	{
+		char data[256];
+		FormatBuffer out(data, sizeof(data), ostr.rdbuf());
+		Expression::Print<T>(out, &value);
+		out.Flush();
+	}
+
+	static bool HasAvx2()
+	{
+#if defined(UNITTEST_AVX2) && defined(__GNUC__)
+		static const bool avx2 = __builtin_cpu_supports("avx2");
+		return avx2;
+#elif defined(UNITTEST_AVX2)
+		return true;	// compiled with /arch:AVX2
+#else
+		return false;
+#endif
+	}
+
+private:
+	template <class T, class V>
+	static size_t Count(const std::vector<T>& sorted, const V& value)
+	{
+		std::pair<typename std::vector<T>::const_iterator, typename std::vector<T>::const_iterator> range =
+			std::equal_range(sorted.begin(), sorted.end(), value);
+		return static_cast<size_t>(range.second - range.first);
+	}
+
+	// four tables, so a run of equal bytes does not wait for the previous increment of its counter
+	static void Histogram(const unsigned char* data, size_t count, size_t counts[256])
+	{
+		std::vector<size_t> tables(4 * 256);
+		size_t i = 0;
+		for(; i + 4 <= count; i += 4)
+		{
+			++tables[data[i]];
+			++tables[256 + data[i + 1]];
+			++tables[512 + data[i + 2]];
+			++tables[768 + data[i + 3]];
+		}
+		for(; i < count; ++i)
+		{
+			++tables[data[i]];
+		}
+		for(unsigned value = 0; value < 256; ++value)
+		{
+			counts[value] = tables[value] + tables[256 + value] + tables[512 + value] + tables[768 + value];
+		}
+	}
+
+	template <class T>
+	static void Describe(const T& element, size_t expected, size_t actual, std::string& value, size_t& expectedTimes, size_t& actualTimes)
+	{
+		std::ostringstream ostr;
+		Collections::Print(ostr, element);
+		value = ostr.str();
+		expectedTimes = expected;
+		actualTimes = actual;
+	}
+
+#if defined(UNITTEST_SSE2)
+	static unsigned LowestBit(unsigned mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	// the kernels compare whole vectors only - the callers finish the search with a scalar loop
+	static size_t MismatchVectors(const unsigned char* left, const unsigned char* right, size_t bytes)
+	{
+#if defined(UNITTEST_AVX2)
+		if(Collections::HasAvx2())
+		{
+			return Collections::MismatchAvx2(left, right, bytes);
+		}
+#endif
+		return Collections::MismatchSse2(left, right, bytes);
+	}
+
+	template <size_t Size>
+	static size_t FindVectors(const unsigned char* data, size_t bytes, const void* value)
+	{
+#if defined(UNITTEST_AVX2)
+		if(Collections::HasAvx2())
+		{
+			return Collections::FindAvx2<Size>(data, bytes, value);
+		}
+#endif
+		return Collections::FindSse2<Size>(data, bytes, value);
+	}
+
+	template <class T>
+	static size_t DescentVectors(const T* data, size_t count)
+	{
+#if defined(UNITTEST_AVX2)
+		if(Collections::HasAvx2())
+		{
+			return Collections::DescentAvx2(data, count);
+		}
+#endif
+		return Collections::DescentSse2(data, count);
+	}
+
+	static size_t MismatchSse2(const unsigned char* left, const unsigned char* right, size_t bytes)
+	{
+		size_t i = 0;
+		for(; i + 16 <= bytes; i += 16)
+		{
+			__m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(left + i)),
+										   _mm_loadu_si128(reinterpret_cast<const __m128i*>(right + i)));
+			unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(equal)) & 0xffff;
+			if(mask)
+			{
+				return i + Collections::LowestBit(mask);
+			}
+		}
+		return i;
+	}
+
+	// the byte offset of the first element equal to 'value' (Size bytes)
+	template <size_t Size>
+	static size_t FindSse2(const unsigned char* data, size_t bytes, const void* value)
+	{
+		size_t i = 0;
+		__m128i key;
+		if constexpr(Size == 2)	{ short v; memcpy(&v, value, 2); key = _mm_set1_epi16(v); }
+		if constexpr(Size == 4)	{ int v; memcpy(&v, value, 4); key = _mm_set1_epi32(v); }
+		if constexpr(Size == 8)	{ long long v; memcpy(&v, value, 8); key = _mm_set1_epi64x(v); }
+		for(; i + 16 <= bytes; i += 16)
+		{
+			__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+			__m128i equal;
+			if constexpr(Size == 2)	{ equal = _mm_cmpeq_epi16(block, key); }
+			if constexpr(Size == 4)	{ equal = _mm_cmpeq_epi32(block, key); }
+			if constexpr(Size == 8)
+			{	// no 64 bit compare in SSE2 - both halves must be equal
+				equal = _mm_cmpeq_epi32(block, key);
+				equal = _mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+			}
+			unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(equal));
+			if(mask)
+			{
+				return i + Collections::LowestBit(mask);
+			}
+		}
+		return i;
+	}
+
+	// the first descent of 32 bit integers (SSE2 has no 64 bit compare); unsigned values are
+	// moved into the signed range by flipping the sign bit
+	template <class T>
+	static size_t DescentSse2(const T* data, size_t count)
+	{
+		size_t i = 0;
+		if constexpr(sizeof(T) == 4)
+		{
+			const __m128i bias = _mm_set1_epi32(std::is_signed<T>::value ? 0 : std::numeric_limits<int>::min());
+			for(; i + 4 < count; i += 4)
+			{
+				__m128i current = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), bias);
+				__m128i next = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1)), bias);
+				unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpgt_epi32(current, next)));
+				if(mask)
+				{
+					return i + Collections::LowestBit(mask) / 4;
+				}
+			}
+		}
+		return i;
+	}
+#endif
+
+#if defined(UNITTEST_AVX2)
+	UNITTEST_TARGET_AVX2 static size_t MismatchAvx2(const unsigned char* left, const unsigned char* right, size_t bytes)
+	{
+		size_t i = 0;
+		for(; i + 64 <= bytes; i += 64)
+		{	// two vectors and one branch per iteration - the next loop finds the byte
+			__m256i first = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i)),
+											  _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + i)));
+			__m256i second = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i + 32)),
+											   _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + i + 32)));
+			if(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(first, second))) != 0xffffffffu)
+			{
+				break;
+			}
+		}
+		for(; i + 32 <= bytes; i += 32)
+		{
+			__m256i equal = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(left + i)),
+											  _mm256_loadu_si256(reinterpret_cast<const __m256i*>(right + i)));
+			unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(equal));
+			if(mask)
+			{
+				return i + Collections::LowestBit(mask);
+			}
+		}
+		return i;
+	}
+
+	template <size_t Size>
+	UNITTEST_TARGET_AVX2 static size_t FindAvx2(const unsigned char* data, size_t bytes, const void* value)
+	{
+		size_t i = 0;
+		__m256i key;
+		if constexpr(Size == 2)	{ short v; memcpy(&v, value, 2); key = _mm256_set1_epi16(v); }
+		if constexpr(Size == 4)	{ int v; memcpy(&v, value, 4); key = _mm256_set1_epi32(v); }
+		if constexpr(Size == 8)	{ long long v; memcpy(&v, value, 8); key = _mm256_set1_epi64x(v); }
+		for(; i + 32 <= bytes; i += 32)
+		{
+			__m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+			__m256i equal;
+			if constexpr(Size == 2)	{ equal = _mm256_cmpeq_epi16(block, key); }
+			if constexpr(Size == 4)	{ equal = _mm256_cmpeq_epi32(block, key); }
+			if constexpr(Size == 8)	{ equal = _mm256_cmpeq_epi64(block, key); }
+			unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(equal));
+			if(mask)
+			{
+				return i + Collections::LowestBit(mask);
+			}
+		}
+		return i;
+	}
+
+	template <class T>
+	UNITTEST_TARGET_AVX2 static size_t DescentAvx2(const T* data, size_t count)
+	{
+		size_t i = 0;
+		const size_t lanes = 32 / sizeof(T);
+		const __m256i bias = (sizeof(T) == 4) ?
+			_mm256_set1_epi32(std::is_signed<T>::value ? 0 : std::numeric_limits<int>::min()) :
+			_mm256_set1_epi64x(std::is_signed<T>::value ? 0 : std::numeric_limits<long long>::min());
+		for(; i + lanes < count; i += lanes)
+		{
+			__m256i current = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), bias);
+			__m256i next = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1)), bias);
+			__m256i greater = (sizeof(T) == 4) ? _mm256_cmpgt_epi32(current, next) : _mm256_cmpgt_epi64(current, next);
+			unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(greater));
+			if(mask)
+			{
+				return i + Collections::LowestBit(mask) / sizeof(T);
+			}
+		}
+		return i;
+	}
+#endif
+};	// Collections
+
+///////////////////////////////////////////////////////////////////////////////
+// class Tolerance - how far an actual floating point value may be from the
+// expected one (AreNear / CollectionAreNear):
+//	Tolerance(1e-9) or Tolerance::Absolute(1e-9)	|expected - actual| <= 1e-9
+//	Tolerance::Relative(1e-6)						|expected - actual| <= 1e-6 * max(|expected|, |actual|)
+//	Tolerance::Ulps(4)								at most 4 representable values apart
+// Equal values are always near (also infinities); NaN is never near anything.
+// The float and double range kernels count the pairs outside the tolerance 8/4
+// (AVX2) or 4/2 (SSE2) at a time with the same arithmetic as the scalar test,
+// so the tail and the failure report agree with them; only a failure walks the
+// range again to find the worst element.
+///////////////////////////////////////////////////////////////////////////////
+class Tolerance
+{
+public:
+	enum Mode { AbsoluteError, RelativeError, UlpDistance };
+
+	Tolerance(double absolute) : m_mode(AbsoluteError), m_value(absolute)	{}	// a plain number is an absolute tolerance
+
+	static Tolerance Absolute(double absolute)	{ return Tolerance(AbsoluteError, absolute); }
+	static Tolerance Relative(double relative)	{ return Tolerance(RelativeError, relative); }
+	static Tolerance Ulps(unsigned long long ulps)	{ return Tolerance(UlpDistance, static_cast<double>(ulps)); }
+
+	Mode	GetMode() const		{ return m_mode; }
+	double	GetValue() const	{ return m_value; }
+
+	template <class T>
+	bool Accepts(T expected, T actual) const
+	{
+		if(expected == actual)
+		{
+			return true;
+		}
+		if(m_mode == UlpDistance)
+		{
+			return expected == expected && actual == actual && Tolerance::Distance(expected, actual) <= Tolerance::MaxUlps<T>(m_value);
+		}
+		// the same operations as the kernels: one limit for both modes, 0 for the unused term
+		const T absolute = static_cast<T>(m_mode == AbsoluteError ? m_value : 0);
+		const T relative = static_cast<T>(m_mode == RelativeError ? m_value : 0);
+		T difference = std::fabs(expected - actual);
+		T limit = absolute + relative * std::max(std::fabs(expected), std::fabs(actual));
+		return difference <= limit && difference < std::numeric_limits<T>::infinity();
+	}
+
+	// the error in the unit of the mode - NaN is an infinite error
+	template <class T>
+	double Error(T expected, T actual) const
+	{
+		if(expected == actual)
+		{
+			return 0;
+		}
+		if(expected != expected || actual != actual)
+		{
+			return std::numeric_limits<double>::infinity();
+		}
+		switch(m_mode)
+		{
+		case UlpDistance:
+			return static_cast<double>(Tolerance::Distance(expected, actual));
+		case RelativeError:
+			return std::fabs(static_cast<double>(expected) - actual) / std::max(std::fabs(static_cast<double>(expected)), std::fabs(static_cast<double>(actual)));
+		default:
+			return std::fabs(static_cast<double>(expected) - actual);
+		}
+	}
+
+	// "within 1e-06", "within 1e-06 relative", "within 4 ULPs"
+	std::string Describe() const
+	{
+		std::ostringstream ostr;
+		ostr << _T("within ") << m_value << ((m_mode == RelativeError) ? _T(" relative") : (m_mode == UlpDistance) ? _T(" ULPs") : _T(""));
+		return ostr.str();
+	}
+
+	// the number of pairs outside the tolerance - the pass path of CollectionAreNear
+	template <class T>
+	size_t Outside(const T* expected, const T* actual, size_t count) const
+	{
+		static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "the near ranges hold float or double");
+		size_t outside = 0;
+		size_t i = 0;
+#if defined(UNITTEST_SSE2)
+		i = Tolerance::OutsideVectors(expected, actual, count, outside);
+#endif
+		for(; i < count; ++i)
+		{
+			outside += Tolerance::Accepts(expected[i], actual[i]) ? 0 : 1;
+		}
+		return outside;
+	}
+
+	// the failure path: the index of the largest error among the pairs outside the tolerance
+	template <class T>
+	size_t Worst(const T* expected, const T* actual, size_t count, double& error) const
+	{
+		size_t worst = count;
+		error = -1;
+		for(size_t i = 0; i < count; ++i)
+		{
+			if(!Tolerance::Accepts(expected[i], actual[i]) && Tolerance::Error(expected[i], actual[i]) > error)
+			{
+				error = Tolerance::Error(expected[i], actual[i]);
+				worst = i;
+			}
+		}
+		return worst;
+	}
+
+private:
+	Tolerance(Mode mode, double value) : m_mode(mode), m_value(value)	{}
+
+	// the bits as a signed integer which grows with the value (-0 and +0 are both 0)
+	static long long Key(float value)
+	{
+		int bits;
+		memcpy(&bits, &value, sizeof(bits));
+		int magnitude = bits & 0x7fffffff;
+		return (bits < 0) ? -magnitude : magnitude;
+	}
+	static long long Key(double value)
+	{
+		long long bits;
+		memcpy(&bits, &value, sizeof(bits));
+		long long magnitude = bits & 0x7fffffffffffffffLL;
+		return (bits < 0) ? -magnitude : magnitude;
+	}
+
+	template <class T>
+	static unsigned long long Distance(T expected, T actual)
+	{
+		unsigned long long left = static_cast<unsigned long long>(Tolerance::Key(expected));
+		unsigned long long right = static_cast<unsigned long long>(Tolerance::Key(actual));
+		return (Tolerance::Key(expected) >= Tolerance::Key(actual)) ? left - right : right - left;
+	}
+
+	// the tolerance in ULPs, clamped to the widest distance of T
+	template <class T>
+	static unsigned long long MaxUlps(double ulps)
+	{
+		const double widest = (sizeof(T) == 4) ? 4294967295.0 : 18446744073709549568.0;
+		return (ulps >= widest) ? ((sizeof(T) == 4) ? 0xffffffffULL : ~0ULL) : static_cast<unsigned long long>(ulps);
+	}
+
+#if defined(UNITTEST_SSE2)
+	static unsigned Bits(unsigned mask)
+	{
+		mask = mask - ((mask >> 1) & 0x55555555u);
+		mask = (mask & 0x33333333u) + ((mask >> 2) & 0x33333333u);
+		return (((mask + (mask >> 4)) & 0x0f0f0f0fu) * 0x01010101u) >> 24;
+	}
+
+	// the kernels count whole vectors only and return the number of elements they covered
+	template <class T>
+	size_t OutsideVectors(const T* expected, const T* actual, size_t count, size_t& outside) const
+	{
+		const double absolute = (m_mode == AbsoluteError) ? m_value : 0;
+		const double relative = (m_mode == RelativeError) ? m_value : 0;
+		const unsigned long long ulps = Tolerance::MaxUlps<T>(m_value);
+#if defined(UNITTEST_AVX2)
+		if(Collections::HasAvx2())
+		{
+			return (m_mode == UlpDistance) ? Tolerance::UlpsAvx2(expected, actual, count, ulps, outside) :
+											 Tolerance::LinearAvx2(expected, actual, count, static_cast<T>(absolute), static_cast<T>(relative), outside);
+		}
+#endif
+		return (m_mode == UlpDistance) ? Tolerance::UlpsSse2(expected, actual, count, ulps, outside) :
+										 Tolerance::LinearSse2(expected, actual, count, static_cast<T>(absolute), static_cast<T>(relative), outside);
+	}
+
+	// absolute and relative: |e - a| <= absolute + relative * max(|e|, |a|), |e - a| finite, or e == a
+	static size_t LinearSse2(const float* expected, const float* actual, size_t count, float absolute, float relative, size_t& outside)
+	{
+		const __m128 sign = _mm_set1_ps(-0.0f);
+		const __m128 absolutes = _mm_set1_ps(absolute);
+		const __m128 relatives = _mm_set1_ps(relative);
+		const __m128 infinity = _mm_set1_ps(std::numeric_limits<float>::infinity());
+		size_t i = 0;
+		for(; i + 4 <= count; i += 4)
+		{
+			__m128 e = _mm_loadu_ps(expected + i);
+			__m128 a = _mm_loadu_ps(actual + i);
+			__m128 difference = _mm_andnot_ps(sign, _mm_sub_ps(e, a));
+			__m128 limit = _mm_add_ps(absolutes, _mm_mul_ps(relatives, _mm_max_ps(_mm_andnot_ps(sign, e), _mm_andnot_ps(sign, a))));
+			__m128 inside = _mm_or_ps(_mm_and_ps(_mm_cmple_ps(difference, limit), _mm_cmplt_ps(difference, infinity)), _mm_cmpeq_ps(e, a));
+			outside += Tolerance::Bits(~_mm_movemask_ps(inside) & 0xf);
+		}
+		return i;
+	}
+	static size_t LinearSse2(const double* expected, const double* actual, size_t count, double absolute, double relative, size_t& outside)
+	{
+		const __m128d sign = _mm_set1_pd(-0.0);
+		const __m128d absolutes = _mm_set1_pd(absolute);
+		const __m128d relatives = _mm_set1_pd(relative);
+		const __m128d infinity = _mm_set1_pd(std::numeric_limits<double>::infinity());
+		size_t i = 0;
+		for(; i + 2 <= count; i += 2)
+		{
+			__m128d e = _mm_loadu_pd(expected + i);
+			__m128d a = _mm_loadu_pd(actual + i);
+			__m128d difference = _mm_andnot_pd(sign, _mm_sub_pd(e, a));
+			__m128d limit = _mm_add_pd(absolutes, _mm_mul_pd(relatives, _mm_max_pd(_mm_andnot_pd(sign, e), _mm_andnot_pd(sign, a))));
+			__m128d inside = _mm_or_pd(_mm_and_pd(_mm_cmple_pd(difference, limit), _mm_cmplt_pd(difference, infinity)), _mm_cmpeq_pd(e, a));
+			outside += Tolerance::Bits(~_mm_movemask_pd(inside) & 0x3);
+		}
+		return i;
+	}
+
+	// ULPs: the distance of the keys (see Key) - the difference of two keys fits in 32 bits
+	// unsigned; SSE2 has no 64 bit compare, so the double ranges are left to the scalar loop
+	static size_t UlpsSse2(const float* expected, const float* actual, size_t count, unsigned long long ulps, size_t& outside)
+	{
+		const __m128i magnitude = _mm_set1_epi32(0x7fffffff);
+		const __m128i bias = _mm_set1_epi32(std::numeric_limits<int>::min());
+		const __m128i limit = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(static_cast<unsigned>(ulps))), bias);
+		size_t i = 0;
+		for(; i + 4 <= count; i += 4)
+		{
+			__m128 e = _mm_loadu_ps(expected + i);
+			__m128 a = _mm_loadu_ps(actual + i);
+			__m128i left = _mm_castps_si128(e);
+			__m128i right = _mm_castps_si128(a);
+			__m128i leftSign = _mm_srai_epi32(left, 31);
+			__m128i rightSign = _mm_srai_epi32(right, 31);
+			left = _mm_sub_epi32(_mm_xor_si128(_mm_and_si128(left, magnitude), leftSign), leftSign);
+			right = _mm_sub_epi32(_mm_xor_si128(_mm_and_si128(right, magnitude), rightSign), rightSign);
+			__m128i greater = _mm_cmpgt_epi32(left, right);
+			__m128i distance = _mm_or_si128(_mm_and_si128(greater, _mm_sub_epi32(left, right)),
+											_mm_andnot_si128(greater, _mm_sub_epi32(right, left)));
+			__m128i distant = _mm_cmpgt_epi32(_mm_xor_si128(distance, bias), limit);
+			__m128 inside = _mm_or_ps(_mm_andnot_ps(_mm_castsi128_ps(distant), _mm_cmpord_ps(e, a)), _mm_cmpeq_ps(e, a));
+			outside += Tolerance::Bits(~_mm_movemask_ps(inside) & 0xf);
+		}
+		return i;
+	}
+	static size_t UlpsSse2(const double* /*expected*/, const double* /*actual*/, size_t /*count*/, unsigned long long /*ulps*/, size_t& /*outside*/)
+	{
+		return 0;
+	}
+#endif
+
+#if defined(UNITTEST_AVX2)
+	UNITTEST_TARGET_AVX2 static size_t LinearAvx2(const float* expected, const float* actual, size_t count, float absolute, float relative, size_t& outside)
+	{
+		const __m256 sign = _mm256_set1_ps(-0.0f);
+		const __m256 absolutes = _mm256_set1_ps(absolute);
+		const __m256 relatives = _mm256_set1_ps(relative);
+		const __m256 infinity = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+		size_t i = 0;
+		for(; i + 8 <= count; i += 8)
+		{
+			__m256 e = _mm256_loadu_ps(expected + i);
+			__m256 a = _mm256_loadu_ps(actual + i);
+			__m256 difference = _mm256_andnot_ps(sign, _mm256_sub_ps(e, a));
+			__m256 limit = _mm256_add_ps(absolutes, _mm256_mul_ps(relatives, _mm256_max_ps(_mm256_andnot_ps(sign, e), _mm256_andnot_ps(sign, a))));
+			__m256 inside = _mm256_or_ps(_mm256_and_ps(_mm256_cmp_ps(difference, limit, _CMP_LE_OQ), _mm256_cmp_ps(difference, infinity, _CMP_LT_OQ)),
+									   _mm256_cmp_ps(e, a, _CMP_EQ_OQ));
+			outside += Tolerance::Bits(~_mm256_movemask_ps(inside) & 0xff);
+		}
+		return i;
+	}
+	UNITTEST_TARGET_AVX2 static size_t LinearAvx2(const double* expected, const double* actual, size_t count, double absolute, double relative, size_t& outside)
+	{
+		const __m256d sign = _mm256_set1_pd(-0.0);
+		const __m256d absolutes = _mm256_set1_pd(absolute);
+		const __m256d relatives = _mm256_set1_pd(relative);
+		const __m256d infinity = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+		size_t i = 0;
+		for(; i + 4 <= count; i += 4)
+		{
+			__m256d e = _mm256_loadu_pd(expected + i);
+			__m256d a = _mm256_loadu_pd(actual + i);
+			__m256d difference = _mm256_andnot_pd(sign, _mm256_sub_pd(e, a));
+			__m256d limit = _mm256_add_pd(absolutes, _mm256_mul_pd(relatives, _mm256_max_pd(_mm256_andnot_pd(sign, e), _mm256_andnot_pd(sign, a))));
+			__m256d inside = _mm256_or_pd(_mm256_and_pd(_mm256_cmp_pd(difference, limit, _CMP_LE_OQ), _mm256_cmp_pd(difference, infinity, _CMP_LT_OQ)),
+										_mm256_cmp_pd(e, a, _CMP_EQ_OQ));
+			outside += Tolerance::Bits(~_mm256_movemask_pd(inside) & 0xf);
+		}
+		return i;
+	}
+
+	UNITTEST_TARGET_AVX2 static size_t UlpsAvx2(const float* expected, const float* actual, size_t count, unsigned long long ulps, size_t& outside)
+	{
+		const __m256i magnitude = _mm256_set1_epi32(0x7fffffff);
+		const __m256i bias = _mm256_set1_epi32(std::numeric_limits<int>::min());
+		const __m256i limit = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(static_cast<unsigned>(ulps))), bias);
+		size_t i = 0;
+		for(; i + 8 <= count; i += 8)
+		{
+			__m256 e = _mm256_loadu_ps(expected + i);
+			__m256 a = _mm256_loadu_ps(actual + i);
+			__m256i left = _mm256_castps_si256(e);
+			__m256i right = _mm256_castps_si256(a);
+			__m256i leftSign = _mm256_srai_epi32(left, 31);
+			__m256i rightSign = _mm256_srai_epi32(right, 31);
+			left = _mm256_sub_epi32(_mm256_xor_si256(_mm256_and_si256(left, magnitude), leftSign), leftSign);
+			right = _mm256_sub_epi32(_mm256_xor_si256(_mm256_and_si256(right, magnitude), rightSign), rightSign);
+			__m256i distance = _mm256_blendv_epi8(_mm256_sub_epi32(right, left), _mm256_sub_epi32(left, right), _mm256_cmpgt_epi32(left, right));
+			__m256i distant = _mm256_cmpgt_epi32(_mm256_xor_si256(distance, bias), limit);
+			__m256 inside = _mm256_or_ps(_mm256_andnot_ps(_mm256_castsi256_ps(distant), _mm256_cmp_ps(e, a, _CMP_ORD_Q)), _mm256_cmp_ps(e, a, _CMP_EQ_OQ));
+			outside += Tolerance::Bits(~_mm256_movemask_ps(inside) & 0xff);
+		}
+		return i;
+	}
+	UNITTEST_TARGET_AVX2 static size_t UlpsAvx2(const double* expected, const double* actual, size_t count, unsigned long long ulps, size_t& outside)
+	{
+		const __m256i magnitude = _mm256_set1_epi64x(0x7fffffffffffffffLL);
+		const __m256i bias = _mm256_set1_epi64x(std::numeric_limits<long long>::min());
+		const __m256i limit = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(ulps)), bias);
+		const __m256i zero = _mm256_setzero_si256();
+		size_t i = 0;
+		for(; i + 4 <= count; i += 4)
+		{
+			__m256d e = _mm256_loadu_pd(expected + i);
+			__m256d a = _mm256_loadu_pd(actual + i);
+			__m256i left = _mm256_castpd_si256(e);
+			__m256i right = _mm256_castpd_si256(a);
+			__m256i leftSign = _mm256_cmpgt_epi64(zero, left);		// no 64 bit arithmetic shift in AVX2
+			__m256i rightSign = _mm256_cmpgt_epi64(zero, right);
+			left = _mm256_sub_epi64(_mm256_xor_si256(_mm256_and_si256(left, magnitude), leftSign), leftSign);
+			right = _mm256_sub_epi64(_mm256_xor_si256(_mm256_and_si256(right, magnitude), rightSign), rightSign);
+			__m256i distance = _mm256_blendv_epi8(_mm256_sub_epi64(right, left), _mm256_sub_epi64(left, right), _mm256_cmpgt_epi64(left, right));
+			__m256i distant = _mm256_cmpgt_epi64(_mm256_xor_si256(distance, bias), limit);
+			__m256d inside = _mm256_or_pd(_mm256_andnot_pd(_mm256_castsi256_pd(distant), _mm256_cmp_pd(e, a, _CMP_ORD_Q)), _mm256_cmp_pd(e, a, _CMP_EQ_OQ));
+			outside += Tolerance::Bits(~_mm256_movemask_pd(inside) & 0xf);
+		}
+		return i;
+	}
+#endif
+
+	Mode	m_mode;
+	double	m_value;
+};	// Tolerance
+
+///////////////////////////////////////////////////////////////////////////////
+// class Files - the comparison behind FileAssert
+// Two regular files are mapped one window at a time (MADV_SEQUENTIAL, so the kernel reads
+// ahead) and compared with the Collections kernels; each window is unmapped
+// before the next, so a multi-GB golden costs no more than one window of
+// memory. Files of different sizes are compared up to the end of the shorter
+// one, so the failure points at the first differing byte as well. Pipes, devices, /proc files and platforms without mmap are read in
+// blocks instead, with a few rows kept back for the hexdump of a failure.
+///////////////////////////////////////////////////////////////////////////////
+class Files
+{
+public:
+	enum Outcome { Equal, Different, DifferentSize, Unreadable };
+
+	static const unsigned long long NoSize = ~0ULL;	// a stream: the size is not known up front
+
+	struct Comparison
+	{
+		Outcome				outcome;
+		unsigned long long	offset;			// the first differing byte (DifferentSize: or the end of the shorter file)
+		unsigned long long	expectedSize;	// NoSize for a stream
+		unsigned long long	actualSize;
+		bool				expectedFailed;	// Unreadable: which file, and its errno
+		int					error;
+		std::string			expectedDump;	// the rows around 'offset' (failures only)
+		std::string			actualDump;
+	};
+
+	static const size_t Row = 16;				// bytes per hexdump row; one row is printed on each side
+	static const size_t Window = 16 << 20;		// bytes mapped per file and step (a multiple of the page size)
+	static const size_t Block = 1 << 20;		// bytes read per file and step by the stream fallback
+
+	static void Compare(LPCSTR expected, LPCSTR actual, Comparison& comparison)
+	{
+		comparison.outcome = Equal;
+		comparison.offset = 0;
+		comparison.expectedSize = comparison.actualSize = NoSize;
+		comparison.expectedFailed = false;
+		comparison.error = 0;
+#if defined(__linux__)
+		int left = open(expected, O_RDONLY);
+		int right = (left < 0) ? -1 : open(actual, O_RDONLY);
+		if(left < 0 || right < 0)
+		{
+			Files::SetUnreadable(comparison, left < 0);
+			if(left >= 0)
+			{
+				close(left);
+			}
+			return;
+		}
+		if(Files::CompareMapped(left, right, comparison))
+		{
+			close(left);
+			close(right);
+			return;
+		}
+		// the same descriptors - a pipe must not be opened twice
+		FILE* leftFile = fdopen(left, "rb");
+		FILE* rightFile = fdopen(right, "rb");
+		if(!leftFile)
+		{
+			close(left);
+		}
+		if(!rightFile)
+		{
+			close(right);
+		}
+#else
+		FILE* leftFile = fopen(expected, "rb");
+		FILE* rightFile = leftFile ? fopen(actual, "rb") : NULL;
+#endif
+		if(leftFile && rightFile)
+		{
+			Files::CompareStreams(leftFile, rightFile, comparison);
+		}
+		else
+		{
+			Files::SetUnreadable(comparison, !leftFile);
+		}
+		if(leftFile)
+		{
+			fclose(leftFile);
+		}
+		if(rightFile)
+		{
+			fclose(rightFile);
+		}
+	}
+
+	// "00000040  48 65 6c>6f 20 ...  |Hello ...|" - the rows of data[] (file offset 'base') around 'offset',
+	// whose byte is marked with '>' in place of the space before it
+	static std::string Hexdump(const unsigned char* data, size_t size, unsigned long long base, unsigned long long offset)
+	{
+		unsigned long long row = offset - offset % Row;
+		unsigned long long first = std::max(base, (row >= Row) ? row - Row : 0);
+		unsigned long long last = std::max(std::min(base + size, row + 2 * Row), row + 1);	// the marked row even past the end
+		first -= first % Row;
+		std::string text;
+		for(unsigned long long line = first; line < last; line += Row)
+		{
+			char hex[4 * Row + 16], ascii[Row + 1];
+			int length = snprintf(hex, sizeof(hex), "%08llx ", line);
+			for(size_t i = 0; i < Row; ++i)
+			{
+				unsigned long long at = line + i;
+				char mark = (at == offset) ? '>' : ' ';
+				if(at >= base && at < base + size)
+				{
+					unsigned char byte = data[at - base];
+					length += snprintf(hex + length, sizeof(hex) - length, "%c%02x", mark, byte);
+					ascii[i] = (byte >= 0x20 && byte < 0x7f) ? static_cast<char>(byte) : '.';
+				}
+				else
+				{
+					length += snprintf(hex + length, sizeof(hex) - length, "%c  ", mark);
+					ascii[i] = ' ';
+				}
+			}
+			ascii[Row] = '\0';
+			text += (line == first) ? _T("") : _T("\n");
+			text += hex;
+			text += _T("  |");
+			text += ascii;
+			text += _T("|");
+		}
+		return text;
+	}
+
+private:
+	static void SetUnreadable(Comparison& comparison, bool expectedFailed)
+	{
+		comparison.outcome = Unreadable;
+		comparison.expectedFailed = expectedFailed;
+		comparison.error = errno ? errno : EIO;	// a file which got shorter while it was read
+	}
+
+#if defined(__linux__)
+	// false: not two regular files with a size (pipe, device, /proc, empty) - the caller streams them
+	static bool CompareMapped(int left, int right, Comparison& comparison)
+	{
+		struct stat leftStat, rightStat;
+		if(fstat(left, &leftStat) != 0 || fstat(right, &rightStat) != 0 || !S_ISREG(leftStat.st_mode) || !S_ISREG(rightStat.st_mode) ||
+		   leftStat.st_size == 0 || rightStat.st_size == 0)
+		{
+			return false;
+		}
+		comparison.expectedSize = static_cast<unsigned long long>(leftStat.st_size);
+		comparison.actualSize = static_cast<unsigned long long>(rightStat.st_size);
+		unsigned long long size = std::min(comparison.expectedSize, comparison.actualSize);	// the common prefix
+		for(unsigned long long start = 0; start < size; start += Window)
+		{
+			size_t bytes = static_cast<size_t>(std::min<unsigned long long>(Window, size - start));
+			void* leftData = mmap(NULL, bytes, PROT_READ, MAP_PRIVATE, left, static_cast<off_t>(start));
+			void* rightData = (leftData == MAP_FAILED) ? MAP_FAILED : mmap(NULL, bytes, PROT_READ, MAP_PRIVATE, right, static_cast<off_t>(start));
+			if(rightData == MAP_FAILED)
+			{
+				if(leftData != MAP_FAILED)
+				{
+					munmap(leftData, bytes);
+				}
+				if(start > 0)
+				{	// the first windows were equal - read the rest instead
+					return Files::CompareDescriptors(left, right, start, comparison);
+				}
+				return false;
+			}
+			madvise(leftData, bytes, MADV_SEQUENTIAL);
+			madvise(rightData, bytes, MADV_SEQUENTIAL);
+			size_t index = Collections::Mismatch(static_cast<const unsigned char*>(leftData), static_cast<const unsigned char*>(rightData), bytes);
+			munmap(leftData, bytes);
+			munmap(rightData, bytes);
+			if(index < bytes)
+			{
+				Files::SetDifferent(left, right, start + index, comparison);
+				return true;
+			}
+		}
+		if(comparison.expectedSize != comparison.actualSize)
+		{	// the shorter file is the start of the longer one
+			Files::SetDifferent(left, right, size, comparison);
+		}
+		return true;
+	}
+
+	// the regular files whose windows could not all be mapped, read from 'start' on
+	static bool CompareDescriptors(int left, int right, unsigned long long start, Comparison& comparison)
+	{
+		unsigned char* leftBlock = static_cast<unsigned char*>(malloc(2 * Block));
+		if(!leftBlock)
+		{
+			return false;
+		}
+		unsigned char* rightBlock = leftBlock + Block;
+		const unsigned long long size = std::min(comparison.expectedSize, comparison.actualSize);
+		for(unsigned long long offset = start; offset < size; offset += Block)
+		{
+			size_t bytes = static_cast<size_t>(std::min<unsigned long long>(Block, size - offset));
+			if(pread(left, leftBlock, bytes, static_cast<off_t>(offset)) != static_cast<ssize_t>(bytes) ||
+			   pread(right, rightBlock, bytes, static_cast<off_t>(offset)) != static_cast<ssize_t>(bytes))
+			{
+				free(leftBlock);
+				Files::SetUnreadable(comparison, false);
+				return true;
+			}
+			size_t index = Collections::Mismatch(leftBlock, rightBlock, bytes);
+			if(index < bytes)
+			{
+				free(leftBlock);
+				Files::SetDifferent(left, right, offset + index, comparison);
+				return true;
+			}
+		}
+		free(leftBlock);
+		if(comparison.expectedSize != comparison.actualSize)
+		{
+			Files::SetDifferent(left, right, size, comparison);
+		}
+		return true;
+	}
+
+	// the first difference of two regular files - DifferentSize whenever the sizes differ
+	static void SetDifferent(int left, int right, unsigned long long offset, Comparison& comparison)
+	{
+		comparison.outcome = (comparison.expectedSize != comparison.actualSize) ? DifferentSize : Different;
+		comparison.offset = offset;
+		Files::Dump(left, right, comparison);
+	}
+
+	// the failure rows of two regular files, read again around the offset
+	static void Dump(int left, int right, Comparison& comparison)
+	{
+		Allocations::Ignore ignore;
+		unsigned long long base = comparison.offset - comparison.offset % Row;
+		base = (base >= Row) ? base - Row : 0;
+		unsigned char leftRows[3 * Row], rightRows[3 * Row];
+		ssize_t leftBytes = pread(left, leftRows, sizeof(leftRows), static_cast<off_t>(base));
+		ssize_t rightBytes = pread(right, rightRows, sizeof(rightRows), static_cast<off_t>(base));
+		comparison.expectedDump = Files::Hexdump(leftRows, (leftBytes > 0) ? leftBytes : 0, base, comparison.offset);
+		comparison.actualDump = Files::Hexdump(rightRows, (rightBytes > 0) ? rightBytes : 0, base, comparison.offset);
+	}
+#endif
+
+	// the fallback: both files read in blocks through unbuffered stdio; the last two rows of the
+	// previous block stay in front of the next one for the hexdump
+	static void CompareStreams(FILE* left, FILE* right, Comparison& comparison)
+	{
+		const size_t history = 2 * Row, buffer = history + Block + 2 * Row;
+		unsigned char* leftBuffer = static_cast<unsigned char*>(malloc(2 * buffer));
+		if(!leftBuffer)
+		{
+			Files::SetUnreadable(comparison, true);
+			return;
+		}
+		unsigned char* rightBuffer = leftBuffer + buffer;
+		setvbuf(left, NULL, _IONBF, 0);
+		setvbuf(right, NULL, _IONBF, 0);
+		unsigned long long offset = 0;		// the file offset of the first byte after the history
+		size_t kept = 0;
+		for(;;)
+		{
+			size_t leftBytes = fread(leftBuffer + history, 1, Block, left);
+			size_t rightBytes = fread(rightBuffer + history, 1, Block, right);
+			if(ferror(left) || ferror(right))
+			{
+				Files::SetUnreadable(comparison, ferror(left) != 0);
+				break;
+			}
+			size_t bytes = std::min(leftBytes, rightBytes);
+			size_t index = Collections::Mismatch(leftBuffer + history, rightBuffer + history, bytes);
+			if(index < bytes || leftBytes != rightBytes)
+			{	// a difference, or one file ended first: the row after it is read for the hexdump
+				comparison.outcome = (index < bytes) ? Different : DifferentSize;
+				comparison.offset = offset + index;
+				if(leftBytes == Block)
+				{
+					leftBytes += fread(leftBuffer + history + Block, 1, 2 * Row, left);
+				}
+				if(rightBytes == Block)
+				{
+					rightBytes += fread(rightBuffer + history + Block, 1, 2 * Row, right);
+				}
+				Allocations::Ignore ignore;
+				comparison.expectedDump = Files::Hexdump(leftBuffer + history - kept, kept + leftBytes, offset - kept, comparison.offset);
+				comparison.actualDump = Files::Hexdump(rightBuffer + history - kept, kept + rightBytes, offset - kept, comparison.offset);
+				break;
+			}
+			if(bytes < Block)
+			{
+				break;
+			}
+			memmove(leftBuffer, leftBuffer + Block, history);
+			memmove(rightBuffer, rightBuffer + Block, history);
+			offset += Block;
+			kept = history;
+		}
+		free(leftBuffer);
+	}
+};	// Files
+
+///////////////////////////////////////////////////////////////////////////////
+// class Directories - the comparison behind DirectoryAssert
+// Both trees are listed and sorted by relative path first, so every missing,
+// extra or retyped path and every size mismatch is known before a byte is
+// read. The files left over (same path, same size) are compared by Files on
+// a pool of threads, the largest first; each thread claims the next pair from
+// a shared counter. A directory which is missing on one side is reported once,
+// not once per file below it.
+///////////////////////////////////////////////////////////////////////////////
+class Directories
+{
+public:
+	enum Kind { Missing, Extra, Type, Size, Content, Unreadable };
+
+	struct Difference
+	{
+		Kind				kind;
+		std::string			path;		// relative and '/' separated, empty for a root
+		unsigned long long	expected;	// Size: the sizes; Content: the offset of the first difference in both
+		unsigned long long	actual;
+		bool				expectedSide;	// Unreadable: which tree, and its errno
+		int					error;
+
+		bool operator<(const Difference& other) const	{ return Directories::Order(path, other.path) < 0; }
+	};
+
+	// the number of paths in both trees together; the differences are in path order
+	static size_t Compare(LPCSTR expected, LPCSTR actual, std::vector<Difference>& differences, unsigned threads = 0)
+	{
+		std::vector<Entry> left, right;
+		Directories::List(expected, std::string(), true, left, differences);
+		Directories::List(actual, std::string(), false, right, differences);
+		for(size_t k = 0; k < differences.size(); ++k)
+		{
+			if(differences[k].path.empty())
+			{	// a root which cannot be listed: the other tree would be nothing but extra paths
+				return left.size() + right.size();
+			}
+		}
+		std::sort(left.begin(), left.end());
+		std::sort(right.begin(), right.end());
+		std::vector<std::string> unreadable;	// already reported - the other side is not listed as missing/extra there
+		for(size_t k = 0; k < differences.size(); ++k)
+		{
+			unreadable.push_back(differences[k].path);
+		}
+
+		std::vector<Pair> pairs;	// the files whose content decides
+		std::string skip;			// a directory missing on one side - the paths below it are not listed
+		size_t i = 0, j = 0;
+		while(i < left.size() || j < right.size())
+		{
+			int order = (i == left.size()) ? 1 : (j == right.size()) ? -1 : Directories::Order(left[i].path, right[j].path);
+			const Entry& entry = (order <= 0) ? left[i] : right[j];
+			if(order != 0)
+			{
+				if((skip.empty() || entry.path.compare(0, skip.size(), skip) != 0) && !Directories::Below(entry.path, unreadable))
+				{
+					Directories::Add(differences, (order < 0) ? Missing : Extra, entry.path, 0, 0);
+					skip = (entry.type == 'd') ? entry.path + _T("/") : std::string();
+				}
+				if(order < 0)
+				{
+					++i;
+				}
+				else
+				{
+					++j;
+				}
+				continue;
+			}
+			if(left[i].type != right[j].type)
+			{	// a directory against a file: the entries below the directory are not listed either
+				Directories::Add(differences, Type, entry.path, left[i].type, right[j].type);
+				skip = entry.path + _T("/");
+			}
+			else if(left[i].type == 'f' && left[i].size != right[j].size)
+			{
+				Directories::Add(differences, Size, entry.path, left[i].size, right[j].size);
+			}
+			else if(left[i].type == 'f')
+			{
+				Pair pair = { &left[i], left[i].size };
+				pairs.push_back(pair);
+			}
+			++i;
+			++j;
+		}
+
+		std::sort(pairs.begin(), pairs.end());
+		std::vector<Files::Comparison> results(pairs.size());
+		Directories::Run(expected, actual, pairs, results, threads);
+		for(size_t k = 0; k < pairs.size(); ++k)
+		{
+			const Files::Comparison& result = results[k];
+			if(result.outcome == Files::Different)
+			{
+				Directories::Add(differences, Content, pairs[k].entry->path, result.offset, result.offset);
+			}
+			else if(result.outcome == Files::DifferentSize)
+			{	// changed since it was listed
+				Directories::Add(differences, Size, pairs[k].entry->path, result.expectedSize, result.actualSize);
+			}
+			else if(result.outcome == Files::Unreadable)
+			{
+				Difference difference = { Unreadable, pairs[k].entry->path, 0, 0, result.expectedFailed, result.error };
+				differences.push_back(difference);
+			}
+		}
+		std::stable_sort(differences.begin(), differences.end());
+		return left.size() + right.size();
+	}
+
+private:
+	struct Entry
+	{
+		std::string			path;
+		unsigned long long	size;
+		char				type;	// 'f' file, 'd' directory, 'o' anything else (device, socket, dangling link)
+
+		bool operator<(const Entry& other) const	{ return Directories::Order(path, other.path) < 0; }
+	};
+	struct Pair
+	{
+		const Entry*		entry;
+		unsigned long long	size;
+
+		bool operator<(const Pair& other) const	{ return size > other.size; }	// the largest first
+	};
+
+	static void Add(std::vector<Difference>& differences, Kind kind, const std::string& path, unsigned long long expected, unsigned long long actual)
+	{
+		Difference difference = { kind, path, expected, actual, false, 0 };
+		differences.push_back(difference);
+	}
+
+	// 'path' is one of 'roots' or lies below one (the few paths which could not be read)
+	static bool Below(const std::string& path, const std::vector<std::string>& roots)
+	{
+		for(size_t i = 0; i < roots.size(); ++i)
+		{
+			const std::string& root = roots[i];
+			if(path.compare(0, root.size(), root) == 0 && (path.size() == root.size() || path[root.size()] == '/'))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// path order with '/' before any other character, so a directory is followed by its own
+	// entries ("a", "a/x", "a-b" - not "a", "a-b", "a/x")
+	static int Order(const std::string& left, const std::string& right)
+	{
+		size_t count = std::min(left.size(), right.size());
+		for(size_t i = 0; i < count; ++i)
+		{
+			if(left[i] != right[i])
+			{
+				int leftRank = (left[i] == '/') ? 0 : static_cast<unsigned char>(left[i]) + 1;
+				int rightRank = (right[i] == '/') ? 0 : static_cast<unsigned char>(right[i]) + 1;
+				return leftRank - rightRank;
+			}
+		}
+		return (left.size() < right.size()) ? -1 : (left.size() > right.size()) ? 1 : 0;
+	}
+
+	// the entries below root/relative, recursively; a symbolic link is listed as its target,
+	// but a linked directory is not entered
+	static void List(const std::string& root, const std::string& relative, bool expectedSide,
+					 std::vector<Entry>& entries, std::vector<Difference>& differences)
+	{
+		std::string directory = relative.empty() ? root : root + _T("/") + relative;
+		std::vector<std::string> subdirectories;
+#if defined(__linux__)
+		DIR* handle = opendir(directory.c_str());
+		if(!handle)
+		{
+			Difference difference = { Unreadable, relative, 0, 0, expectedSide, errno };
+			differences.push_back(difference);
+			return;
+		}
+		while(struct dirent* item = readdir(handle))
+		{
+			if(strcmp(item->d_name, ".") == 0 || strcmp(item->d_name, "..") == 0)
+			{
+				continue;
+			}
+			Entry entry = { relative.empty() ? std::string(item->d_name) : relative + _T("/") + item->d_name, 0, 'o' };
+			struct stat status;
+			bool link = false;
+			if(fstatat(dirfd(handle), item->d_name, &status, AT_SYMLINK_NOFOLLOW) != 0)
+			{	// a directory without search permission, or the entry was removed since readdir
+				Difference difference = { Unreadable, entry.path, 0, 0, expectedSide, errno };
+				differences.push_back(difference);
+				continue;
+			}
+			if(S_ISLNK(status.st_mode))
+			{
+				link = true;
+				if(fstatat(dirfd(handle), item->d_name, &status, 0) != 0)
+				{
+					status.st_mode = 0;		// dangling
+				}
+			}
+			entry.type = S_ISREG(status.st_mode) ? 'f' : S_ISDIR(status.st_mode) ? 'd' : 'o';
+			entry.size = (entry.type == 'f') ? static_cast<unsigned long long>(status.st_size) : 0;
+			if(entry.type == 'd' && !link)
+			{
+				subdirectories.push_back(entry.path);
+			}
+			entries.push_back(entry);
+		}
+		closedir(handle);
+#elif defined(_WIN32)
+		WIN32_FIND_DATAA item;
+		HANDLE handle = FindFirstFileA((directory + _T("\\*")).c_str(), &item);
+		if(handle == INVALID_HANDLE_VALUE)
+		{
+			DWORD error = GetLastError();
+			Difference difference = { Unreadable, relative, 0, 0, expectedSide,
+									  (error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND) ? ENOENT : EACCES };
+			differences.push_back(difference);
+			return;
+		}
+		do
+		{
+			if(strcmp(item.cFileName, ".") == 0 || strcmp(item.cFileName, "..") == 0)
+			{
+				continue;
+			}
+			Entry entry = { relative.empty() ? std::string(item.cFileName) : relative + _T("/") + item.cFileName, 0, 'f' };
+			if(item.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+			{
+				entry.type = 'd';
+				if(!(item.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT))
+				{
+					subdirectories.push_back(entry.path);
+				}
+			}
+			else
+			{
+				entry.size = (static_cast<unsigned long long>(item.nFileSizeHigh) << 32) | item.nFileSizeLow;
+			}
+			entries.push_back(entry);
+		}
+		while(FindNextFileA(handle, &item));
+		FindClose(handle);
+#endif
+		for(size_t i = 0; i < subdirectories.size(); ++i)
+		{
+			Directories::List(root, subdirectories[i], expectedSide, entries, differences);
+		}
+	}
+
+	// the content comparisons on 'threads' threads (0: hardware_concurrency), at most one per pair
+	static void Run(const std::string& expected, const std::string& actual, const std::vector<Pair>& pairs,
+					std::vector<Files::Comparison>& results, unsigned threads)
+	{
+		if(threads == 0)
+		{
+			threads = std::thread::hardware_concurrency();
+		}
+		if(threads == 0 || threads > pairs.size())
+		{
+			threads = pairs.empty() ? 1 : static_cast<unsigned>(pairs.size());
+		}
+		std::atomic<size_t> next(0);
+		if(threads == 1)
+		{
+			Directories::Worker(expected, actual, pairs, results, next);
+			return;
+		}
+		std::vector<std::thread> workers;
+		for(unsigned i = 0; i < threads; ++i)
+		{
+			workers.push_back(std::thread(&Directories::Worker, std::cref(expected), std::cref(actual), std::cref(pairs), std::ref(results), std::ref(next)));
+		}
+		for(size_t i = 0; i < workers.size(); ++i)
+		{
+			workers[i].join();
+		}
+	}
+
+	static void Worker(const std::string& expected, const std::string& actual, const std::vector<Pair>& pairs,
+					   std::vector<Files::Comparison>& results, std::atomic<size_t>& next)
+	{
+		for(size_t k = next++; k < pairs.size(); k = next++)
+		{
+			const std::string& path = pairs[k].entry->path;
+			Files::Compare((expected + _T("/") + path).c_str(), (actual + _T("/") + path).c_str(), results[k]);
+		}
+	}
+};	// Directories
+
+///////////////////////////////////////////////////////////////////////////////
+// class Diff - the Expected / Actual text of a failure, bounded
+// A value is kept as a view when it is a string, or printed into a small
+// buffer, or when it does not fit there into a Capture which keeps the first
+// characters and only counts the rest, so a failure never copies a large value. Two values which fit the byte budget together
+// are printed whole, as always. Otherwise the first divergence is found with
+// the Collections kernel and each value is shown as an excerpt around it;
+// when the values are text with lines, a Myers diff of the lines around the
+// divergence follows (at most MaxLines lines per side and MaxEdits edits, so
+// time and memory do not grow with the values), clipped to the budget.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef UNITTEST_FAILURE_BYTES
+#define UNITTEST_FAILURE_BYTES	4096	// the default of --failure-bytes
+#endif
+
+class Diff
+{
+public:
+	static constexpr size_t MaxLines = 1000;	// lines per side in the diff region
+	static constexpr size_t MaxEdits = 200;		// edit distance the diff searches before it gives up
+	static constexpr size_t Context = 3;		// unchanged lines around a change
+
+	// the bytes of the Expected and Actual text in one failure: --failure-bytes N or UNITTEST_FAILURE_BYTES
+	static size_t& Budget()
+	{
+		static size_t budget = UNITTEST_FAILURE_BYTES;
+		return budget;
+	}
+
+	// a value as text: a view of a string, or the first characters of a printed value
+	struct Text
+	{
+		const char*			data;
+		size_t				size;
+		unsigned long long	length;		// of the whole value - more than 'size' when the print was cut off
+		char				buffer[256];	// the printed characters of a value which is not a string...
+		std::string			storage;	// ...or, when they do not fit, the first ones
+
+		Text() : data(NULL), size(0), length(0)	{}
+
+	private:
+		Text(const Text&);		// 'data' may point into 'buffer'
+	};
+
+	// an ostream target which keeps the first 'limit' characters
+	class Capture : public std::streambuf
+	{
+	public:
+		Capture(std::string& storage, size_t limit) : m_storage(storage), m_limit(limit), m_length(0)	{}
+
+		unsigned long long Length() const	{ return m_length; }
+
+	protected:
+		virtual int_type overflow(int_type c)
+		{
+			if(c != traits_type::eof())
+			{
+				char character = traits_type::to_char_type(c);
+				Capture::xsputn(&character, 1);
+			}
+			return traits_type::not_eof(c);
+		}
+		virtual std::streamsize xsputn(const char* data, std::streamsize count)
+		{
+			size_t room = m_limit - m_storage.size();
+			m_storage.append(data, std::min(room, static_cast<size_t>(count)));
+			m_length += count;
+			return count;
+		}
+
+	private:
+		std::string&		m_storage;
+		size_t				m_limit;
+		unsigned long long	m_length;
+	};
+
+	// strings are viewed, anything else is printed (see ValueFormatter) up to a few budgets
+	static void Render(const std::string& value, Text& text)
+	{
+		Diff::View(value.data(), value.size(), text);
+	}
+	static void Render(std::string_view value, Text& text)
+	{
+		Diff::View(value.data(), value.size(), text);
+	}
+	static void Render(const char* value, Text& text)
+	{
+		(value) ? Diff::View(value, strlen(value), text) : Diff::View(_T("(null)"), 6, text);
+	}
+	static void Render(char* value, Text& text)
+	{
+		Diff::Render(const_cast<const char*>(value), text);
+	}
+	template <size_t Size>
+	static void Render(const char (&value)[Size], Text& text)
+	{
+		Diff::View(value, strnlen(value, Size), text);
+	}
+	template <class T>
+	static void Render(const T& value, Text& text)
+	{
+		Diff::Print(&Expression::Print<T>, &value, text);
+	}
+	// a CHECK operand: its viewer when it is a string (true), else its printer
+	static bool Render(Expression::Printer printer, Expression::Viewer viewer, const void* value, Text& text)
+	{
+		const char* data;
+		size_t size;
+		if(viewer && viewer(value, data, size))
+		{
+			Diff::View(data, size, text);
+			return true;
+		}
+		Diff::Print(printer, value, text);
+		return false;
+	}
+
+	// both whole and within the budget - printed as they are
+	static bool Fits(const Text& expected, const Text& actual)
+	{
+		return expected.size == expected.length && actual.size == actual.length && expected.length + actual.length <= Diff::Budget();
+	}
+
+	// the index of the first character which differs (the shorter length if one is a prefix of the other)
+	static size_t Divergence(const Text& expected, const Text& actual)
+	{
+		return Collections::Mismatch(expected.data, actual.data, std::min(expected.size, actual.size));
+	}
+
+	// "Expected: '...'" and "Actual:   '...'" - excerpts and the line diff when the values do not fit
+	static void Format(std::string& message, const Text& expected, const Text& actual)
+	{
+		if(Diff::Fits(expected, actual))
+		{	// appended as they are - no stream
+			message.append(_T("Expected: '")).append(expected.data, expected.size).append(_T("'\n"));
+			message.append(_T("Actual:   '")).append(actual.data, actual.size).append(_T("'\n"));
+			return;
+		}
+		size_t at = Diff::Divergence(expected, actual);
+		std::ostringstream ostr;
+		ostr << _T("Expected: '") << Diff::Excerpt(expected, at) << _T("' (") << expected.length << _T(" chars)") << std::endl
+			 << _T("Actual:   '") << Diff::Excerpt(actual, at) << _T("' (") << actual.length << _T(" chars)") << std::endl;
+		Diff::Describe(ostr, expected, actual, at);
+		message += ostr.str();
+	}
+
+	// the line "First difference at offset N (line L, column C)" and the line diff below it
+	static void Describe(std::ostream& ostr, const Text& expected, const Text& actual, size_t at)
+	{
+		if(at == std::min(expected.size, actual.size) && expected.size < expected.length && actual.size < actual.length)
+		{
+			ostr << _T("First difference after the ") << at << _T(" characters which were printed") << std::endl;
+			return;
+		}
+		const char* lineStart = expected.data;
+		size_t line = 1;
+		for(const char* next; (next = static_cast<const char*>(memchr(lineStart, '\n', expected.data + at - lineStart))) != NULL; ++line)
+		{
+			lineStart = next + 1;
+		}
+		ostr << _T("First difference at offset ") << at << _T(" (line ") << line << _T(", column ") << (expected.data + at - lineStart) + 1 << _T(")") << std::endl;
+		if(memchr(expected.data, '\n', expected.size) || memchr(actual.data, '\n', actual.size))
+		{
+			Diff::Lines(ostr, expected, actual, static_cast<size_t>(lineStart - expected.data), line);
+		}
+	}
+
+	// the characters around 'at' on one line: control characters escaped, "..." where the value goes on
+	static std::string Excerpt(const Text& text, size_t at)
+	{
+		size_t width = std::max<size_t>(32, Diff::Budget() / 8);
+		size_t first = at - std::min(at, width / 4);
+		size_t last = std::min(text.size, first + width);
+		std::string excerpt = (first > 0) ? _T("...") : _T("");
+		Diff::Escape(excerpt, text.data + first, last - first);
+		if(last < text.length)
+		{
+			excerpt += _T("...");
+		}
+		return excerpt;
+	}
+
+private:
+	struct Line
+	{
+		const char*		data;
+		size_t			size;
+		unsigned		hash;
+
+		bool operator==(const Line& other) const
+		{
+			return hash == other.hash && size == other.size && memcmp(data, other.data, size) == 0;
+		}
+	};
+
+	// the printed prefix is a few budgets: enough for an excerpt and a diff of it
+	static size_t Limit()
+	{
+		return std::max<size_t>(64 * 1024, 4 * Diff::Budget());
+	}
+
+	static void View(const char* data, size_t size, Text& text)
+	{
+		text.data = data;
+		text.size = size;
+		text.length = size;
+	}
+	// into the buffer of the text, and once more through a Capture when it does not fit
+	static void Print(Expression::Printer printer, const void* value, Text& text)
+	{
+		FormatBuffer out(text.buffer, sizeof(text.buffer));
+		printer(out, value);
+		if(out.Length() <= out.Size())
+		{
+			Diff::View(text.buffer, out.Size(), text);
+			return;
+		}
+		Capture capture(text.storage, Diff::Limit());
+		FormatBuffer more(text.buffer, sizeof(text.buffer), &capture);
+		printer(more, value);
+		more.Flush();
+		text.data = text.storage.data();
+		text.size = text.storage.size();
+		text.length = capture.Length();
+	}
+
+	static void Escape(std::string& out, const char* data, size_t size)
+	{
+		for(size_t i = 0; i < size; ++i)
+		{
+			unsigned char c = static_cast<unsigned char>(data[i]);
+			if(c == '\n')
+			{
+				out += _T("\\n");
+			}
+			else if(c == '\t')
+			{
+				out += _T("\\t");
+			}
+			else if(c == '\r')
+			{
+				out += _T("\\r");
+			}
+			else if(c < 0x20 || c == 0x7f)
+			{
+				char hex[8];
+				snprintf(hex, sizeof(hex), "\\x%02x", c);
+				out += hex;
+			}
+			else
+			{
+				out += static_cast<char>(c);
+			}
+		}
+	}
+
+	// up to MaxLines lines from 'start', which is the start of line 'number'; 'context' lines before it
+	static size_t Split(const Text& text, size_t start, size_t context, std::vector<Line>& lines)
+	{
+		size_t skipped = 0;		// the context lines taken from before 'start'
+		while(skipped < context && start > 0)
+		{
+			const char* data = text.data;
+			size_t previous = start - 1;	// the '\n' which ends the line before
+			while(previous > 0 && data[previous - 1] != '\n')
+			{
+				--previous;
+			}
+			start = previous;
+			++skipped;
+		}
+		size_t position = start;
+		while(position < text.size && lines.size() < MaxLines)
+		{
+			const char* end = static_cast<const char*>(memchr(text.data + position, '\n', text.size - position));
+			size_t size = end ? static_cast<size_t>(end - (text.data + position)) : text.size - position;
+			Line line = { text.data + position, size, 2166136261u };
+			for(size_t i = 0; i < size; ++i)
+			{
+				line.hash = (line.hash ^ static_cast<unsigned char>(line.data[i])) * 16777619u;
+			}
+			lines.push_back(line);
+			position += size + 1;
+		}
+		return skipped;
+	}
+
+	// the Myers edit script of two line ranges as '=' '-' '+' in order; false if it has more than MaxEdits edits
+	static bool Script(const std::vector<Line>& left, const std::vector<Line>& right, std::string& script)
+	{
+		const int n = static_cast<int>(left.size()), m = static_cast<int>(right.size());
+		const int limit = static_cast<int>(std::min<size_t>(MaxEdits, left.size() + right.size()));
+		const int width = 2 * limit + 1;
+		std::vector<int> v(width + 2, 0), trace;
+		int edits = -1;
+		for(int d = 0; d <= limit && edits < 0; ++d)
+		{
+			for(int k = -d; k <= d; k += 2)
+			{
+				int x = (k == -d || (k != d && v[limit + k - 1] < v[limit + k + 1])) ? v[limit + k + 1] : v[limit + k - 1] + 1;
+				int y = x - k;
+				while(x < n && y < m && left[x] == right[y])
+				{
+					++x;
+					++y;
+				}
+				v[limit + k] = x;
+				if(x >= n && y >= m)
+				{
+					edits = d;
+					break;
+				}
+			}
+			trace.insert(trace.end(), v.begin(), v.begin() + width);
+		}
+		if(edits < 0)
+		{
+			return false;
+		}
+		int x = n, y = m;
+		for(int d = edits; d > 0; --d)
+		{	// back from the end: the diagonal run into (x, y), then the one edit of step d
+			const int* previous = &trace[(d - 1) * width];
+			int k = x - y;
+			bool insert = (k == -d || (k != d && previous[limit + k - 1] < previous[limit + k + 1]));
+			int fromX = previous[limit + (insert ? k + 1 : k - 1)];
+			int runX = insert ? fromX : fromX + 1;
+			for(; x > runX; --x, --y)
+			{
+				script += '=';
+			}
+			script += insert ? '+' : '-';
+			x = fromX;
+			y = fromX - (insert ? k + 1 : k - 1);
+		}
+		for(; x > 0; --x)
+		{
+			script += '=';
+		}
+		std::reverse(script.begin(), script.end());
+		return true;
+	}
+
+	// the region around the first difference as a unified diff, clipped to the budget
+	static void Lines(std::ostream& ostr, const Text& expected, const Text& actual, size_t start, size_t number)
+	{
+		std::vector<Line> left, right;
+		size_t skipped = Diff::Split(expected, start, Context, left);
+		Diff::Split(actual, start, Context, right);
+		size_t suffix = 0;		// the equal lines at the end of both regions which are not context
+		while(suffix < left.size() && suffix < right.size() && left[left.size() - 1 - suffix] == right[right.size() - 1 - suffix])
+		{
+			++suffix;
+		}
+		suffix = (suffix > Context) ? suffix - Context : 0;
+		left.resize(left.size() - suffix);
+		right.resize(right.size() - suffix);
+
+		std::string script;
+		if(!Diff::Script(left, right, script))
+		{	// too different to align: both regions, one after the other
+			script.assign(left.size(), '-');
+			script.append(right.size(), '+');
+		}
+		std::vector<size_t> distance(script.size(), Context + 1);	// to the nearest change, up to Context + 1
+		for(size_t s = 0, last = script.size(); s < script.size(); ++s)
+		{
+			last = (script[s] != '=') ? s : last;
+			distance[s] = (last <= s) ? std::min(distance[s], s - last) : distance[s];
+		}
+		for(size_t s = script.size(), last = script.size(); s-- > 0; )
+		{
+			last = (script[s] != '=') ? s : last;
+			distance[s] = (last < script.size()) ? std::min(distance[s], last - s) : distance[s];
+		}
+
+		size_t first = number - skipped;
+		ostr << _T("@@ -") << first << _T(",") << left.size() << _T(" +") << first << _T(",") << right.size() << _T(" @@");
+		size_t budget = Diff::Budget(), written = 0, width = std::max<size_t>(80, budget / 8);
+		size_t i = 0, j = 0;
+		std::string row;
+		for(size_t s = 0; s < script.size(); ++s)
+		{
+			if(distance[s] > Context)
+			{	// a run of unchanged lines away from any change
+				size_t run = s;
+				while(run < script.size() && distance[run] > Context)
+				{
+					++run;
+				}
+				ostr << std::endl << _T("  ... (") << run - s << _T(" unchanged lines)");
+				i += run - s;
+				j += run - s;
+				s = run - 1;
+				continue;
+			}
+			const Line& line = (script[s] == '+') ? right[j] : left[i];
+			row.assign(1, (script[s] == '=') ? ' ' : script[s]);
+			row += ' ';
+			Diff::Escape(row, line.data, std::min(line.size, width));
+			if(line.size > width)
+			{
+				row += _T("...");
+			}
+			if(written + row.size() > budget)
+			{
+				ostr << std::endl << _T("... (diff clipped at ") << budget << _T(" bytes)") << std::endl;
+				return;
+			}
+			ostr << std::endl << row;
+			written += row.size() + 1;
+			i += (script[s] != '+') ? 1 : 0;
+			j += (script[s] != '-') ? 1 : 0;
+		}
+		if(left.size() == MaxLines || right.size() == MaxLines)
+		{
+			ostr << std::endl << _T("... (the diff ends after ") << MaxLines << _T(" lines)");
+		}
+		ostr << std::endl;
+	}
+};	// Diff
+
+///////////////////////////////////////////////////////////////////////////////
+// class Patterns - the compiled regular expressions of IsMatch, by pattern text
+// A pattern is compiled once, the first time it is used, and kept for the run,
+// so an IsMatch in a loop costs one lookup and the match. The expressions are
+// never erased, so a match runs outside the lock on a stable object.
+///////////////////////////////////////////////////////////////////////////////
+class Patterns
+{
+public:
+	// the expression of 'pattern' - NULL and the reason when it does not compile
+	static const std::regex* Find(std::string_view pattern, std::string& error)
+	{
+		std::lock_guard<std::mutex> guard(Patterns::Lock());
+		Table& table = Patterns::Compiled();
+		Table::iterator found = table.find(pattern);
+		if(found == table.end())
+		{
+			Entry entry;
+			try
+			{
+				entry.expression.assign(pattern.data(), pattern.size());
+				entry.valid = true;
+			}
+			catch(const std::regex_error& exception)
+			{
+				entry.error = exception.what();
+				entry.valid = false;
+			}
+			found = table.emplace(std::string(pattern), std::move(entry)).first;
+		}
+		if(!found->second.valid)
+		{
+			error = found->second.error;
+			return NULL;
+		}
+		return &found->second.expression;
+	}
+
+private:
+	struct Entry
+	{
+		std::regex		expression;
+		std::string		error;
+		bool			valid;
+	};
+	typedef std::map<std::string, Entry, std::less<> > Table;	// std::less<> finds a string_view without a copy
+
+	static Table& Compiled()
+	{
+		static Table table;
+		return table;
+	}
+	static std::mutex& Lock()
+	{
+		static std::mutex lock;
+		return lock;
+	}
+};	// Patterns
+
+///////////////////////////////////////////////////////////////////////////////
+// class Assert implements all compare methods
+// Each method with a message has a Site form, which the macros call; the
+// (throws, file, line) form builds the Site of a direct call on the fly.
+///////////////////////////////////////////////////////////////////////////////
+class Assert
+{
+public:
+	///////////////////////////////////////////////////////////////////////////
+	// Equality Asserts - These methods test whether the two arguments are equal.
+	// Overloaded methods are provided for null terminated strings
+	///////////////////////////////////////////////////////////////////////////
+	template <class T1, class T2>
+	static void AreEqual(const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreEqual(expected, actual, NULL, throws, file, line);
+	}
+
+	template <class T1, class T2>
+	static void AreEqual(const T1& expected, const T2& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreEqual(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	template <class T1, class T2>
+	static void AreEqual(const T1& expected, const T2& actual, const Site& site)
+	{	// the same two steps as the form without a site: a char array is compared as a string
+		Assert::AreEqual(expected, actual, NULL, site);
+	}
+	template <class T1, class T2>
+	static void AreEqual(const T1& expected, const T2& actual, LPCTSTR message, const Site& site)
+	{
+		Assert::Test( (expected == actual), message, 
+			/*[PASS]*/ _T("AreEqual: Expression was equal"),
+			/*[FAIL]*/ _T("AreEqual: Expression was not equal"),
+						expected, actual, site);
+	}
+
+	template <class T1, class T2>
+	static void AreNotEqual(const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreNotEqual(expected, actual, NULL, throws, file, line);
+	}
+
+	template <class T1, class T2>
+	static void AreNotEqual(const T1& expected, const T2& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreNotEqual(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	template <class T1, class T2>
+	static void AreNotEqual(const T1& expected, const T2& actual, const Site& site)
+	{	// the same two steps as the form without a site: a char array is compared as a string
+		Assert::AreNotEqual(expected, actual, NULL, site);
+	}
+	template <class T1, class T2>
+	static void AreNotEqual(const T1& expected, const T2& actual, LPCTSTR message, const Site& site)
+	{
+		Assert::Test( (expected != actual), message,
+			/*[PASS]*/ _T("AreNotEqual: Expression was not equal"),
+			/*[FAIL]*/ _T("AreNotEqual: Expression was equal"),
+						expected, actual, site);
+	}
+
+	// AreEqual for null terminated strings: (LPCTSTR)x2 and (LPTSTR)x2 - with and without a message
+	static void AreEqual(LPCTSTR expected, LPCTSTR actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreEqual(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), NULL, throws, file, line);
+	}
+	static void AreEqual(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreEqual(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), message, throws, file, line);
+	}
+	static void AreEqual(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, const Site& site)
+	{
+		Assert::AreEqual(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), message, site);
+	}
+	static void AreEqual(LPTSTR expected, LPTSTR actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreEqual(expected, actual, NULL, throws, file, line);
+	}
+	static void AreEqual(LPTSTR expected, LPTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreEqual(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	static void AreEqual(LPTSTR expected, LPTSTR actual, LPCTSTR message, const Site& site)
+	{	// test _tcscmp only if the expected and actual buffers points to a string
+		if(expected && actual)
+		{
+			Assert::Test( (_tcscmp(expected, actual) == 0 ), message,
+				/*[PASS]*/ _T("AreEqual: Expression was equal"),
+				/*[FAIL]*/ _T("AreEqual: Expression was not equal"),
+							expected, actual, site);
+		}
+		else
+		{	// otherwise fail
+			Assert::Fail( message, _T("AreEqual: Expected a non-NULL pointers"), site);
+		}
+	}
+
+	// AreNotEqual for null terminated strings: (LPCTSTR)x2 and (LPTSTR)x2 - with and without a message
+	static void AreNotEqual(LPCTSTR expected, LPCTSTR actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreNotEqual(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), NULL, throws, file, line);
+	}
+	static void AreNotEqual(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreNotEqual(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), message, throws, file, line);
+	}
+	static void AreNotEqual(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, const Site& site)
+	{
+		Assert::AreNotEqual(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), message, site);
+	}
+	static void AreNotEqual(LPTSTR expected, LPTSTR actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreNotEqual(expected, actual, NULL, throws, file, line);
+	}
+	static void AreNotEqual(LPTSTR expected, LPTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreNotEqual(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	static void AreNotEqual(LPTSTR expected, LPTSTR actual, LPCTSTR message, const Site& site)
+	{	// test _tcscmp only if the expected and actual buffers points to a string
+		if(expected && actual)
+		{
+			Assert::Test( (_tcscmp(expected, actual) != 0 ), message, 
+				/*[PASS]*/ _T("AreNotEqual: Expression was not equal"),
+				/*[FAIL]*/ _T("AreNotEqual: Expression was equal"),
+							expected, actual, site);
+		}
+		else
+		{	// otherwise fail
+			Assert::Fail( message, _T("AreEqual: Expected a non-NULL pointers"), site);
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Identity Asserts - test whether the same objects are referenced by the two arguments.
+	///////////////////////////////////////////////////////////////////////////
+	// [TODO] Not implemented - because its not relevant for C++
+	///////////////////////////////////////////////////////////////////////////
+	// static void AreSame(T1 const& expected, T2 const& actual, bool throws, LPCSTR file, int line);
+	//
+	// static void AreNotSame(T1 const& expected, T2 const& actual, bool throws, LPCSTR file, int line);
+ 	///////////////////////////////////////////////////////////////////////////
+
+	///////////////////////////////////////////////////////////////////////////
+	// Condition Tests - Methods that test a specific condition are named for the condition
+	// they test and take the value tested as their first argument and, optionally a message
+	// as the second.
+	// Two forms are provided for the True, False, Null and NotNull conditions.
+	// With or without the "Is" prefix.
+	///////////////////////////////////////////////////////////////////////////
+	static void IsTrue (int condition, bool throws, LPCSTR file, int line)
+	{
+	    Assert::IsTrue(condition, NULL, throws, file, line);
+	}
+	static void IsTrue (int condition, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::IsTrue(condition, message, Site::At(file, line, NULL, throws));
+	}
+	static void IsTrue (int condition, LPCTSTR message, const Site& site)
+	{
+	    Assert::Test( (condition == 1), message, 
+			/*[PASS]*/ _T("IsTrue: Condition was true"),
+			/*[FAIL]*/ _T("IsTrue: Condition was not true"),
+						site);
+	}
+	static void True (int condition, bool throws, LPCSTR file, int line)
+	{
+	    Assert::True(condition, NULL, throws, file, line);
+	}
+	static void True (int condition, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::True(condition, message, Site::At(file, line, NULL, throws));
+	}
+	static void True (int condition, LPCTSTR message, const Site& site)
+	{
+	    Assert::Test( (condition == 1), message, 
+			/*[PASS]*/ _T("True: Condition was true"),
+			/*[FAIL]*/ _T("True: Condition was not true"),
+						site);
+	}
+
+	static void IsFalse(int condition, bool throws, LPCSTR file, int line)
+	{
+	    Assert::IsFalse(condition, NULL, throws, file, line);
+	}
+	static void IsFalse(int condition, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::IsFalse(condition, message, Site::At(file, line, NULL, throws));
+	}
+	static void IsFalse(int condition, LPCTSTR message, const Site& site)
+	{
+	    Assert::Test( (condition == 0), message, 
+			/*[PASS]*/ _T("IsFalse: Condition was false"),
+			/*[FAIL]*/ _T("IsFalse: Condition was not false"),
+						site);
+	}
+	static void False(int condition, bool throws, LPCSTR file, int line)
+	{
+	    Assert::False(condition, NULL, throws, file, line);
+	}
+	static void False(int condition, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::False(condition, message, Site::At(file, line, NULL, throws));
+	}
+	static void False(int condition, LPCTSTR message, const Site& site)
+	{
+	    Assert::Test( (condition == 0), message, 
+			/*[PASS]*/ _T("False: Condition was false"),
+			/*[FAIL]*/ _T("False: Condition was not false"),
+						site);
+	}
+
+	template <class T>
+	static void IsNull(T* pointer, bool throws, LPCSTR file, int line)
+	{
+	    Assert::IsNull(pointer, NULL, throws, file, line);
+	}
+	template <class T>
+	static void IsNull(T* pointer, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::IsNull(pointer, message, Site::At(file, line, NULL, throws));
+	}
+	template <class T>
+	static void IsNull(T* pointer, LPCTSTR message, const Site& site)
+	{
+		Assert::Test( (pointer == 0), message,
+			/*[PASS]*/ _T("IsNull: Actual pointer was a NULL pointer"),
+			/*[FAIL]*/ _T("IsNull: Expected a NULL pointer"),
+						site );
+	}
+	template <class T>
+	static void Null(T* pointer, bool throws, LPCSTR file, int line)
+	{
+	    Assert::Null(pointer, NULL, throws, file, line);
+	}
+	template <class T>
+	static void Null(T* pointer, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::Null(pointer, message, Site::At(file, line, NULL, throws));
+	}
+	template <class T>
+	static void Null(T* pointer, LPCTSTR message, const Site& site)
+	{
+		Assert::Test( (pointer == 0), message,
+			/*[PASS]*/ _T("Null: Actual pointer was a NULL pointer"),
+			/*[FAIL]*/ _T("Null: Expected a NULL pointer"),
+						site );
+	}
+
+	template <class T>
+	static void IsNotNull(T* pointer, bool throws, LPCSTR file, int line)
+	{
+	    Assert::IsNotNull(pointer, NULL, throws, file, line);
+	}
+ 	template <class T>
+	static void IsNotNull(T* pointer, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::IsNotNull(pointer, message, Site::At(file, line, NULL, throws));
+	}
+	template <class T>
+	static void IsNotNull(T* pointer, LPCTSTR message, const Site& site)
+	{
+		Assert::Test( (pointer != 0), message,
+			/*[PASS]*/ _T("IsNotNull: Actual pointer was a non-NULL pointer"),
+			/*[FAIL]*/ _T("IsNotNull: Expected a non-NULL pointer"),
+						site);
+	}
+	template <class T>
+	static void NotNull(T* pointer, bool throws, LPCSTR file, int line)
+	{
+	    Assert::NotNull(pointer, NULL, throws, file, line);
+	}
+	template <class T>
+	static void NotNull(T* pointer, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::NotNull(pointer, message, Site::At(file, line, NULL, throws));
+	}
+	template <class T>
+	static void NotNull(T* pointer, LPCTSTR message, const Site& site)
+	{
+		Assert::Test( (pointer != 0), message,
+			/*[PASS]*/ _T("NotNull: Actual pointer was a non-NULL pointer"),
+			/*[FAIL]*/ _T("NotNull: Expected a non-NULL pointer"),
+						site);
+	}
+
+	// IsEmpty for null terminated strings: (LPCTSTR)x2 and (LPTSTR)x2 - with and without a message
+	static void IsEmpty(LPCTSTR buffer, bool throws, LPCSTR file, int line)
+	{
+	    Assert::IsEmpty(const_cast<LPTSTR>(buffer), NULL, throws, file, line);
+	}
+	static void IsEmpty(LPCTSTR buffer, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+	    Assert::IsEmpty(const_cast<LPTSTR>(buffer), message, throws, file, line);
+	}
+	static void IsEmpty(LPCTSTR buffer, LPCTSTR message, const Site& site)
+	{
+	    Assert::IsEmpty(const_cast<LPTSTR>(buffer), message, site);
+	}
+	static void IsEmpty(LPTSTR buffer, bool throws, LPCSTR file, int line)
+	{
+	    Assert::IsEmpty(buffer, NULL, throws, file, line);
+	}
+	static void IsEmpty(LPTSTR buffer, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::IsEmpty(buffer, message, Site::At(file, line, NULL, throws));
+	}
+	static void IsEmpty(LPTSTR buffer, LPCTSTR message, const Site& site)
+	{	// test _tcsclen only if the buffer points to a string
+		if(buffer)
+		{
+			Assert::Test( (_tcsclen(buffer) == 0), message, 
+				/*[PASS]*/ _T("IsEmpty: Actual string was empty"),
+				/*[FAIL]*/ _T("IsEmpty: Expected an empty string"),
+							site);
+		}
+		else
+		{	// otherwise pass
+			Assert::Pass( message, _T("IsEmpty: Actual string was empty"), site);
+		}
+	}
+
+	// IsNotEmpty for null terminated strings: (LPCTSTR)x2 and (LPTSTR)x2 - with and without a message
+	static void IsNotEmpty(LPCTSTR buffer, bool throws, LPCSTR file, int line)
+	{
+	    Assert::IsNotEmpty(const_cast<LPTSTR>(buffer), NULL, throws, file, line);
+	}
+	static void IsNotEmpty(LPCTSTR buffer, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+	    Assert::IsNotEmpty(const_cast<LPTSTR>(buffer), message, throws, file, line);
+	}
+	static void IsNotEmpty(LPCTSTR buffer, LPCTSTR message, const Site& site)
+	{
+	    Assert::IsNotEmpty(const_cast<LPTSTR>(buffer), message, site);
+	}
+	static void IsNotEmpty(LPTSTR buffer, bool throws, LPCSTR file, int line)
+	{
+	    Assert::IsNotEmpty(buffer, NULL, throws, file, line);
+	}
+	static void IsNotEmpty(LPTSTR buffer, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::IsNotEmpty(buffer, message, Site::At(file, line, NULL, throws));
+	}
+	static void IsNotEmpty(LPTSTR buffer, LPCTSTR message, const Site& site)
+	{	// test _tcsclen only if the buffer points to a string
+		if(buffer)
+		{
+			Assert::Test( (_tcsclen(buffer) > 0), message, 
+				/*[PASS]*/ _T("IsNotEmpty: Actual string was not empty"),
+				/*[FAIL]*/ _T("IsNotEmpty: Expected a non-empty string"),
+							site);
+		}
+		else
+		{	// otherwise fail
+			Assert::Fail( message, _T("IsEmpty: Expected an empty string"), site);
+		}
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Comparisons (NUnit 2.2.4) - The following methods test whether one object is:
+	// Greater(>) / GreaterOrEqual(>=) / Less(<) / LessOrEqual(<=) than another
+	template <class T1, class T2>
+	static void Greater(const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::Greater(expected, actual, NULL, throws, file, line);
+	}
+
+	template <class T1, class T2>
+	static void Greater(const T1& expected, const T2& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::Greater(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	template <class T1, class T2>
+	static void Greater(const T1& expected, const T2& actual, LPCTSTR message, const Site& site)
+	{
+		Assert::Test( (expected > actual), message,
+			/*[PASS]*/ _T("Greater: Condition was Greater"),
+			/*[FAIL]*/ _T("Greater: Condition was not Greater"),
+						expected, actual, site);
+	}
+
+	template <class T1, class T2>
+	static void GreaterOrEqual(const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::GreaterOrEqual(expected, actual, NULL, throws, file, line);
+	}
+
+	template <class T1, class T2>
+	static void GreaterOrEqual(const T1& expected, const T2& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::GreaterOrEqual(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	template <class T1, class T2>
+	static void GreaterOrEqual(const T1& expected, const T2& actual, LPCTSTR message, const Site& site)
+	{
+		Assert::Test( (expected >= actual), message,
+			/*[PASS]*/ _T("GreaterOrEqual: Condition was Greater or equal"),
+			/*[FAIL]*/ _T("GreaterOrEqual: Condition was not Greater or equal"),
+						expected, actual, site);
+	}
+
+	template <class T1, class T2>
+	static void Less(const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::Less(expected, actual, NULL, throws, file, line);
+	}
+
+	template <class T1, class T2>
+	static void Less(const T1& expected, const T2& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::Less(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	template <class T1, class T2>
+	static void Less(const T1& expected, const T2& actual, LPCTSTR message, const Site& site)
+	{
+		Assert::Test( (expected < actual), message,
+			/*[PASS]*/ _T("Less: Condition was Less"),
+			/*[FAIL]*/ _T("Less: Condition was not Less"),
+						expected, actual, site);
+	}
+
+	template <class T1, class T2>
+	static void LessOrEqual(const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::LessOrEqual(expected, actual, NULL, throws, file, line);
+	}
+
+	template <class T1, class T2>
+	static void LessOrEqual(const T1& expected, const T2& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::LessOrEqual(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	template <class T1, class T2>
+	static void LessOrEqual(const T1& expected, const T2& actual, LPCTSTR message, const Site& site)
+	{
+		Assert::Test( (expected <= actual), message,
+			/*[PASS]*/ _T("Less: Condition was Less or equal"),
+			/*[FAIL]*/ _T("Less: Condition was not Less or equal"),
+						expected, actual, site);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Near - floating point values within a Tolerance: a number (absolute), Tolerance::Relative(r)
+	// or Tolerance::Ulps(n). Two floats are compared as floats, anything else as double.
+	///////////////////////////////////////////////////////////////////////////
+	template <class T1, class T2>
+	static void AreNear(const T1& expected, const T2& actual, const Tolerance& tolerance, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreNear(expected, actual, tolerance, NULL, throws, file, line);
+	}
+	template <class T1, class T2>
+	static void AreNear(const T1& expected, const T2& actual, const Tolerance& tolerance, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreNear(expected, actual, tolerance, message, Site::At(file, line, NULL, throws));
+	}
+	template <class T1, class T2>
+	static void AreNear(const T1& expected, const T2& actual, const Tolerance& tolerance, LPCTSTR message, const Site& site)
+	{
+		typedef typename std::conditional<std::is_same<typename std::common_type<T1, T2>::type, float>::value, float, double>::type Real;
+		if(tolerance.Accepts(static_cast<Real>(expected), static_cast<Real>(actual)))
+		{
+			Assert::Pass(message, _T("AreNear: Values were near"), site);
+			return;
+		}
+		Assert::FailNear(message, static_cast<Real>(expected), static_cast<Real>(actual), tolerance, site);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Performance - DurationLess tests the median duration of a callable against an absolute
+	// budget in milliseconds; NotSlower tests it against the stored baseline of the key, allowing
+	// 'tolerance' (0.1 = 10%) slowdown. A missing baseline is recorded and the test passes.
+	// See class Performance for the repetitions, outlier rejection and CPU pinning.
+	///////////////////////////////////////////////////////////////////////////
+	template <class F>
+	static void DurationLess(F function, double milliseconds, bool throws, LPCSTR file, int line)
+	{
+		Assert::DurationLess(function, milliseconds, NULL, throws, file, line);
+	}
+
+	template <class F>
+	static void DurationLess(F function, double milliseconds, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::DurationLess(function, milliseconds, message, Site::At(file, line, NULL, throws));
+	}
+	template <class F>
+	static void DurationLess(F function, double milliseconds, LPCTSTR message, const Site& site)
+	{
+		Performance::Measurement measurement = Performance::Measure(function);
+		Assert::Test( (measurement.median < milliseconds * 1e6), message,
+			/*[PASS]*/ _T("DurationLess: Duration was Less than the budget"),
+			/*[FAIL]*/ _T("DurationLess: Duration was not Less than the budget"),
+						_T("< ") + Benchmark::Time(milliseconds * 1e6), Assert::Duration(measurement), site);
+	}
+
+	template <class F>
+	static void NotSlower(F function, LPCSTR key, double tolerance, bool throws, LPCSTR file, int line)
+	{
+		Assert::NotSlower(function, key, tolerance, NULL, throws, file, line);
+	}
+
+	template <class F>
+	static void NotSlower(F function, LPCSTR key, double tolerance, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::NotSlower(function, key, tolerance, message, Site::At(file, line, NULL, throws));
+	}
+	template <class F>
+	static void NotSlower(F function, LPCSTR key, double tolerance, LPCTSTR message, const Site& site)
+	{
+		Performance::Measurement measurement = Performance::Measure(function);
+		double baseline;
+		if(!Performance::Baseline(key, baseline))
+		{
+			Performance::Record(key, measurement.median);
+			Assert::Test(true, message,
+				/*[PASS]*/ _T("NotSlower: No baseline - the duration was recorded"),
+				/*[FAIL]*/ NULL,
+							site);
+			return;
+		}
+		std::ostringstream expected;
+		expected << _T("<= ") << Benchmark::Time(baseline * (1 + tolerance)) << _T(" (baseline ")
+				 << Benchmark::Time(baseline) << _T(" + ") << tolerance * 100 << _T("%)");
+		Assert::Test( (measurement.median <= baseline * (1 + tolerance)), message,
+			/*[PASS]*/ _T("NotSlower: Duration was not slower than the baseline"),
+			/*[FAIL]*/ _T("NotSlower: Duration was slower than the baseline"),
+						expected.str(), Assert::Duration(measurement), site);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Allocations - MaxAllocations tests the number of operator new calls counted by an
+	// AllocationScope (see the ASSERT_NO_ALLOCATIONS / ASSERT_MAX_ALLOCATIONS macros)
+	///////////////////////////////////////////////////////////////////////////
+	static void MaxAllocations(unsigned long long maximum, unsigned long long actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::MaxAllocations(maximum, actual, NULL, throws, file, line);
+	}
+	static void MaxAllocations(unsigned long long maximum, unsigned long long actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		if(!Allocations::IsTracking())
+		{
+			Assert::Fail(message, _T("MaxAllocations: Allocation tracking is disabled - define UNITTEST_TRACK_ALLOCATIONS in one source file"), throws, file, line);
+			return;
+		}
+		Assert::Test( (actual <= maximum), message,
+			/*[PASS]*/ _T("MaxAllocations: Allocations were not more than the maximum"),
+			/*[FAIL]*/ _T("MaxAllocations: Allocations were more than the maximum"),
+						maximum, actual, throws, file, line);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// Resources - MaxCpuTime / MaxRssDelta test the CPU time (milliseconds) and the RSS
+	// growth (megabytes) measured by a ResourceScope (see ASSERT_MAX_CPU_TIME / ASSERT_MAX_RSS_DELTA)
+	///////////////////////////////////////////////////////////////////////////
+	static void MaxCpuTime(double maximum, const Resources::Usage& actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::MaxCpuTime(maximum, actual, NULL, throws, file, line);
+	}
+	static void MaxCpuTime(double maximum, const Resources::Usage& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		std::ostringstream expected, measured;
+		expected << _T("<= ") << maximum << _T(" ms");
+		measured << actual.userTime + actual.systemTime << _T(" ms (user ") << actual.userTime
+				 << _T(" ms, system ") << actual.systemTime << _T(" ms)");
+		Assert::Test( (actual.userTime + actual.systemTime <= maximum), message,
+			/*[PASS]*/ _T("MaxCpuTime: CPU time was not more than the maximum"),
+			/*[FAIL]*/ _T("MaxCpuTime: CPU time was more than the maximum"),
+						expected.str(), measured.str(), throws, file, line);
+	}
+
+	static void MaxRssDelta(double maximum, const Resources::Usage& actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::MaxRssDelta(maximum, actual, NULL, throws, file, line);
+	}
+	static void MaxRssDelta(double maximum, const Resources::Usage& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		std::ostringstream expected, measured;
+		expected << _T("<= ") << maximum << _T(" MB");
+		measured << actual.rss / (1024.0 * 1024.0) << _T(" MB");
+		Assert::Test( (actual.rss <= maximum * 1024 * 1024), message,
+			/*[PASS]*/ _T("MaxRssDelta: RSS growth was not more than the maximum"),
+			/*[FAIL]*/ _T("MaxRssDelta: RSS growth was more than the maximum"),
+						expected.str(), measured.str(), throws, file, line);
+	}
+
+ 	///////////////////////////////////////////////////////////////////////////
+	// Type Asserts (NUnit 2.2.3 / 2.5) - These methods allow us to make assertions 
+	// about the type of an object.
+	///////////////////////////////////////////////////////////////////////////
+	// [TODO] Not implemented - because the compilation should support RTTI 
+	//							#include <typeinfo.h> // compile with: /GR /EHsc
+	///////////////////////////////////////////////////////////////////////////
+	//static void IsInstanceOfType(const type_info& expected, const T& actual, bool throws, LPCSTR file, int line);
+	//
+	//static void IsNotInstanceOfType(const type_info& expected, const T& actual, bool throws, LPCSTR file, int line);
+	//
+	//static void IsAssignableFrom(const type_info& expected, const T& actual, bool throws, LPCSTR file, int line);
+	//
+	//static void IsNotAssignableFrom(const type_info& expected, const T& actual, bool throws, LPCSTR file, int line);
+	///////////////////////////////////////////////////////////////////////////
+
+	///////////////////////////////////////////////////////////////////////////
+	// Exception Asserts (NUnit 2.5) - When used with a Type argument, Assert::Throws requires
+	// that exact type to be thrown. If you want to test for any derived Type, use one of the
+	// forms that allows specifying a constraint.
+	// Alternatively, you may use Assert::Catch, which differs from Assert::Throws in allowing
+	// derived types
+	///////////////////////////////////////////////////////////////////////////
+	// [TODO] Not implemented - because its not relevant for C++
+	///////////////////////////////////////////////////////////////////////////
+	//static Exception Throws( Type expectedExceptionType, TestDelegate code, string message, params object[] parms);
+	//
+	//static Exception Throws( IResolveConstraint constraint, TestDelegate code, string message, params object[] parms);
+	//
+	//static T Throws<T>( TestDelegate code, string message, params object[] parms);
+	//
+	//static void DoesNotThrow( TestDelegate code, string message, params object[] parms);
+	//
+	//static Exception Catch( TestDelegate code, string message, params object[] parms);
+	//
+	//static Exception Catch( Type expectedExceptionType, TestDelegate code,  string message, params object[] parms);
+	//
+	//static T Catch<T>( TestDelegate code, string message,  params object[] parms);
+	///////////////////////////////////////////////////////////////////////////
+
+	///////////////////////////////////////////////////////////////////////////
+	// Utility Methods - Two utility methods, Pass(), Fail(),
+	// are provided in order to allow more direct control of the test process
+	///////////////////////////////////////////////////////////////////////////
+	// [TODO] Not implemented - because its not relevant for C++
+	///////////////////////////////////////////////////////////////////////////
+	//static void Ignore(LPCTSTR message, bool throws, LPCSTR file, int line)
+	//
+	//static void Inconclusive(LPCTSTR message, bool throws, LPCSTR file, int line)
+	///////////////////////////////////////////////////////////////////////////
+	static void Pass(LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::Pass(message, NULL, throws, file, line);
+	}
+	static void Pass(LPCTSTR message, const Site& site)
+	{
+		Assert::Pass(message, NULL, site);
+	}
+
+ 	static void Fail(LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::Fail(message, NULL, throws, file, line);
+	}
+ 	static void Fail(LPCTSTR message, const Site& site)
+	{
+		Assert::Fail(message, NULL, site);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// That (NUnit 2.4 constraint model) - CHECK(expression) / REQUIRE(expression) tests a
+	// decomposed expression; only a failure formats the operands
+	///////////////////////////////////////////////////////////////////////////
+	static void That(const Expression& expression, LPCTSTR text, bool throws, LPCSTR file, int line)
+	{
+		Assert::That(expression, Site::At(file, line, text, throws));
+	}
+	static void That(const Expression& expression, const Site& site)
+	{	// unpacked into registers - the call site never builds the Expression in memory
+		Assert::That(expression.result, expression.left, expression.right, expression.operation, site);
+	}
+	UNITTEST_NOINLINE static void That(bool result, const void* left, const void* right, const Expression::Operation* operation,
+									   const Site& site)
+	{
+		if(result)
+		{
+			Assert::Pass(site.text, _T("That: Expression was true"), site);
+			return;
+		}
+		Expression expression = { result, left, right, operation };
+		Assert::FailThat(expression, site);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// StringAssert (NUnit 2.2.3) - The StringAssert class provides a number of methods that are
+	// useful when examining string values
+	///////////////////////////////////////////////////////////////////////////
+
+	// The strings are null terminated strings (NULL is the empty string), std::string or
+	// std::string_view. Each assert is one pass over the strings and one PASS or FAIL record;
+	// an empty expected or actual string fails.
+	static std::string_view View(LPCTSTR text)
+	{
+		return text ? std::string_view(text) : std::string_view();
+	}
+	// the one FAIL record of a string assert with an empty string - false when neither is empty
+	static bool FailEmpty(std::string_view expected, std::string_view actual, LPCTSTR message, LPCTSTR expectedEmpty, LPCTSTR actualEmpty,
+						  const Site& site)
+	{
+		if(!expected.empty() && !actual.empty())
+		{
+			return false;
+		}
+		Assert::Fail(message, expected.empty() ? expectedEmpty : actualEmpty, site);
+		return true;
+	}
+
+	// Contains - the 'actual' string contains the 'expected' substring
+	static void Contains(LPCTSTR expected, LPCTSTR actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::Contains(expected, actual, NULL, throws, file, line);
+	}
+	static void Contains(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::Contains(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	static void Contains(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, const Site& site)
+	{	// one strstr - only a failure, which prints 'actual', needs its length
+		LPCTSTR found = (expected && *expected && actual) ? strstr(actual, expected) : NULL;
+		std::string_view substring = Assert::View(expected);
+		Assert::Contains(found != NULL, substring, found ? std::string_view(found, substring.size()) : Assert::View(actual), message, site);
+	}
+	static void Contains(std::string_view expected, std::string_view actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::Contains(expected, actual, NULL, throws, file, line);
+	}
+	static void Contains(std::string_view expected, std::string_view actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::Contains(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	static void Contains(std::string_view expected, std::string_view actual, LPCTSTR message, const Site& site)
+	{
+		Assert::Contains(actual.find(expected) != std::string_view::npos, expected, actual, message, site);
+	}
+	// the one record of Contains - 'contained' is found by the form which knows the strings
+	static void Contains(bool contained, std::string_view expected, std::string_view actual, LPCTSTR message, const Site& site)
+	{
+		if(Assert::FailEmpty(expected, actual, message, _T("Contains: expected substring is empty"), _T("Contains: actual string is empty"), site))
+		{
+			return;
+		}
+		Assert::Test( contained, message,
+			/*[PASS]*/ _T("Contains: Expected substring was contains in the actual string"),
+			/*[FAIL]*/ _T("Contains: Expected substring was not contains in the actual string"),
+						expected, actual, site);
+	}
+
+	// StartsWith - the 'actual' string starts with the 'expected' substring: compares len(expected) characters
+	static void StartsWith(LPCTSTR expected, LPCTSTR actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::StartsWith(expected, actual, NULL, throws, file, line);
+	}
+	static void StartsWith(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::StartsWith(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	static void StartsWith(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, const Site& site)
+	{	// reads len(expected) characters of 'actual' - only a failure, which prints it, needs its length
+		std::string_view prefix = Assert::View(expected);
+		bool started = !prefix.empty() && actual && strncmp(actual, prefix.data(), prefix.size()) == 0;
+		Assert::StartsWith(started, prefix, started ? std::string_view(actual, prefix.size()) : Assert::View(actual), message, site);
+	}
+	static void StartsWith(std::string_view expected, std::string_view actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::StartsWith(expected, actual, NULL, throws, file, line);
+	}
+	static void StartsWith(std::string_view expected, std::string_view actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::StartsWith(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	static void StartsWith(std::string_view expected, std::string_view actual, LPCTSTR message, const Site& site)
+	{
+		Assert::StartsWith(actual.size() >= expected.size() && actual.compare(0, expected.size(), expected) == 0, expected, actual, message, site);
+	}
+	// the one record of StartsWith - 'started' is found by the form which knows the strings
+	static void StartsWith(bool started, std::string_view expected, std::string_view actual, LPCTSTR message, const Site& site)
+	{
+		if(Assert::FailEmpty(expected, actual, message, _T("StartsWith: expected substring is empty"), _T("StartsWith: actual string is empty"), site))
+		{
+			return;
+		}
+		Assert::Test( started, message,
+			/*[PASS]*/ _T("StartsWith: Expected substring was started at the actual string"),
+			/*[FAIL]*/ _T("StartsWith: Expected substring was not started at the actual string"),
+						expected, actual, site);
+	}
+
+	// EndsWith - the 'actual' string ends with the 'expected' substring
+	static void EndsWith(LPCTSTR expected, LPCTSTR actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::EndsWith(expected, actual, NULL, throws, file, line);
+	}
+	static void EndsWith(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::EndsWith(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	static void EndsWith(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, const Site& site)
+	{
+		Assert::EndsWith(Assert::View(expected), Assert::View(actual), message, site);
+	}
+	static void EndsWith(std::string_view expected, std::string_view actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::EndsWith(expected, actual, NULL, throws, file, line);
+	}
+	static void EndsWith(std::string_view expected, std::string_view actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::EndsWith(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	static void EndsWith(std::string_view expected, std::string_view actual, LPCTSTR message, const Site& site)
+	{
+		if(Assert::FailEmpty(expected, actual, message, _T("EndsWith: expected substring is empty"), _T("EndsWith: actual string is empty"), site))
+		{
+			return;
+		}
+		Assert::Test( (actual.size() >= expected.size() && actual.compare(actual.size() - expected.size(), expected.size(), expected) == 0), message,
+			/*[PASS]*/ _T("EndsWith: Expected substring was ended the actual string"),
+			/*[FAIL]*/ _T("EndsWith: Expected substring was not ended the actual string"),
+						expected, actual, site);
+	}
+
+	// AreEqualIgnoringCase - the 'actual' string is the 'expected' string, ignoring the case (tolower)
+	static void AreEqualIgnoringCase(LPCTSTR expected, LPCTSTR actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreEqualIgnoringCase(expected, actual, NULL, throws, file, line);
+	}
+	static void AreEqualIgnoringCase(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreEqualIgnoringCase(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	static void AreEqualIgnoringCase(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, const Site& site)
+	{
+		Assert::AreEqualIgnoringCase(Assert::View(expected), Assert::View(actual), message, site);
+	}
+	static void AreEqualIgnoringCase(std::string_view expected, std::string_view actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreEqualIgnoringCase(expected, actual, NULL, throws, file, line);
+	}
+	static void AreEqualIgnoringCase(std::string_view expected, std::string_view actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::AreEqualIgnoringCase(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	static void AreEqualIgnoringCase(std::string_view expected, std::string_view actual, LPCTSTR message, const Site& site)
+	{
+		if(Assert::FailEmpty(expected, actual, message, _T("AreEqualIgnoringCase: expected substring is empty"), _T("AreEqualIgnoringCase: actual string is empty"), site))
+		{
+			return;
+		}
+		bool equal = (expected.size() == actual.size());
+		for(size_t i = 0; equal && i < expected.size(); ++i)
+		{
+			equal = (tolower(static_cast<unsigned char>(expected[i])) == tolower(static_cast<unsigned char>(actual[i])));
+		}
+		Assert::Test( equal, message,
+			/*[PASS]*/ _T("AreEqualIgnoringCase: Expression was equal"),
+			/*[FAIL]*/ _T("AreEqualIgnoringCase: Expression was not equal"),
+						expected, actual, site);
+	}
+
+	// IsMatch - the 'expected' regular expression (ECMAScript) matches a part of the 'actual' string,
+	// as Regex.IsMatch does (^ and $ anchor it); each pattern is compiled once (see class Patterns)
+	static void IsMatch(LPCTSTR expected, LPCTSTR actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::IsMatch(expected, actual, NULL, throws, file, line);
+	}
+	static void IsMatch(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::IsMatch(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	static void IsMatch(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, const Site& site)
+	{
+		Assert::IsMatch(Assert::View(expected), Assert::View(actual), message, site);
+	}
+	static void IsMatch(std::string_view expected, std::string_view actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::IsMatch(expected, actual, NULL, throws, file, line);
+	}
+	static void IsMatch(std::string_view expected, std::string_view actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::IsMatch(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	static void IsMatch(std::string_view expected, std::string_view actual, LPCTSTR message, const Site& site)
+	{
+		if(Assert::FailEmpty(expected, actual, message, _T("IsMatch: expected substring is empty"), _T("IsMatch: actual string is empty"), site))
+		{
+			return;
+		}
+		bool match;
+		std::string error;
+		{
+			Allocations::Ignore ignore;		// the cache and the matcher allocate - not the code under test
+			const std::regex* expression = Patterns::Find(expected, error);
+			match = expression && std::regex_search(actual.begin(), actual.end(), *expression);
+		}
+		if(!error.empty())
+		{
+			Assert::Fail(message, _T("IsMatch: Expected pattern was not a regular expression"), expected, error, site);
+			return;
+		}
+		Assert::Test( match, message,
+			/*[PASS]*/ _T("IsMatch: Expression was match"),
+			/*[FAIL]*/ _T("IsMatch: Expression was not match"),
+						expected, actual, site);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// CollectionAssert (NUnit 2.4 / 2.5) - The CollectionAssert class provides a number 
+	// of methods that are useful when examining collections and their contents or for
+	// comparing two collections
+	// The collections are contiguous ranges: C arrays, std::vector, std::array, std::string
+	// or Collections::Range(pointer, count). A whole range is one assertion; a failure prints
+	// the index of the first mismatch and the elements around it (see class Collections).
+	///////////////////////////////////////////////////////////////////////////
+	template <class C1, class C2>
+	static void CollectionAreEqual(const C1& expected, const C2& actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::CollectionAreEqual(expected, actual, NULL, throws, file, line);
+	}
+	template <class C1, class C2>
+	static void CollectionAreEqual(const C1& expected, const C2& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::CollectionAreEqual(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	template <class C1, class C2>
+	static void CollectionAreEqual(const C1& expected, const C2& actual, LPCTSTR message, const Site& site)
+	{	// the same elements in the same order
+		size_t count = std::min(std::size(expected), std::size(actual));
+		size_t index = Collections::Mismatch(std::data(expected), std::data(actual), count);
+		if(index == count && std::size(expected) == std::size(actual))
+		{
+			Assert::Pass(message, _T("CollectionAreEqual: Collections were equal"), site);
+			return;
+		}
+		Assert::FailCollection(message, _T("CollectionAreEqual: Collections were not equal"),
+							   std::data(expected), std::size(expected), std::data(actual), std::size(actual), index, site);
+	}
+
+	template <class C1, class C2>
+	static void CollectionAreEquivalent(const C1& expected, const C2& actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::CollectionAreEquivalent(expected, actual, NULL, throws, file, line);
+	}
+	template <class C1, class C2>
+	static void CollectionAreEquivalent(const C1& expected, const C2& actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::CollectionAreEquivalent(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	template <class C1, class C2>
+	static void CollectionAreEquivalent(const C1& expected, const C2& actual, LPCTSTR message, const Site& site)
+	{	// the same elements in any order - sorted copies are compared (the elements need operator<)
+		std::string value;
+		size_t expectedTimes, actualTimes;
+		if(Collections::Equivalent(std::data(expected), std::size(expected), std::data(actual), std::size(actual),
+								   value, expectedTimes, actualTimes))
+		{
+			Assert::Pass(message, _T("CollectionAreEquivalent: Collections were equivalent"), site);
+			return;
+		}
+		Assert::FailEquivalent(message, value, expectedTimes, std::size(expected), actualTimes, std::size(actual), site);
+	}
+
+	template <class C, class V>
+	static void CollectionContains(const C& collection, const V& value, bool throws, LPCSTR file, int line)
+	{
+		Assert::CollectionContains(collection, value, NULL, throws, file, line);
+	}
+	template <class C, class V>
+	static void CollectionContains(const C& collection, const V& value, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::CollectionContains(collection, value, message, Site::At(file, line, NULL, throws));
+	}
+	template <class C, class V>
+	static void CollectionContains(const C& collection, const V& value, LPCTSTR message, const Site& site)
+	{
+		if(Collections::Find(std::data(collection), std::size(collection), value) < std::size(collection))
+		{
+			Assert::Pass(message, _T("CollectionContains: Value was contained in the collection"), site);
+			return;
+		}
+		Assert::FailContains(message, std::data(collection), std::size(collection), value, site);
+	}
+
+	template <class C>
+	static void CollectionIsOrdered(const C& collection, bool throws, LPCSTR file, int line)
+	{
+		Assert::CollectionIsOrdered(collection, NULL, throws, file, line);
+	}
+	template <class C>
+	static void CollectionIsOrdered(const C& collection, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::CollectionIsOrdered(collection, message, Site::At(file, line, NULL, throws));
+	}
+	template <class C>
+	static void CollectionIsOrdered(const C& collection, LPCTSTR message, const Site& site)
+	{	// ascending: no element is less than the one before it (equal neighbours are allowed)
+		size_t index = Collections::Descent(std::data(collection), std::size(collection));
+		if(index == std::size(collection))
+		{
+			Assert::Pass(message, _T("CollectionIsOrdered: Collection was ordered"), site);
+			return;
+		}
+		Assert::FailOrdered(message, std::data(collection), std::size(collection), index + 1, site);
+	}
+
+	template <class C1, class C2>
+	static void CollectionAreNear(const C1& expected, const C2& actual, const Tolerance& tolerance, bool throws, LPCSTR file, int line)
+	{
+		Assert::CollectionAreNear(expected, actual, tolerance, NULL, throws, file, line);
+	}
+	template <class C1, class C2>
+	static void CollectionAreNear(const C1& expected, const C2& actual, const Tolerance& tolerance, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::CollectionAreNear(expected, actual, tolerance, message, Site::At(file, line, NULL, throws));
+	}
+	template <class C1, class C2>
+	static void CollectionAreNear(const C1& expected, const C2& actual, const Tolerance& tolerance, LPCTSTR message, const Site& site)
+	{	// two float or two double ranges - Tolerance::Outside counts the elements with SIMD
+		size_t count = std::size(expected);
+		if(count == std::size(actual) && tolerance.Outside(std::data(expected), std::data(actual), count) == 0)
+		{
+			Assert::Pass(message, _T("CollectionAreNear: Collections were near"), site);
+			return;
+		}
+		Assert::FailCollectionNear(message, std::data(expected), std::size(expected), std::data(actual), std::size(actual), tolerance, site);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// FileAssert (NUnit 2.4) -  The FileAssert class provides methods for comparing two files,
+	// which may be provided as Streams, as FileInfos or as strings giving the path to each file
+	// Here the files are given by their paths, and the whole comparison is one assertion; a
+	// failure prints the offset of the first difference and the rows around it (see class Files).
+	///////////////////////////////////////////////////////////////////////////
+	static void FileAreEqual(LPCSTR expected, LPCSTR actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::FileAreEqual(expected, actual, NULL, throws, file, line);
+	}
+	static void FileAreEqual(LPCSTR expected, LPCSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::FileAreEqual(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	static void FileAreEqual(const std::string& expected, const std::string& actual, LPCTSTR message, const Site& site)
+	{
+		Assert::FileAreEqual(expected.c_str(), actual.c_str(), message, site);
+	}
+	static void FileAreEqual(LPCSTR expected, LPCSTR actual, LPCTSTR message, const Site& site)
+	{	// the same bytes: the size first, then the content
+		Files::Comparison comparison;
+		Files::Compare(expected, actual, comparison);
+		if(comparison.outcome == Files::Equal)
+		{
+			Assert::Pass(message, _T("FileAreEqual: Files were equal"), site);
+			return;
+		}
+		Assert::FailFile(message, expected, actual, comparison, site);
+	}
+
+	///////////////////////////////////////////////////////////////////////////
+	// DirectoryAssert (NUnit 2.5) - The DirectoryAssert class provides methods for making asserts
+	// about file system directories, which may be provided as DirectoryInfos or as strings giving
+	// the path to each directory.
+	// Here the directories are given by their paths; the trees are compared path by path and a
+	// failure lists every missing, extra and differing path (see class Directories).
+	///////////////////////////////////////////////////////////////////////////
+	static void DirectoryAreEqual(LPCSTR expected, LPCSTR actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::DirectoryAreEqual(expected, actual, NULL, throws, file, line);
+	}
+	static void DirectoryAreEqual(LPCSTR expected, LPCSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+	{
+		Assert::DirectoryAreEqual(expected, actual, message, Site::At(file, line, NULL, throws));
+	}
+	static void DirectoryAreEqual(const std::string& expected, const std::string& actual, LPCTSTR message, const Site& site)
+	{
+		Assert::DirectoryAreEqual(expected.c_str(), actual.c_str(), message, site);
+	}
+	static void DirectoryAreEqual(LPCSTR expected, LPCSTR actual, LPCTSTR message, const Site& site)
+	{	// the same paths, of the same type, and files with the same bytes
+		std::vector<Directories::Difference> differences;
+		size_t paths;
+		{
+			Allocations::Ignore ignore;		// the listings are the framework's
+			paths = Directories::Compare(expected, actual, differences);
+		}
+		if(differences.empty())
+		{
+			Assert::Pass(message, _T("DirectoryAreEqual: Directories were equal"), site);
+			return;
+		}
+		Assert::FailDirectory(message, expected, actual, paths, differences, site);
+	}
+
+private:
+	// private Utility Methods
+	template <class T1, class T2>
+	static void Fail(LPCTSTR message, const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::Fail(message, NULL, expected, actual, throws, file, line);
+	}
+
+	template <class T1, class T2>
+	static void Pass(LPCTSTR message, const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::Pass(message, NULL, expected, actual, throws, file, line);
+	}
+
+	static void Test(bool condition, LPCTSTR message_pass, LPCTSTR message_fail,
+					 bool throws, LPCSTR file, int line)
+	{
+		Assert::Test(condition, NULL, message_pass, message_fail, throws, file, line);
+	}
+
+	template <class T1, class T2>
+	static void Test(bool condition, LPCTSTR message_pass, LPCTSTR message_fail,
+					 const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::Test(condition, NULL, message_pass, message_fail, expected, actual, throws, file, line);
+	}
+
+	static void Test(bool condition, LPCTSTR message, LPCTSTR message_pass, LPCTSTR message_fail,
+					 bool throws, LPCSTR file, int line)
+	{
+		if(message)
+		{
+			(condition) ?
+				Assert::Pass(message, message_pass, throws, file, line) :
+				Assert::Fail(message, message_fail, throws, file, line);
+		}
+		else
+		{
+			(condition) ?
+				Assert::Pass(message_pass, throws, file, line) :
+				Assert::Fail(message_fail, throws, file, line);
+		}
+	}
+
+	template <class T1, class T2>
+	static void Test(bool condition, LPCTSTR message, LPCTSTR message_pass, LPCTSTR message_fail,
+					 const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	{
+		if(message)
+		{
+			(condition) ?
+				Assert::Pass(message, message_pass, expected, actual, throws, file, line) :
+				Assert::Fail(message, message_fail, expected, actual, throws, file, line);
+		}
+		else
+		{
+			(condition) ?
+				Assert::Pass(message_pass, expected, actual, throws, file, line) :
+				Assert::Fail(message_fail, expected, actual, throws, file, line);
+		}
+	}
+
+	// the site forms - the code of each type only tests the condition; the pass and
+	// the failure are shared calls and only a failure formats the values
+	static void Test(bool condition, LPCTSTR message, LPCTSTR message_pass, LPCTSTR message_fail, const Site& site)
+	{
+		(condition) ?
+			Assert::Pass(message, message_pass, site) :
+			Assert::Fail(message, message_fail, site);
+	}
+
+	template <class T1, class T2>
+	static void Test(bool condition, LPCTSTR message, LPCTSTR message_pass, LPCTSTR message_fail,
+					 const T1& expected, const T2& actual, const Site& site)
+	{
+		(condition) ?
+			Assert::Pass(message, message_pass, site) :
+			Assert::Fail(message, message_fail, expected, actual, site);
+	}
+
+	// the failure of That - the one place which prints the operands of every CHECK / REQUIRE
+	UNITTEST_COLD static void FailThat(const Expression& expression, const Site& site)
+	{
+		std::string message;
+		{
+			Allocations::Ignore ignore;
+			const Expression::Operation& operation = *expression.operation;
+			Diff::Text left, right;
+			LPCTSTR leftQuote = Diff::Render(operation.left, operation.leftText, expression.left, left) ? _T("\"") : _T("");
+			LPCTSTR rightQuote = _T("");
+			if(operation.right)
+			{
+				rightQuote = Diff::Render(operation.right, operation.rightText, expression.right, right) ? _T("\"") : _T("");
+			}
+			if(Diff::Fits(left, right))
+			{	// "left op right" - "left" for a single value, strings in quotes
+				message.append(_T("That: Expression was false\nWith:     '")).append(leftQuote).append(left.data, left.size).append(leftQuote);
+				if(operation.right)
+				{
+					message.append(_T(" ")).append(Expression::Symbol(operation.op)).append(_T(" "))
+						   .append(rightQuote).append(right.data, right.size).append(rightQuote);
+				}
+				message.append(_T("'"));
+			}
+			else
+			{	// the operands around their first difference (see class Diff)
+				size_t at = operation.right ? Diff::Divergence(left, right) : 0;
+				std::ostringstream ostr;
+				ostr << _T("That: Expression was false\nWith:     '") << Diff::Excerpt(left, at);
+				if(operation.right)
+				{
+					ostr << _T(" ") << Expression::Symbol(operation.op) << _T(" ") << Diff::Excerpt(right, at);
+				}
+				ostr << _T("' (") << left.length;
+				if(operation.right)
+				{
+					ostr << _T(" and ") << right.length;
+				}
+				ostr << _T(" chars)");
+				if(operation.op == Expression::Equal)
+				{
+					ostr << std::endl;
+					Diff::Describe(ostr, left, right, at);
+				}
+				message = ostr.str();
+				if(!message.empty() && message[message.size() - 1] == '\n')
+				{
+					message.erase(message.size() - 1);
+				}
+			}
+		}
+		Assert::Fail(site.text, message.c_str(), site);
+	}
+
+	// the failure of DirectoryAreEqual - one line per differing path
+	UNITTEST_COLD static void FailDirectory(LPCTSTR message, LPCSTR expected, LPCSTR actual, size_t paths,
+											std::vector<Directories::Difference>& differences, const Site& site)
+	{
+		std::string text;
+		{
+			Allocations::Ignore ignore;
+			static const LPCTSTR kinds[] = { _T("missing   "), _T("extra     "), _T("type      "), _T("size      "), _T("content   "), _T("unreadable") };
+			size_t counts[6] = { 0 };
+			std::ostringstream lines;
+			for(size_t i = 0; i < differences.size(); ++i)
+			{
+				const Directories::Difference& difference = differences[i];
+				++counts[difference.kind];
+				lines << _T("\n  ") << kinds[difference.kind] << _T(" ") << (difference.path.empty() ? _T(".") : difference.path.c_str());
+				switch(difference.kind)
+				{
+				case Directories::Type:
+					lines << _T(" (expected ") << ((difference.expected == 'd') ? _T("a directory") : (difference.expected == 'f') ? _T("a file") : _T("a special file"))
+						  << _T(", actual ") << ((difference.actual == 'd') ? _T("a directory") : (difference.actual == 'f') ? _T("a file") : _T("a special file")) << _T(")");
+					break;
+				case Directories::Size:
+					lines << _T(" (expected ") << difference.expected << _T(" bytes, actual ") << difference.actual << _T(" bytes)");
+					break;
+				case Directories::Content:
+					lines << _T(" (first difference at offset ") << difference.expected << _T(")");
+					break;
+				case Directories::Unreadable:
+					lines << _T(" (") << (difference.expectedSide ? _T("expected") : _T("actual")) << _T(": ") << strerror(difference.error) << _T(")");
+					break;
+				default:
+					break;
+				}
+			}
+			std::ostringstream ostr;
+			ostr << _T("DirectoryAreEqual: Directories were not equal (") << counts[Directories::Missing] << _T(" missing, ")
+				 << counts[Directories::Extra] << _T(" extra, ") << counts[Directories::Type] + counts[Directories::Size] + counts[Directories::Content]
+				 << _T(" different, ") << counts[Directories::Unreadable] << _T(" unreadable of ") << paths << _T(" paths)") << lines.str();
+			text = ostr.str();
+		}
+		Assert::Fail(message, text.c_str(), std::string(expected), std::string(actual), site);
+	}
+
+	// the failure of FileAreEqual - each side is the path and the hexdump rows around the offset
+	UNITTEST_COLD static void FailFile(LPCTSTR message, LPCSTR expected, LPCSTR actual, const Files::Comparison& comparison, const Site& site)
+	{
+		std::string text, left, right;
+		{
+			Allocations::Ignore ignore;
+			std::ostringstream ostr, expectedText, actualText;
+			expectedText << expected;
+			actualText << actual;
+			switch(comparison.outcome)
+			{
+			case Files::Unreadable:
+				ostr << _T("FileAreEqual: ") << (comparison.expectedFailed ? _T("Expected") : _T("Actual"))
+					 << _T(" file could not be read (") << strerror(comparison.error) << _T(")");
+				break;
+			case Files::DifferentSize:
+				ostr << _T("FileAreEqual: Files had different sizes");
+				if(comparison.expectedSize != Files::NoSize)
+				{
+					ostr << _T(" (expected ") << comparison.expectedSize << _T(" bytes, actual ") << comparison.actualSize << _T(" bytes)");
+					if(comparison.offset < std::min(comparison.expectedSize, comparison.actualSize))
+					{
+						ostr << _T(", first difference at offset ") << comparison.offset
+							 << _T(" (0x") << std::hex << comparison.offset << std::dec << _T(")");
+					}
+				}
+				else
+				{
+					ostr << _T(" - the shorter one ended at offset ") << comparison.offset;
+				}
+				break;
+			default:
+				ostr << _T("FileAreEqual: Files were not equal at offset ") << comparison.offset
+					 << _T(" (0x") << std::hex << comparison.offset << std::dec << _T(")");
+				break;
+			}
+			if(comparison.outcome != Files::Unreadable)
+			{
+				expectedText << _T("\n") << comparison.expectedDump;
+				actualText << _T("\n") << comparison.actualDump;
+			}
+			text = ostr.str();
+			left = expectedText.str();
+			right = actualText.str();
+		}
+		Assert::Fail(message, text.c_str(), left, right, site);
+	}
+
+	// the failures of AreNear and CollectionAreNear - the error is in the unit of the tolerance
+	template <class T>
+	UNITTEST_COLD static void FailNear(LPCTSTR message, T expected, T actual, const Tolerance& tolerance, const Site& site)
+	{
+		std::string text, left, right;
+		{
+			Allocations::Ignore ignore;
+			std::ostringstream ostr, expectedText, actualText;
+			ostr << _T("AreNear: Values were not ") << tolerance.Describe() << _T(" (error ") << tolerance.Error(expected, actual) << _T(")");
+			Collections::Print(expectedText, expected);
+			Collections::Print(actualText, actual);
+			text = ostr.str();
+			left = expectedText.str();
+			right = actualText.str();
+		}
+		Assert::Fail(message, text.c_str(), left, right, site);
+	}
+
+	template <class T>
+	UNITTEST_COLD static void FailCollectionNear(LPCTSTR message, const T* expected, size_t expectedCount, const T* actual, size_t actualCount,
+												 const Tolerance& tolerance, const Site& site)
+	{
+		if(expectedCount != actualCount)
+		{
+			Assert::FailCollection(message, _T("CollectionAreNear: Collections had different lengths"),
+								   expected, expectedCount, actual, actualCount, std::min(expectedCount, actualCount), site);
+			return;
+		}
+		std::string text, expectedWindow, actualWindow;
+		{
+			Allocations::Ignore ignore;
+			double error = 0;
+			size_t worst = tolerance.Worst(expected, actual, expectedCount, error);
+			std::ostringstream ostr;
+			ostr << _T("CollectionAreNear: ") << tolerance.Outside(expected, actual, expectedCount) << _T(" of ") << expectedCount
+				 << _T(" elements were not ") << tolerance.Describe() << _T(" - the worst at index ") << worst << _T(" (error ") << error << _T(")");
+			text = ostr.str();
+			expectedWindow = Collections::Window(expected, expectedCount, worst);
+			actualWindow = Collections::Window(actual, actualCount, worst);
+		}
+		Assert::Fail(message, text.c_str(), expectedWindow, actualWindow, site);
+	}
+
+	// the failures of the CollectionAssert methods - the only code which prints the elements
+	template <class T1, class T2>
+	UNITTEST_COLD static void FailCollection(LPCTSTR message, LPCTSTR message_fail, const T1* expected, size_t expectedCount,
+											 const T2* actual, size_t actualCount, size_t index, const Site& site)
+	{
+		std::string text, expectedWindow, actualWindow;
+		{
+			Allocations::Ignore ignore;
+			std::ostringstream ostr;
+			ostr << message_fail << _T(" at index ") << index;
+			if(expectedCount != actualCount)
+			{
+				ostr << _T(" (expected ") << expectedCount << _T(" elements, actual ") << actualCount << _T(")");
+			}
+			text = ostr.str();
+			expectedWindow = Collections::Window(expected, expectedCount, index);
+			actualWindow = Collections::Window(actual, actualCount, index);
+		}
+		Assert::Fail(message, text.c_str(), expectedWindow, actualWindow, site);
+	}
+
+	template <class T>
+	UNITTEST_COLD static void FailOrdered(LPCTSTR message, const T* data, size_t count, size_t index, const Site& site)
+	{
+		std::string text, window;
+		{
+			Allocations::Ignore ignore;
+			std::ostringstream ostr;
+			ostr << _T("CollectionIsOrdered: Collection was not ordered at index ") << index;
+			text = ostr.str();
+			window = Collections::Window(data, count, index);
+		}
+		Assert::Fail(message, text.c_str(), std::string(_T("ascending order")), window, site);
+	}
+
+	template <class T, class V>
+	UNITTEST_COLD static void FailContains(LPCTSTR message, const T* data, size_t count, const V& value, const Site& site)
+	{
+		std::string expected, window;
+		{
+			Allocations::Ignore ignore;
+			std::ostringstream ostr;
+			Collections::Print(ostr, value);
+			expected = ostr.str();
+			window = Collections::Window(data, count, Collections::NoIndex);
+		}
+		Assert::Fail(message, _T("CollectionContains: Value was not contained in the collection"), expected, window, site);
+	}
+
+	UNITTEST_COLD static void FailEquivalent(LPCTSTR message, const std::string& value, size_t expectedTimes, size_t expectedCount,
+											 size_t actualTimes, size_t actualCount, const Site& site)
+	{
+		std::ostringstream expected, actual;
+		{
+			Allocations::Ignore ignore;
+			expected << value << _T(" occurs ") << expectedTimes << _T(" times (") << expectedCount << _T(" elements)");
+			actual << value << _T(" occurs ") << actualTimes << _T(" times (") << actualCount << _T(" elements)");
+		}
+		Assert::Fail(message, _T("CollectionAreEquivalent: Collections were not equivalent"), expected.str(), actual.str(), site);
+	}
+
+	// the 'Actual' text of the performance asserts
+	static std::string Duration(const Performance::Measurement& measurement)
+	{
+		std::ostringstream ostr;
+		ostr << Benchmark::Time(measurement.median) << _T(" (median of ") << measurement.samples
+			 << _T(" runs, ") << measurement.rejected << _T(" outliers rejected)");
+		return ostr.str();
+	}
+
+	static void FormatMessage(std::ostringstream& ostr, LPCTSTR message1, LPCTSTR message2, LPCSTR file, int line, bool newline)
+	{
+		if(newline)
+		{
+			ostr << message1 << std::endl;
+			if(message2)
+			{
+				ostr << message2 << std::endl;
+			}
+			ostr << _T("at ") << file << _T(" (") << line << _T(")");
+		}
+		else
+		{
+			ostr << message1 << _T(" ");
+			if(message2)
+			{
+				ostr << message2 << _T(" ");
+			}
+			ostr << _T("at ") << file << _T(" (") << line << _T(")");
+		}
+	}
+
+	// the values through their ValueFormatter (__int64 and ULONGLONG included) or operator<<, bounded by class Diff
+	template <class T1, class T2>
+	static void FormatMessage(std::string& text, LPCTSTR message1, LPCTSTR message2, const T1& expected, const T2& actual, LPCSTR file, int line)
+	{
+		text.append(message1).append(_T("\n"));
+		if(message2)
+		{
+			text.append(message2).append(_T("\n"));
+		}
+		Diff::Text left, right;		// bounded: a view of a string, or the first characters printed
+		Diff::Render(expected, left);
+		Diff::Render(actual, right);
+		Diff::Format(text, left, right);
+		char number[16];
+		FormatBuffer out(number, sizeof(number));
+		out << line;
+		text.append(_T("at ")).append(file).append(_T(" (")).append(out.Data(), out.Size()).append(_T(")"));
+	}
+
+	static void Fail(LPCTSTR message1, LPCTSTR message2, bool throws, LPCSTR file, int line)
+	{
+		Assert::Fail(message1, message2, Site::At(file, line, NULL, throws));
+	}
+
+	static void Pass(LPCTSTR message1, LPCTSTR message2, bool throws, LPCSTR file, int line)
+	{
+		Assert::Pass(message1, message2, Site::At(file, line, NULL, throws));
+	}
+
+	template <class T1, class T2>
+	static void Fail(LPCTSTR message1, LPCTSTR message2, const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	{
+		Assert::Fail(message1, message2, expected, actual, Site::At(file, line, NULL, throws));
+	}
+
+	template <class T1, class T2>
+	static void Pass(LPCTSTR message1, LPCTSTR message2, const T1& /*expected*/, const T2& /*actual*/, bool throws, LPCSTR file, int line)
+	{	// the pass message does not print the values - share the non-template path
+		Assert::Pass(message1, message2, throws, file, line);
+	}
+
+	// the one copy of the report paths: a NULL message moves the pass / fail text in its place
+	UNITTEST_COLD static void Fail(LPCTSTR message, LPCTSTR message_fail, const Site& site)
+	{
+		Statistics::AddFail(site.file, site.line);
+		SiteProfile::Failed(site);
+		Allocations::Ignore ignore;
+		std::ostringstream ostr;
+		FormatMessage(ostr, message ? message : message_fail, message ? message_fail : NULL, site.file, site.line, true);	// new line is needed in fail method 
+		if(site.throws)
+		{
+			Reporter::Flush();	// print the records which were posted before the exception
+			throw std::runtime_error(ostr.str());
+		}
+		Reporter::Fail(ostr.str(), site);
+	}
+
+	static void Pass(LPCTSTR message, LPCTSTR message_pass, const Site& site)
+	{	// inline: the count, and the constant mode of the site folds away
+		Statistics::AddPass(site.file, site.line);
+		if(site.throws || Statistics::IsQuiet())
+		{	// do not format or print pass messages in case of assertion or quiet mode
+			return;
+		}
+		Assert::Report(message, message_pass, site);
+	}
+
+	UNITTEST_NOINLINE static void Report(LPCTSTR message, LPCTSTR message_pass, const Site& site)
+	{
+		Allocations::Ignore ignore;
+		Reporter::Pass(message ? message : message_pass, message ? message_pass : NULL, site);	// the writers format the message
+	}
+
+	template <class T1, class T2>
+	UNITTEST_COLD static void Fail(LPCTSTR message, LPCTSTR message_fail, const T1& expected, const T2& actual, const Site& site)
+	{
+		Statistics::AddFail(site.file, site.line);
+		SiteProfile::Failed(site);
+		Allocations::Ignore ignore;
+		std::string text;
+		FormatMessage(text, message ? message : message_fail, message ? message_fail : NULL, expected, actual, site.file, site.line);
+		if(site.throws)
+		{
+			Reporter::Flush();	// print the records which were posted before the exception
+			throw std::runtime_error(text);
+		}
+		Reporter::Fail(text, site);
+	}
+
+};	// Assert
+
+///////////////////////////////////////////////////////////////////////////////
+// class AllocationScope - the loop object of ASSERT_MAX_ALLOCATIONS: the first
+// Once() takes the snapshot and runs the body, the second one tests the calls
+///////////////////////////////////////////////////////////////////////////////
+class AllocationScope
+{
+public:
+	AllocationScope(unsigned long long maximum, LPCTSTR message, bool throws, LPCSTR file, int line) :
+		m_maximum(maximum), m_message(message), m_throws(throws), m_file(file), m_line(line), m_started(false), m_calls(0)
+	{
+	}
+
+	bool Once()
+	{
+		if(!m_started)
+		{
+			m_started = true;
+			m_calls = Allocations::Thread().calls;
+			return true;
+		}
+		Assert::MaxAllocations(m_maximum, Allocations::Thread().calls - m_calls, m_message, m_throws, m_file, m_line);
+		return false;
+	}
+
+private:
+	unsigned long long	m_maximum;
+	LPCTSTR				m_message;
+	bool				m_throws;
+	LPCSTR				m_file;
+	int					m_line;
+	bool				m_started;
+	unsigned long long	m_calls;
+};	// AllocationScope
+
+///////////////////////////////////////////////////////////////////////////////
+// class ResourceScope - the loop object of ASSERT_MAX_CPU_TIME / ASSERT_MAX_RSS_DELTA
+///////////////////////////////////////////////////////////////////////////////
+class ResourceScope
+{
+public:
+	enum Kind { CpuTime, RssDelta };
+
+	ResourceScope(Kind kind, double maximum, LPCTSTR message, bool throws, LPCSTR file, int line) :
+		m_kind(kind), m_maximum(maximum), m_message(message), m_throws(throws), m_file(file), m_line(line), m_started(false)
+	{
+	}
+
+	bool Once()
+	{
+		if(!m_started)
+		{
+			m_started = true;
+			m_begin = Resources::Sample();
+			return true;
+		}
+		Resources::Usage usage = Resources::Since(m_begin);
+		(m_kind == CpuTime) ?
+			Assert::MaxCpuTime(m_maximum, usage, m_message, m_throws, m_file, m_line) :
+			Assert::MaxRssDelta(m_maximum, usage, m_message, m_throws, m_file, m_line);
+		return false;
+	}
+
+private:
+	Kind				m_kind;
+	double				m_maximum;
+	LPCTSTR				m_message;
+	bool				m_throws;
+	LPCSTR				m_file;
+	int					m_line;
+	bool				m_started;
+	Resources::Usage	m_begin;
+};	// ResourceScope
+
+///////////////////////////////////////////////////////////////////////////////
+// class Registry - static list of the TEST_CASE functions
+///////////////////////////////////////////////////////////////////////////////
+class Registry
+{
+public:
+	static void Add(const TestCase& test)
+	{
+		Registry::Cases().push_back(test);
+	}
+	static std::vector<TestCase>& Cases()
+	{
+		static std::vector<TestCase> cases;
+		return cases;
+	}
+};	// Registry
+
+// static objects created by TEST_CASE - registration runs before main()
+class Registrar
+{
+public:
+	Registrar(LPCSTR suite, LPCSTR name, TestFunction function, LPCSTR file, int line, bool benchmark = false, LPCSTR tags = NULL)
+	{
+		TestCase test = { suite, name, function, file, line, benchmark, tags };
+		Registry::Add(test);
+	}
+};	// Registrar
+
+///////////////////////////////////////////////////////////////////////////////
+// class CaseIndex - the sorted names and the tag bitsets of the registered cases
+// Built at startup only when --filter, --tags or --list is given: one blob of the
+// "suite.name" strings, the case numbers sorted by name, and one bitset (a bit
+// per registered case) per tag. A --filter glob with a literal prefix looks only
+// at the range of names which start with it, and a --tags expression is a few
+// word operations per tag over the bitsets.
+///////////////////////////////////////////////////////////////////////////////
+class CaseIndex
+{
+public:
+	typedef std::vector<unsigned long long> Bits;	// bit i - Registry::Cases()[i]
+
+	CaseIndex() : m_count(Registry::Cases().size())
+	{
+		const std::vector<TestCase>& cases = Registry::Cases();
+		std::map<LPCSTR, std::vector<Bits*> > parsed;
+		m_offsets.reserve(m_count);
+		for(size_t i = 0; i < m_count; ++i)
+		{
+			m_offsets.push_back(static_cast<unsigned>(m_names.size()));
+			m_names.append(cases[i].suite).append(1, '.').append(cases[i].name).append(1, '\0');
+			if(!cases[i].tags || !*cases[i].tags)
+			{
+				continue;
+			}
+			std::vector<Bits*>& tags = parsed[cases[i].tags];	// a tags literal is parsed once
+			if(tags.empty())
+			{
+				for(LPCSTR tag = cases[i].tags; *tag; )
+				{
+					const size_t length = strcspn(tag, ", ");
+					if(length)
+					{
+						Bits& bits = m_tags[std::string(tag, length)];
+						bits.resize(this->Words(), 0);
+						tags.push_back(&bits);
+					}
+					tag += length + strspn(tag + length, ", ");
+				}
+			}
+			for(size_t t = 0; t < tags.size(); ++t)
+			{
+				(*tags[t])[i / 64] |= 1ULL << (i % 64);
+			}
+		}
+		// sorted by the first 16 bytes as two big endian numbers, then by the rest of the name -
+		// most comparisons are integer compares instead of a strcmp of two cold strings
+		const char* names = m_names.c_str();
+		std::vector<Key> keys(m_count);
+		for(size_t i = 0; i < m_count; ++i)
+		{
+			LPCSTR name = names + m_offsets[i];
+			Key& key = keys[i];
+			key.high = key.low = 0;
+			key.index = static_cast<unsigned>(i);
+			for(size_t b = 0; b < 16; ++b)
+			{
+				unsigned long long& half = (b < 8) ? key.high : key.low;
+				half = (half << 8) | static_cast<unsigned char>(*name);
+				name += (*name != '\0');
+			}
+		}
+		const std::vector<unsigned>& offsets = m_offsets;
+		std::sort(keys.begin(), keys.end(), [names, &offsets](const Key& left, const Key& right)
+		{
+			if(left.high != right.high || left.low != right.low)
+			{
+				return left.high < right.high || (left.high == right.high && left.low < right.low);
+			}
+			// equal keys without a NUL are 16 equal characters; with one, both names ended
+			return (left.low & 0xff) && strcmp(names + offsets[left.index] + 16, names + offsets[right.index] + 16) < 0;
+		});
+		m_sorted.resize(m_count);
+		for(size_t i = 0; i < m_count; ++i)
+		{
+			m_sorted[i] = keys[i].index;
+		}
+	}
+
+	// every registered case
+	Bits All() const
+	{
+		Bits bits(this->Words(), ~0ULL);
+		this->Trim(bits);
+		return bits;
+	}
+
+	// --filter: comma separated globs ('*' and '?') over "suite.name"; a pattern which
+	// starts with '-' removes its matches, so "Parser.*,-Parser.Slow*" is valid
+	Bits Filter(const std::string& patterns) const
+	{
+		Bits included(this->Words(), 0);
+		Bits excluded(this->Words(), 0);
+		bool positive = false;
+		for(size_t begin = 0; begin <= patterns.size(); )
+		{
+			size_t end = patterns.find(',', begin);
+			end = (end == std::string::npos) ? patterns.size() : end;
+			std::string pattern = patterns.substr(begin, end - begin);
+			begin = end + 1;
+			if(pattern.empty())
+			{
+				continue;
+			}
+			const bool exclude = (pattern[0] == '-');
+			if(exclude)
+			{
+				pattern.erase(0, 1);
+			}
+			positive |= !exclude;
+			this->Match(pattern, exclude ? excluded : included);
+		}
+		if(!positive)
+		{	// only exclusions - they apply to every case
+			included = this->All();
+		}
+		for(size_t i = 0; i < included.size(); ++i)
+		{
+			included[i] &= ~excluded[i];
+		}
+		return included;
+	}
+
+	// --tags: tag names combined with '!', '&', '|' and parentheses ("fast & !io");
+	// an unknown tag matches no case. Returns false with an error on a syntax error.
+	bool Tags(const std::string& expression, Bits& bits, std::string& error) const
+	{
+		size_t position = 0;
+		if(!this->Or(expression, position, bits, error))
+		{
+			return false;
+		}
+		this->Skip(expression, position);
+		if(position != expression.size())
+		{
+			error = std::string(_T("unexpected '")) + expression[position] + _T("' at ") + std::to_string(position + 1);
+			return false;
+		}
+		return true;
+	}
+
+	// the registration order of the selected cases
+	static void Selection(const Bits& bits, std::vector<size_t>& selection)
+	{
+		size_t count = 0;
+		for(size_t word = 0; word < bits.size(); ++word)
+		{
+			count += std::bitset<64>(bits[word]).count();
+		}
+		selection.reserve(selection.size() + count);
+		for(size_t word = 0; word < bits.size(); ++word)
+		{
+			for(unsigned long long rest = bits[word]; rest; rest &= rest - 1)
+			{
+				selection.push_back(word * 64 + CaseIndex::LowestBit(rest));
+			}
+		}
+	}
+
+	// --list: the selected cases in name order, with their tags
+	void List(std::ostream& out, const std::vector<size_t>& selection) const
+	{
+		Bits bits(this->Words(), 0);
+		for(size_t i = 0; i < selection.size(); ++i)
+		{
+			bits[selection[i] / 64] |= 1ULL << (selection[i] % 64);
+		}
+		const std::vector<TestCase>& cases = Registry::Cases();
+		for(size_t i = 0; i < m_count; ++i)
+		{
+			const unsigned index = m_sorted[i];
+			if(bits[index / 64] & (1ULL << (index % 64)))
+			{
+				out << m_names.c_str() + m_offsets[index];
+				if(cases[index].tags && *cases[index].tags)
+				{
+					out << _T(" [") << cases[index].tags << _T("]");
+				}
+				out << '\n';
+			}
+		}
+		out << selection.size() << _T(" cases") << std::endl;
+	}
+
+	// '*' - any run of characters, '?' - any one character
+	static bool Glob(LPCSTR pattern, LPCSTR text)
+	{
+		LPCSTR star = NULL;		// the last '*' and the text it matched up to
+		LPCSTR resume = NULL;
+		while(*text)
+		{
+			if(*pattern == '*')
+			{
+				star = pattern++;
+				resume = text;
+			}
+			else if(*pattern == '?' || *pattern == *text)
+			{
+				++pattern;
+				++text;
+			}
+			else if(star)
+			{	// the '*' takes one more character
+				pattern = star + 1;
+				text = ++resume;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		while(*pattern == '*')
+		{
+			++pattern;
+		}
+		return *pattern == '\0';
+	}
+
+private:
+	struct Key
+	{
+		unsigned long long	high;	// name bytes 0-7
+		unsigned long long	low;	// name bytes 8-15
+		unsigned			index;
+	};
+
+	size_t Words() const
+	{
+		return (m_count + 63) / 64;
+	}
+	void Trim(Bits& bits) const
+	{
+		if(m_count % 64)
+		{
+			bits.back() &= (1ULL << (m_count % 64)) - 1;
+		}
+	}
+
+	static unsigned LowestBit(unsigned long long word)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		if(_BitScanForward(&index, static_cast<unsigned long>(word)))
+		{
+			return index;
+		}
+		_BitScanForward(&index, static_cast<unsigned long>(word >> 32));
+		return 32 + index;
+#else
+		return static_cast<unsigned>(__builtin_ctzll(word));
+#endif
+	}
+
+	// the names which start with the literal prefix of the pattern are one range of m_sorted
+	void Match(const std::string& pattern, Bits& bits) const
+	{
+		const std::string prefix = pattern.substr(0, pattern.find_first_of(_T("*?")));
+		const char* names = m_names.c_str();
+		const std::vector<unsigned>& offsets = m_offsets;
+		std::vector<unsigned>::const_iterator first = std::lower_bound(m_sorted.begin(), m_sorted.end(), prefix,
+			[names, &offsets](unsigned index, const std::string& value) { return strcmp(names + offsets[index], value.c_str()) < 0; });
+		for(; first != m_sorted.end(); ++first)
+		{
+			LPCSTR name = names + offsets[*first];
+			if(strncmp(name, prefix.c_str(), prefix.size()) != 0)
+			{
+				break;
+			}
+			if(prefix.size() == pattern.size() ? name[prefix.size()] == '\0' : CaseIndex::Glob(pattern.c_str() + prefix.size(), name + prefix.size()))
+			{
+				bits[*first / 64] |= 1ULL << (*first % 64);
+			}
+		}
+	}
+
+	// or := and ('|' and)*, and := unary ('&' unary)*, unary := '!' unary | '(' or ')' | tag
+	static void Skip(const std::string& text, size_t& position)
+	{
+		while(position < text.size() && isspace(static_cast<unsigned char>(text[position])))
+		{
+			++position;
+		}
+	}
+	bool Or(const std::string& text, size_t& position, Bits& bits, std::string& error) const
+	{
+		if(!this->And(text, position, bits, error))
+		{
+			return false;
+		}
+		for(this->Skip(text, position); position < text.size() && text[position] == '|'; this->Skip(text, position))
+		{
+			Bits right;
+			if(!this->And(text, ++position, right, error))
+			{
+				return false;
+			}
+			for(size_t i = 0; i < bits.size(); ++i)
+			{
+				bits[i] |= right[i];
+			}
+		}
+		return true;
+	}
+	bool And(const std::string& text, size_t& position, Bits& bits, std::string& error) const
+	{
+		if(!this->Unary(text, position, bits, error))
+		{
+			return false;
+		}
+		for(this->Skip(text, position); position < text.size() && text[position] == '&'; this->Skip(text, position))
+		{
+			Bits right;
+			if(!this->Unary(text, ++position, right, error))
+			{
+				return false;
+			}
+			for(size_t i = 0; i < bits.size(); ++i)
+			{
+				bits[i] &= right[i];
+			}
+		}
+		return true;
+	}
+	bool Unary(const std::string& text, size_t& position, Bits& bits, std::string& error) const
+	{
+		this->Skip(text, position);
+		if(position < text.size() && text[position] == '!')
+		{
+			if(!this->Unary(text, ++position, bits, error))
+			{
+				return false;
+			}
+			for(size_t i = 0; i < bits.size(); ++i)
+			{
+				bits[i] = ~bits[i];
+			}
+			this->Trim(bits);
+			return true;
+		}
+		if(position < text.size() && text[position] == '(')
+		{
+			if(!this->Or(text, ++position, bits, error))
+			{
+				return false;
+			}
+			this->Skip(text, position);
+			if(position >= text.size() || text[position] != ')')
+			{
+				error = _T("missing ')' at ") + std::to_string(position + 1);
+				return false;
+			}
+			++position;
+			return true;
+		}
+		const size_t begin = position;
+		while(position < text.size() && (isalnum(static_cast<unsigned char>(text[position])) || (text[position] && strchr(_T("_-.:"), text[position]))))
+		{
+			++position;
+		}
+		if(position == begin)
+		{
+			error = _T("expected a tag at ") + std::to_string(position + 1);
+			return false;
+		}
+		std::map<std::string, Bits>::const_iterator tag = m_tags.find(text.substr(begin, position - begin));
+		bits = (tag != m_tags.end()) ? tag->second : Bits(this->Words(), 0);
+		return true;
+	}
+
+	size_t							m_count;
+	std::string						m_names;	// "suite.name\0" of every case, in registration order
+	std::vector<unsigned>			m_offsets;	// of each case in m_names
+	std::vector<unsigned>			m_sorted;	// the case numbers in name order
+	std::map<std::string, Bits>		m_tags;
+};	// CaseIndex
+
+///////////////////////////////////////////////////////////////////////////////
+// class ResultCache - the outcome, duration and inputs of every case in the
+// previous run (--cache FILE), behind --failed-first, --only-failed, --changed-only
+// and --longest-first
+// A case depends on its source file and on the files it declared with
+// TEST_INPUT(path) while it ran. Its fingerprint hashes the path and the contents
+// of each, in order; --changed-only skips a case which passed last time and whose
+// fingerprint is unchanged. A file whose size and modification time match its
+// File record is not read again, so an unchanged tree costs one stat() per file.
+// Layout: a Header, the Entry records sorted by key (a hash of "suite.name"), the
+// File records, the dependency list (file ids) and the NUL terminated paths. The
+// cache is mapped and searched in place - nothing is parsed at startup.
+// The code under test is not fingerprinted (any rebuild would change all of it):
+// a case which must rerun when a library source changes declares it with TEST_INPUT.
+///////////////////////////////////////////////////////////////////////////////
+class ResultCache
+{
+public:
+	struct Header
+	{
+		char				magic[8];		// "UTCACH1"
+		unsigned			entrySize;		// sizeof(Entry)
+		unsigned			fileSize;		// sizeof(File)
+		unsigned long long	entries;
+		unsigned long long	files;
+		unsigned long long	dependencies;	// file ids - Entry::first, Entry::count
+		unsigned long long	paths;			// bytes of the path table
+	};
+
+	enum { Failed = 1, Unreadable = 2 };	// Entry::flags (Unreadable: a dependency was) and File::flags
+
+	struct Entry
+	{
+		unsigned long long	key;			// ResultCache::Key
+		unsigned long long	fingerprint;	// the paths and contents of the dependencies
+		double				seconds;		// the duration of the last run of the case
+		unsigned			first;			// the dependencies of the case
+		unsigned			count;
+		unsigned			flags;
+		unsigned			reserved;
+	};
+
+	struct File
+	{
+		unsigned long long	size;
+		long long			modified;		// nanoseconds since the epoch
+		unsigned long long	hash;			// of the contents
+		unsigned			path;			// offset in the path table
+		unsigned			flags;
+	};
+
+	// maps the cache of the previous run - a missing or foreign file is an empty cache
+	explicit ResultCache(LPCSTR path) : m_path(path), m_mapping(path), m_header(NULL), m_entries(NULL), m_files(NULL),
+		m_dependencies(NULL), m_paths(NULL)
+	{
+		const char* data = m_mapping.Data();
+		const size_t size = m_mapping.Size();
+		const Header* header = reinterpret_cast<const Header*>(data);
+		if(!data || size < sizeof(Header) || memcmp(header->magic, "UTCACH1", 8) != 0 ||
+		   header->entrySize != sizeof(Entry) || header->fileSize != sizeof(File) ||
+		   header->entries > size / sizeof(Entry) || header->files > size / sizeof(File) ||
+		   header->dependencies > size / sizeof(unsigned) || header->paths > size ||
+		   size != sizeof(Header) + header->entries * sizeof(Entry) + header->files * sizeof(File) +
+				   ResultCache::Padded(header->dependencies * sizeof(unsigned)) + header->paths ||
+		   (header->paths && data[size - 1] != '\0'))
+		{
+			return;
+		}
+		m_header = header;
+		m_entries = reinterpret_cast<const Entry*>(data + sizeof(Header));
+		m_files = reinterpret_cast<const File*>(m_entries + header->entries);
+		m_dependencies = reinterpret_cast<const unsigned*>(m_files + header->files);
+		m_paths = data + size - header->paths;
+		m_current.resize(static_cast<size_t>(header->files));
+		m_known.resize(static_cast<size_t>(header->files), false);
+	}
+
+	// the entry of a case in the previous run, NULL for a new case
+	const Entry* Find(const TestCase& test) const
+	{
+		if(!m_header)
+		{
+			return NULL;
+		}
+		const unsigned long long key = ResultCache::Key(test);
+		const Entry* last = m_entries + m_header->entries;
+		const Entry* found = std::lower_bound(m_entries, last, key,
+											  [](const Entry& entry, unsigned long long value) { return entry.key < value; });
+		return (found != last && found->key == key) ? found : NULL;
+	}
+
+	bool HasFailed(const TestCase& test) const
+	{
+		const Entry* entry = this->Find(test);
+		return entry && (entry->flags & Failed);
+	}
+
+	// the expected duration of each selected case: its last duration, else the mean of its
+	// suite in the previous run, else the mean of every case; 0 without a history
+	void Estimate(const std::vector<size_t>& selection, std::vector<double>& estimates) const
+	{
+		const std::vector<TestCase>& cases = Registry::Cases();
+		std::map<std::string, std::pair<double, size_t> > suites;
+		std::pair<double, size_t> all(0, 0);
+		std::vector<const Entry*> entries(cases.size(), NULL);
+		for(size_t i = 0; i < cases.size() && m_header; ++i)
+		{
+			if((entries[i] = this->Find(cases[i])) != NULL)
+			{
+				std::pair<double, size_t>& suite = suites[cases[i].suite];
+				suite.first += entries[i]->seconds;
+				++suite.second;
+				all.first += entries[i]->seconds;
+				++all.second;
+			}
+		}
+		estimates.resize(selection.size());
+		for(size_t i = 0; i < selection.size(); ++i)
+		{
+			const size_t index = selection[i];
+			std::map<std::string, std::pair<double, size_t> >::const_iterator suite;
+			estimates[i] = entries[index] ? entries[index]->seconds :
+						   ((suite = suites.find(cases[index].suite)) != suites.end()) ? suite->second.first / suite->second.second :
+						   all.second ? all.first / all.second : 0;
+		}
+	}
+
+	// filters and orders the selection in place, returns the number of cases left out
+	size_t Select(std::vector<size_t>& selection, bool failedFirst, bool onlyFailed, bool changedOnly)
+	{
+		const std::vector<TestCase>& cases = Registry::Cases();
+		std::vector<size_t> first;
+		std::vector<size_t> rest;
+		for(size_t i = 0; i < selection.size(); ++i)
+		{
+			const Entry* entry = this->Find(cases[selection[i]]);
+			const bool failed = entry && (entry->flags & Failed);
+			if((onlyFailed && !failed) || (changedOnly && entry && !failed && !this->Changed(*entry)))
+			{
+				continue;
+			}
+			((failedFirst && failed) ? first : rest).push_back(selection[i]);
+		}
+		const size_t skipped = selection.size() - first.size() - rest.size();
+		first.insert(first.end(), rest.begin(), rest.end());
+		selection.swap(first);
+		return skipped;
+	}
+
+	// writes the results of the selected cases and keeps the previous entries of the
+	// other registered cases (another shard, or skipped by --changed-only)
+	bool Save(const std::vector<size_t>& selection, const std::vector<CaseResult>& results)
+	{
+		const std::vector<TestCase>& cases = Registry::Cases();
+		std::vector<bool> ran(cases.size(), false);
+		for(size_t i = 0; i < selection.size(); ++i)
+		{
+			ran[selection[i]] = true;
+		}
+		Table table;
+		for(size_t i = 0; i < cases.size(); ++i)
+		{
+			const Entry* previous = ran[i] ? NULL : this->Find(cases[i]);
+			if(!ran[i] && !previous)
+			{
+				continue;
+			}
+			Entry entry;
+			memset(&entry, 0, sizeof(entry));
+			entry.key = ResultCache::Key(cases[i]);
+			entry.first = static_cast<unsigned>(table.dependencies.size());
+			if(previous)
+			{	// the fingerprint stays the one of the contents this result was measured on
+				entry.fingerprint = previous->fingerprint;
+				entry.seconds = previous->seconds;
+				entry.flags = previous->flags;
+				for(unsigned d = 0; d < previous->count; ++d)
+				{
+					unsigned id;
+					if(this->Dependency(*previous, d, id))
+					{
+						table.dependencies.push_back(this->Add(table, m_paths + m_files[id].path));
+					}
+				}
+			}
+			else
+			{
+				const CaseResult& result = results[i];
+				entry.seconds = result.seconds;
+				entry.flags = (result.counters.failed || result.aborted) ? Failed : 0;
+				entry.fingerprint = entry.key;
+				this->Depend(table, entry, cases[i].file);
+				for(size_t n = 0; n < result.inputs.size(); ++n)
+				{
+					this->Depend(table, entry, result.inputs[n]);
+				}
+			}
+			entry.count = static_cast<unsigned>(table.dependencies.size()) - entry.first;
+			table.entries.push_back(entry);
+		}
+		std::sort(table.entries.begin(), table.entries.end(),
+				  [](const Entry& left, const Entry& right) { return left.key < right.key; });
+		return ResultCache::Write(m_path, table);
+	}
+
+	// FNV-1a of "suite.name" - the identity of a case across runs and rebuilds
+	static unsigned long long Key(const TestCase& test)
+	{
+		unsigned long long hash = ResultCache::Hash(test.suite, strlen(test.suite));
+		hash = ResultCache::Hash(".", 1, hash);
+		return ResultCache::Hash(test.name, strlen(test.name), hash);
+	}
+
+	// TEST_INPUT - adds a file to the dependencies of the case running on this thread
+	static void Input(const std::string& path)
+	{
+		if(std::vector<std::string>* inputs = ResultCache::Current())
+		{
+			Allocations::Ignore ignore;
+			inputs->push_back(path);
+		}
+	}
+	// the Runner points the current thread to the inputs of the running case
+	static std::vector<std::string>*& Current()
+	{
+		static thread_local std::vector<std::string>* current = NULL;
+		return current;
+	}
+
+private:
+	struct Table
+	{
+		std::vector<Entry>				entries;
+		std::vector<File>				files;
+		std::vector<unsigned>			dependencies;
+		std::string						paths;
+		std::map<std::string, unsigned>	ids;
+	};
+
+	ResultCache(const ResultCache&);
+	ResultCache& operator=(const ResultCache&);
+
+	static size_t Padded(unsigned long long size)
+	{
+		return static_cast<size_t>((size + 7) & ~7ULL);
+	}
+
+	// FNV-1a over 64 bit words (folded, so the high bits reach the low ones) and the tail bytes -
+	// a change detector, not a checksum
+	static unsigned long long Hash(const void* data, size_t size, unsigned long long hash = 14695981039346656037ULL)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for(; size >= 8; bytes += 8, size -= 8)
+		{
+			unsigned long long word;
+			memcpy(&word, bytes, 8);
+			hash = (hash ^ word) * 1099511628211ULL;
+			hash ^= hash >> 32;
+		}
+		for(; size; ++bytes, --size)
+		{
+			hash = (hash ^ *bytes) * 1099511628211ULL;
+		}
+		return hash;
+	}
+
+	// the current size, time and contents hash of a file; the contents are read only
+	// when the size or the time differ from 'previous'
+	static void Sample(LPCSTR path, const File* previous, File& file)
+	{
+		memset(&file, 0, sizeof(file));
+		file.flags = Unreadable;
+#if defined(_WIN32)
+		struct _stat64 info;
+		if(_stat64(path, &info) != 0)
+		{
+			return;
+		}
+		file.modified = static_cast<long long>(info.st_mtime) * 1000000000LL;
+#else
+		struct stat info;
+		if(stat(path, &info) != 0)
+		{
+			return;
+		}
+#if defined(__linux__)
+		file.modified = static_cast<long long>(info.st_mtim.tv_sec) * 1000000000LL + info.st_mtim.tv_nsec;
+#else
+		file.modified = static_cast<long long>(info.st_mtime) * 1000000000LL;
+#endif
+#endif
+		file.size = static_cast<unsigned long long>(info.st_size);
+		if(previous && !(previous->flags & Unreadable) && previous->size == file.size && previous->modified == file.modified)
+		{
+			file.hash = previous->hash;
+		}
+		else if(file.size == 0)
+		{
+			file.hash = ResultCache::Hash(NULL, 0);
+		}
+		else
+		{
+			Mapping mapping(path);
+			if(!mapping.Data() || mapping.Size() != file.size)
+			{	// changed while it was read - the next run reads it again
+				return;
+			}
+			file.hash = ResultCache::Hash(mapping.Data(), mapping.Size());
+		}
+		file.flags = 0;
+	}
+
+	// the i-th dependency of a previous entry, false if the cache is inconsistent
+	bool Dependency(const Entry& entry, unsigned i, unsigned& id) const
+	{
+		if(entry.first > m_header->dependencies || entry.count > m_header->dependencies - entry.first)
+		{
+			return false;
+		}
+		id = m_dependencies[entry.first + i];
+		return id < m_header->files && m_files[id].path < m_header->paths;
+	}
+
+	// the current state of a file of the previous run, sampled once
+	const File& Current(unsigned id)
+	{
+		if(!m_known[id])
+		{
+			ResultCache::Sample(m_paths + m_files[id].path, &m_files[id], m_current[id]);
+			m_known[id] = true;
+		}
+		return m_current[id];
+	}
+
+	bool Changed(const Entry& entry)
+	{
+		if(entry.flags & Unreadable)
+		{
+			return true;
+		}
+		unsigned long long fingerprint = entry.key;
+		for(unsigned i = 0; i < entry.count; ++i)
+		{
+			unsigned id;
+			if(!this->Dependency(entry, i, id))
+			{
+				return true;
+			}
+			const File& file = this->Current(id);
+			if(file.flags & Unreadable)
+			{
+				return true;
+			}
+			fingerprint = ResultCache::Mix(fingerprint, m_paths + m_files[id].path, file.hash);
+		}
+		return fingerprint != entry.fingerprint;
+	}
+
+	static unsigned long long Mix(unsigned long long fingerprint, LPCSTR path, unsigned long long hash)
+	{
+		fingerprint = ResultCache::Hash(path, strlen(path) + 1, fingerprint);
+		return ResultCache::Hash(&hash, sizeof(hash), fingerprint);
+	}
+
+	// the id of a path in the new table - sampled unless the previous run knew it
+	unsigned Add(Table& table, const std::string& path)
+	{
+		std::map<std::string, unsigned>::const_iterator found = table.ids.find(path);
+		if(found != table.ids.end())
+		{
+			return found->second;
+		}
+		if(m_header && m_previous.empty())
+		{
+			for(unsigned id = 0; id < m_header->files; ++id)
+			{
+				if(m_files[id].path < m_header->paths)
+				{
+					m_previous[m_paths + m_files[id].path] = id;
+				}
+			}
+		}
+		File file;
+		found = m_previous.find(path);
+		if(found != m_previous.end())
+		{
+			file = this->Current(found->second);
+		}
+		else
+		{
+			ResultCache::Sample(path.c_str(), NULL, file);
+		}
+		file.path = static_cast<unsigned>(table.paths.size());
+		table.paths.append(path.c_str(), path.size() + 1);
+		const unsigned id = static_cast<unsigned>(table.files.size());
+		table.files.push_back(file);
+		table.ids[path] = id;
+		return id;
+	}
+
+	// adds a dependency of a case which ran - the same file twice counts once
+	void Depend(Table& table, Entry& entry, const std::string& path)
+	{
+		const unsigned id = this->Add(table, path);
+		for(size_t i = entry.first; i < table.dependencies.size(); ++i)
+		{
+			if(table.dependencies[i] == id)
+			{
+				return;
+			}
+		}
+		table.dependencies.push_back(id);
+		entry.flags |= (table.files[id].flags & Unreadable);
+		entry.fingerprint = ResultCache::Mix(entry.fingerprint, path.c_str(), table.files[id].hash);
+	}
+
+	// written next to the cache and renamed over it, so a reader never sees half a file
+	static bool Write(const std::string& path, const Table& table)
+	{
+		Header header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.magic, "UTCACH1", 8);
+		header.entrySize = sizeof(Entry);
+		header.fileSize = sizeof(File);
+		header.entries = table.entries.size();
+		header.files = table.files.size();
+		header.dependencies = table.dependencies.size();
+		header.paths = table.paths.size();
+		const std::string temporary = path + _T(".tmp");
+		FILE* file = fopen(temporary.c_str(), "wb");
+		if(!file)
+		{
+			return false;
+		}
+		const char padding[8] = { 0 };
+		fwrite(&header, sizeof(header), 1, file);
+		fwrite(table.entries.data(), sizeof(Entry), table.entries.size(), file);
+		fwrite(table.files.data(), sizeof(File), table.files.size(), file);
+		fwrite(table.dependencies.data(), sizeof(unsigned), table.dependencies.size(), file);
+		fwrite(padding, 1, ResultCache::Padded(header.dependencies * sizeof(unsigned)) - header.dependencies * sizeof(unsigned), file);
+		fwrite(table.paths.data(), 1, table.paths.size(), file);
+		const bool written = !ferror(file);
+		if(fclose(file) != 0 || !written)
+		{
+			remove(temporary.c_str());
+			return false;
+		}
+#if defined(_WIN32)
+		return MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+		return rename(temporary.c_str(), path.c_str()) == 0;
+#endif
+	}
+
+	std::string						m_path;
+	Mapping							m_mapping;
+	const Header*					m_header;		// NULL - no usable cache
+	const Entry*					m_entries;
+	const File*						m_files;
+	const unsigned*					m_dependencies;
+	const char*						m_paths;
+	std::vector<File>				m_current;		// the files of the previous run, sampled on demand
+	std::vector<bool>				m_known;
+	std::map<std::string, unsigned>	m_previous;		// path -> file id of the previous run (Save only)
+};	// ResultCache
+
+///////////////////////////////////////////////////////////////////////////////
+// class Watchdog - per case timeouts (--timeout SECONDS, TEST_TIMEOUT in a case)
+// A run owns one Watchdog with a Watch per worker. The worker arms its watch
+// when a case starts, which pushes the deadline into a min-heap, and disarms
+// it when the case ends by counting a generation: the heap entry is not
+// searched for, it is dropped when it surfaces with an older generation. One
+// thread, started by the first deadline, sleeps until the earliest one. The
+// assertions never read the clock - they only leave their file and line in
+// the Statistics::Counters of the case, which are reported as the last
+// assertion site of an expired case. The handler of the Runner ends the worker:
+// a forked one exits and is replaced, an in process run prints the cases which
+// are running and exits with ExitCode.
+///////////////////////////////////////////////////////////////////////////////
+class Watchdog
+{
+public:
+	enum { ExitCode = 124 };	// the exit status of timeout(1)
+
+	typedef std::chrono::steady_clock Clock;
+
+	// one per worker - written by its worker and read by the handler, both under 'lock'
+	struct Watch
+	{
+		std::mutex						lock;		// never taken while the heap is locked
+		const TestCase*					test;		// the running case, NULL between the cases
+		const Statistics::Counters*		counters;	// of the running case - its last assertion site
+		Clock::time_point				start;
+		double							limit;		// seconds from the start, 0 = none
+		std::atomic<unsigned long long>	generation;	// changes whenever the deadline does
+		void*							context;	// for the handler (the result slot of a forked worker)
+		Watchdog*						owner;
+	};
+
+	// runs on the watchdog thread with the expired watch locked; not expected to return
+	typedef void (*Handler)(Watchdog& watchdog, Watch& expired, double elapsed);
+
+	Watchdog(unsigned workers, Handler handler) : m_watches(workers), m_handler(handler), m_stop(false)
+	{
+		for(size_t i = 0; i < m_watches.size(); ++i)
+		{
+			Watch& watch = m_watches[i];
+			watch.test = NULL;
+			watch.counters = NULL;
+			watch.limit = 0;
+			watch.generation.store(0, std::memory_order_relaxed);
+			watch.context = NULL;
+			watch.owner = this;
+		}
+	}
+	~Watchdog()
+	{
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			m_stop = true;
+		}
+		m_wake.notify_one();
+		if(m_thread.joinable())
+		{
+			m_thread.join();
+		}
+	}
+
+	// the limit of every case which does not set its own (--timeout), 0 = none
+	static void SetTimeout(double seconds)
+	{
+		Watchdog::Timeout().store(seconds > 0 ? seconds : 0, std::memory_order_relaxed);
+	}
+	static double GetTimeout()
+	{
+		return Watchdog::Timeout().load(std::memory_order_relaxed);
+	}
+
+	// the calling thread runs its cases on watch 'worker' until Unbind
+	void Bind(unsigned worker, void* context = NULL)
+	{
+		Watch& watch = m_watches[worker];
+		{
+			std::lock_guard<std::mutex> guard(watch.lock);
+			watch.context = context;
+		}
+		Watchdog::Current() = &watch;
+	}
+	static void Unbind()
+	{
+		Watchdog::Current() = NULL;
+	}
+
+	// called by Runner::RunCase - nothing is watched on a thread without a watch
+	static void Begin(const TestCase& test, const Statistics::Counters* counters, Clock::time_point start)
+	{
+		Watch* watch = Watchdog::Current();
+		if(!watch)
+		{
+			return;
+		}
+		std::lock_guard<std::mutex> guard(watch->lock);
+		watch->test = &test;
+		watch->counters = counters;
+		watch->start = start;
+		watch->limit = Watchdog::GetTimeout();
+		watch->owner->Arm(*watch);
+	}
+	static void End()
+	{
+		Watch* watch = Watchdog::Current();
+		if(!watch)
+		{
+			return;
+		}
+		std::lock_guard<std::mutex> guard(watch->lock);
+		watch->test = NULL;
+		watch->generation.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// TEST_TIMEOUT - replaces the limit of the case running on this thread (still counted from its start)
+	static void SetLimit(double seconds)
+	{
+		Watch* watch = Watchdog::Current();
+		if(!watch)
+		{
+			return;
+		}
+		std::lock_guard<std::mutex> guard(watch->lock);
+		if(watch->test)
+		{
+			watch->limit = seconds > 0 ? seconds : 0;
+			watch->owner->Arm(*watch);
+		}
+	}
+
+	// the watches of the other workers, for a handler which reports them (lock each one)
+	std::vector<Watch>& Watches()
+	{
+		return m_watches;
+	}
+
+	// "last assertion at file (line)" of the case of a locked watch. The counters are atomics
+	// the worker keeps storing to (the assertions take no lock): an expired case is sampled
+	// once, and the site may be one assertion old or pair the file of one assertion with the
+	// line of the next.
+	static std::string LastSite(const Watch& watch)
+	{
+		const Statistics::Counters* counters = watch.counters;
+		LPCSTR file = counters ? counters->file.load(std::memory_order_relaxed) : NULL;
+		if(!file)
+		{
+			return _T("no assertion was reached");
+		}
+		char line[16];
+		snprintf(line, sizeof(line), "%d", counters->line.load(std::memory_order_relaxed));
+		return std::string(_T("last assertion at ")) + file + _T(" (") + line + _T(")");
+	}
+	// "timed out after 2.00 s (limit 2 s), last assertion at file (line)"
+	static std::string Expiry(const Watch& watch, double elapsed)
+	{
+		char text[64];
+		snprintf(text, sizeof(text), "timed out after %.2f s (limit %g s), ", elapsed, watch.limit);
+		return text + Watchdog::LastSite(watch);
+	}
+
+private:
+	// a deadline in the heap, live while its generation is the one of the watch
+	struct Entry
+	{
+		Clock::time_point	deadline;
+		Watch*				watch;
+		unsigned long long	generation;
+
+		bool operator>(const Entry& other) const
+		{
+			return deadline > other.deadline;
+		}
+		bool IsLive() const
+		{
+			return generation == watch->generation.load(std::memory_order_relaxed);
+		}
+	};
+
+	// called with the watch locked: a new generation replaces the deadline which is in the heap
+	void Arm(Watch& watch)
+	{
+		const unsigned long long generation = watch.generation.fetch_add(1, std::memory_order_relaxed) + 1;
+		if(watch.limit <= 0)
+		{
+			return;
+		}
+		Entry entry = { watch.start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(watch.limit)),
+						&watch, generation };
+		std::lock_guard<std::mutex> guard(m_lock);
+		if(m_heap.size() > 2 * m_watches.size() + 16)
+		{	// the cases end long before their deadlines - drop the disarmed entries once in a while
+			m_heap.erase(std::remove_if(m_heap.begin(), m_heap.end(), [](const Entry& stale) { return !stale.IsLive(); }),
+						 m_heap.end());
+			std::make_heap(m_heap.begin(), m_heap.end(), std::greater<Entry>());
+		}
+		m_heap.push_back(entry);
+		std::push_heap(m_heap.begin(), m_heap.end(), std::greater<Entry>());
+		if(!m_thread.joinable())
+		{
+			m_thread = std::thread(&Watchdog::Run, this);
+		}
+		else if(m_heap.front().watch == &watch && m_heap.front().generation == generation)
+		{	// the earliest deadline moved up
+			m_wake.notify_one();
+		}
+	}
+
+	void Run()
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		while(!m_stop)
+		{
+			if(m_heap.empty())
+			{
+				m_wake.wait(lock);
+				continue;
+			}
+			const Entry entry = m_heap.front();
+			if(entry.IsLive() && Clock::now() < entry.deadline)
+			{
+				m_wake.wait_until(lock, entry.deadline);
+				continue;
+			}
+			std::pop_heap(m_heap.begin(), m_heap.end(), std::greater<Entry>());
+			m_heap.pop_back();
+			if(!entry.IsLive())
+			{
+				continue;
+			}
+			lock.unlock();	// the lock order is watch, then heap
+			{
+				std::lock_guard<std::mutex> guard(entry.watch->lock);
+				if(entry.IsLive())
+				{	// the case did not end while the heap was unlocked
+					m_handler(*this, *entry.watch, std::chrono::duration<double>(Clock::now() - entry.watch->start).count());
+				}
+			}
+			lock.lock();
+		}
+	}
+
+	static std::atomic<double>& Timeout()
+	{
+		static std::atomic<double> timeout(0);
+		return timeout;
+	}
+	static Watch*& Current()
+	{
+		static thread_local Watch* current = NULL;
+		return current;
+	}
+
+	std::vector<Watch>			m_watches;
+	Handler						m_handler;
+	std::mutex					m_lock;		// the heap and m_stop
+	std::condition_variable		m_wake;
+	std::vector<Entry>			m_heap;		// a min-heap of the deadlines
+	bool						m_stop;
+	std::thread					m_thread;	// started by the first deadline
+
+	Watchdog(const Watchdog&);
+	Watchdog& operator=(const Watchdog&);
+};	// Watchdog
+
+///////////////////////////////////////////////////////////////////////////////
+// class Runner - runs the registered test cases on a work-stealing thread pool
+// Each worker owns a deque of case indices: it pops its own work from the front
+// (registration order) and, when it runs dry, steals from the back of the other
+// workers' deques.
+// A std::runtime_error (ASSERT_XXX) aborts only the running case.
+///////////////////////////////////////////////////////////////////////////////
+class Runner
+{
+public:
+	typedef CaseMetrics	Metrics;
+	typedef CaseResult	Result;
+
+	// command line: [--threads N] [--fork N] [--shard-index I --shard-count C] [--quiet]
+	//				 [--benchmark-warmup MS] [--benchmark-min-time MS] [--benchmark-samples N]
+	//				 [--repetitions N] [--pin-cpu N] [--baseline FILE] [--update-baseline] [--perf-counters]
+	//				 [--junit FILE] [--jsonl FILE] [--binary-log FILE] [--summarize-log FILE] [--profile-sites N]
+	//				 [--failure-bytes N] [--cache FILE] [--failed-first] [--only-failed] [--changed-only]
+	//				 [--longest-first] [--filter GLOBS] [--tags EXPRESSION] [--list] [--timeout SECONDS]
+	static int Main(int argc, char* argv[])
+	{
+		unsigned threads = 0;
+		int processes = -1;		// -1 = in process
+		size_t shardIndex = 0;
+		size_t shardCount = 1;
+		size_t profileTop = 0;	// --profile-sites: the number of sites listed
+		LPCSTR cachePath = NULL;
+		bool failedFirst = false, onlyFailed = false, changedOnly = false, longestFirst = false;
+		LPCSTR filter = NULL;	// --filter globs
+		LPCSTR tags = NULL;		// --tags expression
+		bool list = false;
+		std::vector<std::unique_ptr<ReportWriter> > writers;
+		for(int i = 1; i < argc; ++i)
+		{
+			if(strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+			{
+				threads = static_cast<unsigned>(atoi(argv[++i]));
+			}
+			else if(strcmp(argv[i], "--fork") == 0 && i + 1 < argc)
+			{
+				processes = atoi(argv[++i]);
+			}
+			else if(strcmp(argv[i], "--shard-index") == 0 && i + 1 < argc)
+			{
+				shardIndex = static_cast<size_t>(atoi(argv[++i]));
+			}
+			else if(strcmp(argv[i], "--shard-count") == 0 && i + 1 < argc)
+			{
+				shardCount = static_cast<size_t>(atoi(argv[++i]));
+			}
+			else if(strcmp(argv[i], "--quiet") == 0)
+			{
+				Statistics::SetQuiet(true);
+			}
+			else if(strcmp(argv[i], "--benchmark-warmup") == 0 && i + 1 < argc)
+			{
+				Benchmark::SetWarmup(atof(argv[++i]));
+			}
+			else if(strcmp(argv[i], "--benchmark-min-time") == 0 && i + 1 < argc)
+			{
+				Benchmark::SetMinBatchTime(atof(argv[++i]));
+			}
+			else if(strcmp(argv[i], "--benchmark-samples") == 0 && i + 1 < argc)
+			{
+				Benchmark::SetSamples(static_cast<size_t>(atoi(argv[++i])));
+			}
+			else if(strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc)
+			{
+				Performance::SetRepetitions(static_cast<size_t>(atoi(argv[++i])));
+			}
+			else if(strcmp(argv[i], "--pin-cpu") == 0 && i + 1 < argc)
+			{
+				Performance::SetCpu(atoi(argv[++i]));
+			}
+			else if(strcmp(argv[i], "--baseline") == 0 && i + 1 < argc)
+			{
+				Performance::SetBaselineFile(argv[++i]);
+			}
+			else if(strcmp(argv[i], "--update-baseline") == 0)
+			{
+				Performance::SetUpdateBaseline(true);
+			}
+			else if(strcmp(argv[i], "--perf-counters") == 0)
+			{
+				PerfCounters::SetEnabled(true);
+			}
+			else if(strcmp(argv[i], "--profile-sites") == 0 && i + 1 < argc)
+			{
+				profileTop = static_cast<size_t>(atoi(argv[++i]));
+				SiteProfile::SetEnabled(profileTop > 0);
+			}
+			else if(strcmp(argv[i], "--failure-bytes") == 0 && i + 1 < argc)
+			{
+				Diff::Budget() = static_cast<size_t>(std::max(64, atoi(argv[++i])));
+			}
+			else if(strcmp(argv[i], "--filter") == 0 && i + 1 < argc)
+			{
+				filter = argv[++i];
+			}
+			else if(strcmp(argv[i], "--tags") == 0 && i + 1 < argc)
+			{
+				tags = argv[++i];
+			}
+			else if(strcmp(argv[i], "--list") == 0)
+			{
+				list = true;
+			}
+			else if(strcmp(argv[i], "--timeout") == 0 && i + 1 < argc)
+			{
+				Watchdog::SetTimeout(atof(argv[++i]));
+			}
+			else if(strcmp(argv[i], "--cache") == 0 && i + 1 < argc)
+			{
+				cachePath = argv[++i];
+			}
+			else if(strcmp(argv[i], "--failed-first") == 0)
+			{
+				failedFirst = true;
+			}
+			else if(strcmp(argv[i], "--only-failed") == 0)
+			{
+				onlyFailed = true;
+			}
+			else if(strcmp(argv[i], "--changed-only") == 0)
+			{
+				changedOnly = true;
+			}
+			else if(strcmp(argv[i], "--longest-first") == 0)
+			{
+				longestFirst = true;
+			}
+			else if((strcmp(argv[i], "--junit") == 0 || strcmp(argv[i], "--jsonl") == 0 ||
+					 strcmp(argv[i], "--binary-log") == 0) && i + 1 < argc)
+			{
+				LPCSTR option = argv[i++];
+				ReportWriter* writer = (strcmp(option, "--junit") == 0) ? static_cast<ReportWriter*>(JUnitWriter::Open(argv[i])) :
+									   (strcmp(option, "--jsonl") == 0) ? static_cast<ReportWriter*>(JsonLinesWriter::Open(argv[i])) :
+									   static_cast<ReportWriter*>(BinaryLog::Open(argv[i]));
+				if(!writer)
+				{
+					std::cerr << _T("Cannot create ") << argv[i] << std::endl;
+					return 2;
+				}
+				writers.push_back(std::unique_ptr<ReportWriter>(writer));
+			}
+			else if(strcmp(argv[i], "--summarize-log") == 0 && i + 1 < argc)
+			{	// reads a log of an earlier run - nothing is run
+				return BinaryLog::Summarize(argv[i + 1]);
+			}
+			else
+			{
+				std::cerr << _T("Unknown argument: ") << argv[i] << std::endl;
+				Runner::Usage(argv[0]);
+				return 2;
+			}
+		}
+		if(shardCount == 0 || shardIndex >= shardCount)
+		{
+			std::cerr << _T("Invalid shard: --shard-index must be less than --shard-count") << std::endl;
+			Runner::Usage(argv[0]);
+			return 2;
+		}
+
+		// the registration order is fixed for a given binary, so every machine
+		// running the same binary (with the same filters) computes the same shards
+		std::vector<size_t> selection;
+		std::unique_ptr<CaseIndex> index;
+		if(filter || tags || list)
+		{
+			index.reset(new CaseIndex());
+			CaseIndex::Bits bits = filter ? index->Filter(filter) : index->All();
+			if(tags)
+			{
+				CaseIndex::Bits tagged;
+				std::string error;
+				if(!index->Tags(tags, tagged, error))
+				{
+					std::cerr << _T("Invalid --tags expression: ") << error << std::endl;
+					return 2;
+				}
+				for(size_t i = 0; i < bits.size(); ++i)
+				{
+					bits[i] &= tagged[i];
+				}
+			}
+			CaseIndex::Selection(bits, selection);
+		}
+		else
+		{
+			for(size_t i = 0; i < Registry::Cases().size(); ++i)
+			{
+				selection.push_back(i);
+			}
+		}
+		if(shardCount > 1)
+		{
+			std::vector<size_t> shard;
+			for(size_t i = shardIndex; i < selection.size(); i += shardCount)
+			{
+				shard.push_back(selection[i]);
+			}
+			selection.swap(shard);
+		}
+		std::unique_ptr<ResultCache> cache;
+		if(!cachePath && (failedFirst || onlyFailed || changedOnly || longestFirst))
+		{
+			cachePath = _T(".unittest-cache");
+		}
+		if(cachePath)
+		{	// the previous run is mapped, not parsed - the selection costs one lookup per case
+			cache.reset(new ResultCache(cachePath));
+			const size_t total = selection.size();
+			const size_t skipped = cache->Select(selection, failedFirst, onlyFailed, changedOnly);
+			if(skipped)
+			{
+				std::cout << _T("Cache: ") << skipped << _T(" of ") << total << _T(" cases skipped") << std::endl;
+			}
+		}
+		if(list)
+		{	// nothing is run
+			index->List(std::cout, selection);
+			return 0;
+		}
+		// the benchmarks run alone on this thread after the test cases, so they are not disturbed
+		std::vector<size_t> tests;
+		std::vector<size_t> benchmarks;
+		for(size_t i = 0; i < selection.size(); ++i)
+		{
+			(Registry::Cases()[selection[i]].benchmark ? benchmarks : tests).push_back(selection[i]);
+		}
+		std::vector<double> estimates;	// --longest-first: the expected duration of each test case
+		unsigned workers = Runner::Workers(processes >= 0 ? static_cast<unsigned>(processes) : threads, tests.size());
+		double predicted = 0;
+		if(longestFirst)
+		{	// the cases which failed last time stay in front with --failed-first
+			size_t keep = 0;
+			while(failedFirst && keep < tests.size() && cache->HasFailed(Registry::Cases()[tests[keep]]))
+			{
+				++keep;
+			}
+			cache->Estimate(tests, estimates);
+			predicted = Runner::Schedule(tests, estimates, workers, keep);
+		}
+		for(size_t i = 0; i < writers.size(); ++i)
+		{
+			Reporter::AddWriter(writers[i].get());
+		}
+		std::vector<Result> results;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if(processes >= 0)
+		{	// the workers claim the cases in the order of the selection - longest first is list scheduling
+#if defined(__linux__)
+			Runner::RunForked(tests, static_cast<unsigned>(processes), results);
+#else
+			std::cerr << _T("--fork is supported only on Linux") << std::endl;
+			return 2;
+#endif
+		}
+		else
+		{
+			Runner::Run(tests, threads, results, longestFirst ? &estimates : NULL);
+		}
+		const double makespan = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		Runner::Run(benchmarks, 1, results);
+		Performance::SaveBaselines();
+		RunSummary summary;
+		int status = Runner::Summary(selection, results, summary);
+		if(longestFirst)
+		{
+			std::cout << _T("Schedule: longest first on ") << workers << _T(" workers, predicted makespan ")
+					  << Benchmark::Time(predicted * 1e9) << _T(", actual ") << Benchmark::Time(makespan * 1e9) << std::endl;
+		}
+		if(cache && !cache->Save(selection, results))
+		{
+			std::cerr << _T("Cannot write ") << cachePath << std::endl;
+		}
+		if(profileTop && !SiteProfile::Report(std::cout, profileTop))
+		{
+			std::cerr << _T("No assertion site was profiled - define UNITTEST_PROFILE_SITES before including UnitTest.hpp") << std::endl;
+		}
+		Reporter::Close(summary);
+		for(size_t i = 0; i < writers.size(); ++i)
+		{
+			Reporter::RemoveWriter(writers[i].get());
+		}
+		return status;
 	}
-	static void Contains(LPTSTR expected, LPTSTR actual, bool throws, LPCSTR file, int line)
+
+	static void Usage(LPCSTR program)
 	{
-		Assert::Contains(expected, actual, NULL, throws, file, line);
+		std::cerr << _T("Usage: ") << program
+				  << _T(" [--threads N] [--fork N] [--shard-index I --shard-count C] [--quiet]") << std::endl
+				  << _T("       [--benchmark-warmup MS] [--benchmark-min-time MS] [--benchmark-samples N]") << std::endl
+				  << _T("       [--repetitions N] [--pin-cpu N] [--baseline FILE] [--update-baseline] [--perf-counters]") << std::endl
+				  << _T("       [--junit FILE] [--jsonl FILE] [--binary-log FILE] [--summarize-log FILE] [--profile-sites N]") << std::endl
+				  << _T("       [--failure-bytes N] [--cache FILE] [--failed-first] [--only-failed] [--changed-only]") << std::endl
+				  << _T("       [--longest-first] [--filter GLOBS] [--tags EXPRESSION] [--list] [--timeout SECONDS]") << std::endl;
 	}
-	static void Contains(LPTSTR expected, LPTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
-	{	// check if the 'actual' buffer (=string) contains the 'expected' buffer (=substring)
-		Assert::IsNotEmpty(expected, _T("Contains: expected substring is empty"), throws, file, line);
-		Assert::IsNotEmpty(actual,   _T("Contains: actual string is empty"),      throws, file, line);
-		Assert::LessOrEqual( _tcsclen(expected), _tcsclen(actual),
-									_T("Contains: expected substring is greater than the actual string"), throws, file, line);
 
-		Assert::Test( ( _tcsstr(actual, expected) != NULL ), message,
-			/*[PASS]*/ _T("Contains: Expected substring was contains in the actual string"),
-			/*[FAIL]*/ _T("Contains: Expected substring was not contains in the actual string"),
-						expected, actual, throws, file, line);
+	// the number of workers for a run: 0 means hardware_concurrency, never more than the cases
+	static unsigned Workers(unsigned requested, size_t cases)
+	{
+		if(requested == 0)
+		{
+			requested = std::thread::hardware_concurrency();
+		}
+		if(requested == 0 || requested > cases)
+		{
+			requested = cases ? static_cast<unsigned>(cases) : 1;
+		}
+		return requested;
 	}
 
-	// StartsWith for null terminated strings: (LPCTSTR)x2 and (LPTSTR)x2 - with and without a message
-	static void StartsWith(LPCTSTR expected, LPCTSTR actual, bool throws, LPCSTR file, int line)
+	// longest processing time first: sorts the selection from position 'keep' on by decreasing
+	// estimate (the estimates are permuted with it) and returns the predicted makespan
+	static double Schedule(std::vector<size_t>& selection, std::vector<double>& estimates, unsigned workers, size_t keep = 0)
 	{
-		Assert::StartsWith(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), NULL, throws, file, line);
+		std::vector<std::pair<double, size_t> > order;
+		for(size_t i = keep; i < selection.size(); ++i)
+		{
+			order.push_back(std::make_pair(estimates[i], selection[i]));
+		}
+		std::stable_sort(order.begin(), order.end(),
+						 [](const std::pair<double, size_t>& left, const std::pair<double, size_t>& right) { return left.first > right.first; });
+		for(size_t i = 0; i < order.size(); ++i)
+		{
+			estimates[keep + i] = order[i].first;
+			selection[keep + i] = order[i].second;
+		}
+		return Runner::Assign(estimates, workers, NULL);
 	}
-	static void StartsWith(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
+
+	// list scheduling - every case in turn goes to the worker which becomes free first;
+	// returns the makespan and, if 'owners' is given, the worker of each case
+	static double Assign(const std::vector<double>& estimates, unsigned workers, std::vector<unsigned>* owners)
 	{
-		Assert::StartsWith(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), message, throws, file, line);
+		std::vector<std::pair<double, unsigned> > loads;	// a min-heap of (busy until, worker)
+		for(unsigned i = 0; i < workers; ++i)
+		{
+			loads.push_back(std::make_pair(0.0, i));
+		}
+		std::greater<std::pair<double, unsigned> > later;
+		double makespan = 0;
+		for(size_t i = 0; i < estimates.size(); ++i)
+		{
+			std::pop_heap(loads.begin(), loads.end(), later);
+			loads.back().first += estimates[i];
+			makespan = std::max(makespan, loads.back().first);
+			if(owners)
+			{
+				owners->push_back(loads.back().second);
+			}
+			std::push_heap(loads.begin(), loads.end(), later);
+		}
+		return makespan;
 	}
-	static void StartsWith(LPTSTR expected, LPTSTR actual, bool throws, LPCSTR file, int line)
+
+	// runs the selected cases (indices into Registry::Cases()); threads=0 means hardware_concurrency.
+	// With estimates (one per selected case) each worker starts with the cases of the
+	// Assign schedule instead of a round robin share.
+	static void Run(const std::vector<size_t>& selection, unsigned threads, std::vector<Result>& results,
+					const std::vector<double>* estimates = NULL)
 	{
-		Assert::StartsWith(expected, actual, NULL, throws, file, line);
-	}
-	static void StartsWith(LPTSTR expected,LPTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
-	{	// check if the 'actual' buffer (=string) starts with the 'expected' buffer (=substring)
-		Assert::IsNotEmpty(expected, _T("StartsWith: expected substring is empty"), throws, file, line);
-		Assert::IsNotEmpty(actual,   _T("StartsWith: actual string is empty"),      throws, file, line);
-		Assert::LessOrEqual( _tcsclen(expected), _tcsclen(actual),
-									_T("StartsWith: expected substring is greater than the actual string"), throws, file, line);
-		LPCTSTR start = _tcsstr(actual, expected);
-		Assert::Test( ( _tcsstr(actual, expected) == actual), message,
-			/*[PASS]*/ _T("StartsWith: Expected substring was started at the actual string"),
-			/*[FAIL]*/ _T("StartsWith: Expected substring was not started at the actual string"),
-						expected, actual, throws, file, line);
-	}
+		const std::vector<TestCase>& cases = Registry::Cases();
+		results.resize(cases.size());
+		threads = Runner::Workers(threads, selection.size());
 
-	///////////////////////////////////////////////////////////////////////////
-	//[TODO] static void EndsWith(LPCTSTR expected,LPCTSTR actual, bool throws, LPCSTR file, int line);
- 	///////////////////////////////////////////////////////////////////////////
+		std::vector<WorkQueue> queues(threads);
+		std::vector<unsigned> owners;
+		if(estimates)
+		{
+			Runner::Assign(*estimates, threads, &owners);
+		}
+		for(size_t i = 0; i < selection.size(); ++i)
+		{	// the schedule or round robin - the stealing balances what the estimates got wrong
+			queues[estimates ? owners[i] : i % threads].items.push_back(selection[i]);
+		}
 
-	// AreEqualIgnoringCase for null terminated strings: (LPCTSTR)x2 and (LPTSTR)x2 - with and without a message
-	static void AreEqualIgnoringCase(LPCTSTR expected, LPCTSTR actual, bool throws, LPCSTR file, int line)
-	{
-		Assert::AreEqualIgnoringCase(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), NULL, throws, file, line);
-	}
-	static void AreEqualIgnoringCase(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
-	{
-		Assert::AreEqualIgnoringCase(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), message, throws, file, line);
-	}
-	static void AreEqualIgnoringCase(LPTSTR expected, LPTSTR actual, bool throws, LPCSTR file, int line)
-	{
-		Assert::AreEqualIgnoringCase(expected, actual, NULL, throws, file, line);
-	}
-	static void AreEqualIgnoringCase(LPTSTR expected,LPTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
-	{	// check if the 'actual' buffer is like the 'expected' buffer
-		Assert::IsNotEmpty(expected, _T("AreEqualIgnoringCase: expected substring is empty"), throws, file, line);
-		Assert::IsNotEmpty(actual,   _T("AreEqualIgnoringCase: actual string is empty"),      throws, file, line);
-		Assert::Test( (_tcsicmp(expected, actual) == 0), message,
-			/*[PASS]*/ _T("AreEqualIgnoringCase: Expression was equal"),
-			/*[FAIL]*/ _T("AreEqualIgnoringCase: Expression was not equal"),
-						expected, actual, throws, file, line);
+		Progress& completed = Runner::Completed();
+		completed.cases.store(0, std::memory_order_relaxed);
+		completed.failedCases.store(0, std::memory_order_relaxed);
+		completed.start = std::chrono::steady_clock::now();
+		Watchdog watchdog(threads, &Runner::Expired);
+		if(threads == 1)
+		{
+			Runner::Worker(queues, 0, results, watchdog);
+			return;
+		}
+		bool async = Reporter::IsAsync();
+		Reporter::SetAsync(true);	// the workers must not interleave their output
+		std::vector<std::thread> workers;
+		for(unsigned i = 0; i < threads; ++i)
+		{
+			workers.push_back(std::thread(&Runner::Worker, std::ref(queues), i, std::ref(results), std::ref(watchdog)));
+		}
+		for(size_t i = 0; i < workers.size(); ++i)
+		{
+			workers[i].join();
+		}
+		Reporter::SetAsync(async);
 	}
 
-	// IsMatch for null terminated strings: (LPCTSTR)x2 and (LPTSTR)x2 - with and without a message
-	static void IsMatch(LPCTSTR expected, LPCTSTR actual, bool throws, LPCSTR file, int line)
-	{
-		Assert::IsMatch(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), NULL, throws, file, line);
-	}
-	static void IsMatch(LPCTSTR expected, LPCTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
-	{
-		Assert::IsMatch(const_cast<LPTSTR>(expected), const_cast<LPTSTR>(actual), message, throws, file, line);
-	}
-	static void IsMatch(LPTSTR expected, LPTSTR actual, bool throws, LPCSTR file, int line)
+#if defined(__linux__)
+	// Runs the selected cases in forked worker processes (processes=0 means
+	// hardware_concurrency). The workers claim cases from a shared counter and
+	// write the results into an anonymous shared mapping, so a crash loses only
+	// the running case: the parent records it as failed and forks a replacement
+	// worker which continues with the remaining cases.
+	static void RunForked(const std::vector<size_t>& selection, unsigned processes, std::vector<Result>& results)
 	{
-		Assert::IsMatch(expected, actual, NULL, throws, file, line);
-	}
-	static void IsMatch(LPTSTR expected, LPTSTR actual, LPCTSTR message, bool throws, LPCSTR file, int line)
-	{	// check if the 'actual' buffer is like the 'expected' buffer
-		Assert::IsNotEmpty(expected, _T("IsMatch: expected substring is empty"), throws, file, line);
-		Assert::IsNotEmpty(actual,   _T("IsMatch: actual string is empty"),      throws, file, line);
-		Assert::Test( (_tcscmp(expected, actual) == 0), message,
-			/*[PASS]*/ _T("IsMatch: Expression was match"),
-			/*[FAIL]*/ _T("IsMatch: Expression was not match"),
-						expected, actual, throws, file, line);
-	}
+		const std::vector<TestCase>& cases = Registry::Cases();
+		results.resize(cases.size());
+		processes = Runner::Workers(processes, selection.size());
 
-	///////////////////////////////////////////////////////////////////////////
-	// CollectionAssert (NUnit 2.4 / 2.5) - The CollectionAssert class provides a number 
-	// of methods that are useful when examining collections and their contents or for
-	// comparing two collections
-	///////////////////////////////////////////////////////////////////////////
-	// [TODO] Not implemented - because its not relevant for C++
-	///////////////////////////////////////////////////////////////////////////
+		size_t size = sizeof(SharedRegion) + selection.size() * sizeof(SharedResult);
+		void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if(memory == MAP_FAILED)
+		{	// no shared memory - fall back to the in process runner
+			std::cerr << _T("mmap failed - running the cases in process") << std::endl;
+			Runner::Run(selection, 0, results);
+			return;
+		}
+		SharedRegion* region = new (memory) SharedRegion();	// zero filled by mmap
+		SharedResult* slots = reinterpret_cast<SharedResult*>(region + 1);
+		FILE* profile = SiteProfile::IsEnabled() ? tmpfile() : NULL;	// the workers append their site entries
+		region->profile = profile ? fileno(profile) : -1;
+		if(profile)
+		{
+			fcntl(region->profile, F_SETFL, O_APPEND);
+		}
 
-	///////////////////////////////////////////////////////////////////////////
-	// FileAssert (NUnit 2.4) -  The FileAssert class provides methods for comparing two files,
-	// which may be provided as Streams, as FileInfos or as strings giving the path to each file
-	///////////////////////////////////////////////////////////////////////////
-	// [TODO] Not implemented - because its not relevant for C++
-	///////////////////////////////////////////////////////////////////////////
+		Reporter::Flush();		// the children must not inherit posted records
+		std::cout.flush();
+		std::cerr.flush();
 
-	///////////////////////////////////////////////////////////////////////////
-	// DirectoryAssert (NUnit 2.5) - The DirectoryAssert class provides methods for making asserts
-	// about file system directories, which may be provided as DirectoryInfos or as strings giving
-	// the path to each directory.
-	///////////////////////////////////////////////////////////////////////////
-	// [TODO] Not implemented - because its not relevant for C++
-	///////////////////////////////////////////////////////////////////////////
+		size_t alive = 0;
+		for(unsigned i = 0; i < processes; ++i)
+		{
+			alive += Runner::ForkWorker(selection, region, slots) ? 1 : 0;
+		}
 
-private:
-	// private Utility Methods
-	template <class T1, class T2>
-	static void Fail(LPCTSTR message, const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
-	{
-		Assert::Fail(message, NULL, expected, actual, throws, file, line);
+		int status;
+		pid_t pid;
+		while(alive && (pid = waitpid(-1, &status, 0)) > 0)
+		{
+			--alive;
+			if(WIFEXITED(status) && WEXITSTATUS(status) == 0)
+			{
+				continue;
+			}
+			for(size_t i = 0; i < selection.size(); ++i)
+			{	// the case which was running in the crashed worker
+				SharedResult& slot = slots[i];
+				if(slot.state == SlotRunning && slot.pid == pid)
+				{
+					slot.state = SlotDone;
+					slot.aborted = 1;
+					slot.counters.failed += 1;
+					if(!slot.timedOut)
+					{	// a timed out worker wrote its own error
+						snprintf(slot.error, sizeof(slot.error),
+								 WIFSIGNALED(status) ? "worker crashed with signal %d" : "worker exited with status %d",
+								 WIFSIGNALED(status) ? WTERMSIG(status) : WEXITSTATUS(status));
+					}
+				}
+			}
+			if(region->next.load() < selection.size())
+			{	// restart a worker on the remaining cases
+				alive += Runner::ForkWorker(selection, region, slots) ? 1 : 0;
+			}
+		}
+
+		for(size_t i = 0; i < selection.size(); ++i)
+		{
+			const SharedResult& slot = slots[i];
+			Result& result = results[selection[i]];
+			if(slot.state != SlotDone)
+			{	// never claimed (fork failed)
+				result.aborted = true;
+				result.error = _T("not run");
+				result.counters.failed = 1;
+				Statistics::Add(result.counters);
+				Reporter::CaseEnd(cases[selection[i]], result);
+				continue;
+			}
+			result.counters = slot.counters;
+			result.metrics = slot.metrics;
+			result.aborted = slot.aborted != 0;
+			result.error = slot.error;
+			result.seconds = slot.seconds;
+			Runner::ImportInputs(slot, result.inputs);
+			Statistics::Add(result.counters);	// the children counted in their own address space
+			Reporter::CaseEnd(cases[selection[i]], result);	// the children report only to their console
+		}
+		if(profile)
+		{
+			SiteProfile::Import(fileno(profile));
+			fclose(profile);
+		}
+		munmap(memory, size);
 	}
+#endif
 
-	template <class T1, class T2>
-	static void Pass(LPCTSTR message, const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	// prints the failed cases and the totals, returns the process exit code
+	static int Summary(const std::vector<size_t>& selection, const std::vector<Result>& results, RunSummary& summary)
 	{
-		Assert::Pass(message, NULL, expected, actual, throws, file, line);
+		const std::vector<TestCase>& cases = Registry::Cases();
+		size_t failedCases = 0;
+		double seconds = 0;
+		Allocations::Counters allocations = { 0, 0, 0, 0 };
+		size_t leakingCases = 0;
+		double cpuTime = 0;
+		for(size_t i = 0; i < selection.size(); ++i)
+		{
+			const TestCase& test = cases[selection[i]];
+			const Result& result = results[selection[i]];
+			seconds += result.seconds;
+			cpuTime += result.metrics.resources.userTime + result.metrics.resources.systemTime;
+			allocations.calls += result.metrics.allocations.calls;
+			allocations.bytes += result.metrics.allocations.bytes;
+			if(result.metrics.allocations.current > 0)
+			{
+				allocations.current += result.metrics.allocations.current;
+				++leakingCases;
+			}
+			if(!Statistics::IsQuiet())
+			{
+				Runner::PrintCase(test, result);
+			}
+			if(result.metrics.allocations.current > 0)
+			{
+				std::cerr << _T("[LEAK] ") << test.suite << _T(".") << test.name << _T(": ")
+						  << result.metrics.allocations.current << _T(" bytes were not freed") << std::endl;
+			}
+			if(result.counters.failed == 0 && !result.aborted)
+			{
+				continue;
+			}
+			++failedCases;
+			std::cerr << _T("[FAIL] ") << test.suite << _T(".") << test.name
+					  << _T(" (") << result.counters.failed << _T(" failed)");
+			if(result.aborted)
+			{
+				std::cerr << _T(": ") << result.error;
+			}
+			std::cerr << std::endl << _T("at ") << test.file << _T(" (") << test.line << _T(")") << std::endl;
+		}
+		std::cout << _T("Test cases: ") << selection.size() - failedCases << _T(" passed, ")
+				  << failedCases << _T(" failed") << std::endl
+				  << _T("Assertions: ") << Statistics::Passed() << _T(" passed, ")
+				  << Statistics::Failed() << _T(" failed") << std::endl
+				  << _T("Time in cases: ") << seconds << _T(" s") << std::endl
+				  << _T("CPU time in cases: ") << cpuTime / 1e3 << _T(" s, peak RSS ")
+				  << Resources::PeakRss() / (1024.0 * 1024.0) << _T(" MB") << std::endl;
+		if(Allocations::IsTracking())
+		{
+			std::cout << _T("Allocations: ") << allocations.calls << _T(" calls, ") << allocations.bytes
+					  << _T(" bytes, ") << allocations.current << _T(" bytes leaked in ") << leakingCases
+					  << _T(" cases") << std::endl;
+		}
+		summary.cases = selection.size();
+		summary.failedCases = failedCases;
+		summary.passed = Statistics::Passed();
+		summary.failed = Statistics::Failed();
+		summary.seconds = seconds;
+		return failedCases ? 1 : 0;
 	}
 
-	static void Test(bool condition, LPCTSTR message_pass, LPCTSTR message_fail,
-					 bool throws, LPCSTR file, int line)
+	// one summary line per case with its metrics
+	static void PrintCase(const TestCase& test, const Result& result)
 	{
-		Assert::Test(condition, NULL, message_pass, message_fail, throws, file, line);
+		std::cout << _T("[CASE] ") << test.suite << _T(".") << test.name << _T(": ")
+				  << Benchmark::Time(result.seconds * 1e9) << _T(", ")
+				  << ReportWriter::FormatMetrics(result.metrics) << std::endl;
 	}
 
-	template <class T1, class T2>
-	static void Test(bool condition, LPCTSTR message_pass, LPCTSTR message_fail,
-					 const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+private:
+#if defined(__linux__)
+	enum { SlotPending = 0, SlotRunning = 1, SlotDone = 2 };
+
+	struct SharedRegion
 	{
-		Assert::Test(condition, NULL, message_pass, message_fail, expected, actual, throws, file, line);
-	}
+		std::atomic<size_t>	next;		// next position in the selection to claim
+		int					profile;	// the file of SiteProfile::Export, -1 = not profiling
+	};
 
-	static void Test(bool condition, LPCTSTR message, LPCTSTR message_pass, LPCTSTR message_fail,
-					 bool throws, LPCSTR file, int line)
+	struct SharedResult
 	{
-		if(message)
-		{
-			(condition) ?
-				Assert::Pass(message, message_pass, throws, file, line) :
-				Assert::Fail(message, message_fail, throws, file, line);
-		}
-		else
-		{
-			(condition) ?
-				Assert::Pass(message_pass, throws, file, line) :
-				Assert::Fail(message_fail, throws, file, line);
-		}
-	}
+		volatile int			state;
+		volatile pid_t			pid;
+		Statistics::Counters	counters;
+		Metrics					metrics;
+		int						aborted;
+		double					seconds;
+		char					error[256];
+		char					inputs[1024];	// the TEST_INPUT paths, each NUL terminated, then an empty one
+		int						lostInputs;		// the paths did not fit
+		int						timedOut;		// the watchdog of the worker wrote 'counters' and 'error'
+	};
 
-	template <class T1, class T2>
-	static void Test(bool condition, LPCTSTR message, LPCTSTR message_pass, LPCTSTR message_fail,
-					 const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	static bool ForkWorker(const std::vector<size_t>& selection, SharedRegion* region, SharedResult* slots)
 	{
-		if(message)
+		pid_t pid = fork();
+		if(pid < 0)
 		{
-			(condition) ?
-				Assert::Pass(message, message_pass, expected, actual, throws, file, line) :
-				Assert::Fail(message, message_fail, expected, actual, throws, file, line);
+			return false;
 		}
-		else
+		if(pid > 0)
 		{
-			(condition) ?
-				Assert::Pass(message_pass, expected, actual, throws, file, line) :
-				Assert::Fail(message_fail, expected, actual, throws, file, line);
+			return true;
 		}
+		// worker process - only the forking thread exists here, so report synchronously
+		Reporter::SetAsync(false);
+		Reporter::ConsoleOnly();
+		PerfCounters::ResetThread();
+		SiteProfile::Reset();	// the parent merges the entries of its workers
+		Runner::RunClaimed(selection, region, slots);
+		std::cout.flush();
+		std::cerr.flush();
+		_exit(0);	// skip the static destructors inherited from the parent
 	}
 
-	static void FormatMessage(std::ostringstream& ostr, LPCTSTR message1, LPCTSTR message2, LPCSTR file, int line, bool newline)
+	// the loop of a forked worker: claims the next case until none is left
+	static void RunClaimed(const std::vector<size_t>& selection, SharedRegion* region, SharedResult* slots)
 	{
-		if(newline)
+		const std::vector<TestCase>& cases = Registry::Cases();
+		Watchdog watchdog(1, &Runner::ExpiredWorker);
+		size_t position;
+		while((position = region->next.fetch_add(1)) < selection.size())
 		{
-			ostr << message1 << std::endl;
-			if(message2)
+			SharedResult& slot = slots[position];
+			slot.pid = getpid();
+			__sync_synchronize();
+			slot.state = SlotRunning;
+
+			Result result;
+			watchdog.Bind(0, &slot);
+			Runner::RunCase(cases[selection[position]], result);
+
+			slot.counters = result.counters;
+			slot.metrics = result.metrics;
+			slot.aborted = result.aborted ? 1 : 0;
+			slot.seconds = result.seconds;
+			strncpy(slot.error, result.error.c_str(), sizeof(slot.error) - 1);
+			Runner::ExportInputs(result.inputs, slot);
+			if(region->profile >= 0)
 			{
-				ostr << message2 << std::endl;
+				SiteProfile::Export(region->profile);
 			}
-			ostr << _T("at ") << file << _T(" (") << line << _T(")");
+			__sync_synchronize();
+			slot.state = SlotDone;
 		}
-		else
+	}
+
+	// the watchdog handler of a forked worker: the result goes to the slot, and the exit
+	// makes the parent record the case and fork a replacement worker
+	static void ExpiredWorker(Watchdog& /*watchdog*/, Watchdog::Watch& expired, double elapsed)
+	{
+		SharedResult& slot = *static_cast<SharedResult*>(expired.context);
+		const std::string text = Watchdog::Expiry(expired, elapsed);
+		slot.counters = *expired.counters;	// relaxed loads: the assertions until the last one (may miss a racing increment)
+		slot.seconds = elapsed;
+		strncpy(slot.error, text.c_str(), sizeof(slot.error) - 1);
+		slot.timedOut = 1;
+		const std::string line = std::string(_T("[TIMEOUT] ")) + expired.test->suite + _T(".") + expired.test->name
+							   + _T(": ") + text + _T("\n");
+		Console::Write(Console::Error, line.data(), line.size());
+		__sync_synchronize();
+		_exit(Watchdog::ExitCode);
+	}
+
+	// the inputs cross the process boundary as consecutive NUL terminated paths
+	static void ExportInputs(const std::vector<std::string>& inputs, SharedResult& slot)
+	{
+		size_t used = 0;
+		slot.lostInputs = 0;
+		for(size_t i = 0; i < inputs.size() && !slot.lostInputs; ++i)
 		{
-			ostr << message1 << _T(" ");
-			if(message2)
+			if(inputs[i].size() + 2 > sizeof(slot.inputs) - used)
 			{
-				ostr << message2 << _T(" ");
+				slot.lostInputs = 1;
+				break;
 			}
-			ostr << _T("at ") << file << _T(" (") << line << _T(")");
+			memcpy(slot.inputs + used, inputs[i].c_str(), inputs[i].size() + 1);
+			used += inputs[i].size() + 1;
 		}
+		slot.inputs[used] = '\0';
 	}
-
-	template <class T1, class T2>
-	static void FormatMessage(std::ostringstream& ostr, LPCTSTR message1, LPCTSTR message2, const T1& expected, const T2& actual, LPCSTR file, int line)
+	static void ImportInputs(const SharedResult& slot, std::vector<std::string>& inputs)
 	{
-		ostr << message1 << std::endl;
-		if(message2)
+		inputs.clear();
+		for(size_t used = 0; used < sizeof(slot.inputs) && slot.inputs[used]; )
 		{
-			ostr << message2 << std::endl;
+			const size_t length = strnlen(slot.inputs + used, sizeof(slot.inputs) - used);
+			inputs.push_back(std::string(slot.inputs + used, length));
+			used += length + 1;
+		}
+		if(slot.lostInputs)
+		{	// an empty path never hashes, so the case is always run again
+			inputs.push_back(std::string());
 		}
-		ostr << _T("Expected: '") << expected << _T("'") << std::endl
-			 << _T("Actual:   '") << actual   << _T("'") << std::endl 
-			 << _T("at ") << file << _T(" (") << line << _T(")"); // this generates warning C4267 for size_t
 	}
+#endif
 
-	static void FormatMessage(std::ostringstream& ostr, LPCTSTR message1, LPCTSTR message2, const ULONGLONG& expected, const ULONGLONG& actual, LPCSTR file, int line)
-	{	// convert ULONGLONG to __int64 (used in DECIMAL values)
-		FormatMessage(ostr, message1, message2, static_cast<const __int64&>(expected), static_cast<const __int64&>(actual), file, line);
-	}
+	struct WorkQueue
+	{
+		std::mutex			lock;
+		std::deque<size_t>	items;
+	};
 
-	static void FormatMessage(std::ostringstream& ostr, LPCTSTR message1, LPCTSTR message2, const __int64& expected, const __int64& actual, LPCSTR file, int line)
-	{	// convert __int64 to string
-		ostr << message1 << std::endl;
-		if(message2)
+	static bool Pop(WorkQueue& queue, size_t& index)
+	{
+		std::lock_guard<std::mutex> guard(queue.lock);
+		if(queue.items.empty())
 		{
-			ostr << message2 << std::endl;
+			return false;
 		}
-		TCHAR szExpected[256];
-		TCHAR szActual[256];
-		_stprintf_s(szExpected, sizeof(szExpected), _T("%I64d"), expected);
-		_stprintf_s(szActual, sizeof(szActual), _T("%I64d"), actual);
-		ostr << _T("Expected: '") << szExpected << _T("'") << std::endl
-			 << _T("Actual:   '") << szActual   << _T("'") << std::endl 
-			 << _T("at ") << file << _T(" (") << line << _T(")"); // this generates warning C4267 for size_t
+		index = queue.items.front();
+		queue.items.pop_front();
+		return true;
 	}
 
-	static void Fail(LPCTSTR message1, LPCTSTR message2, bool throws, LPCSTR file, int line)
+	static bool Steal(WorkQueue& queue, size_t& index)
 	{
-		std::ostringstream ostr;
-		FormatMessage(ostr, message1, message2, file, line, true);	// new line is needed in fail method 
-		if(throws)
-		{
-			throw std::runtime_error(ostr.str());
-		}
-		else
+		std::lock_guard<std::mutex> guard(queue.lock);
+		if(queue.items.empty())
 		{
-			SET_CONSOLE_COLOR(0x0C);	// RED
-			std::cerr << _T("[FAIL]") << ostr.str() << std::endl;
-			SET_CONSOLE_COLOR(0x0F);	// WHITE
+			return false;
 		}
+		index = queue.items.back();
+		queue.items.pop_back();
+		return true;
 	}
 
-	static void Pass(LPCTSTR message1, LPCTSTR message2, bool throws, LPCSTR file, int line)
+	static void Worker(std::vector<WorkQueue>& queues, unsigned self, std::vector<Result>& results, Watchdog& watchdog)
 	{
-		if(throws)
-		{	// do not print pass messages in case of assertion mode
-			return;
+		const std::vector<TestCase>& cases = Registry::Cases();
+		watchdog.Bind(self);
+		size_t index;
+		for(;;)
+		{
+			bool found = Runner::Pop(queues[self], index);
+			for(size_t i = 1; !found && i < queues.size(); ++i)
+			{	// no work is ever added after the start, so empty queues everywhere means done
+				found = Runner::Steal(queues[(self + i) % queues.size()], index);
+			}
+			if(!found)
+			{
+				break;
+			}
+			Runner::RunCase(cases[index], results[index]);
+			const Result& result = results[index];
+			Progress& completed = Runner::Completed();
+			completed.cases.fetch_add(1, std::memory_order_relaxed);
+			if(result.counters.failed.load(std::memory_order_relaxed) || result.aborted)
+			{
+				completed.failedCases.fetch_add(1, std::memory_order_relaxed);
+			}
 		}
-		SET_CONSOLE_COLOR(0x0A);	// GREEN
-		std::cout << _T("[PASS] ");
-		SET_CONSOLE_COLOR(0x0F);	// WHITE
+		Watchdog::Unbind();
+	}
 
-		std::ostringstream ostr;
-		FormatMessage(ostr, message1, message2, file, line, false);	// new line is not needed in pass method 
-		std::cout << ostr.str() << std::endl;
+	// the cases completed by the in process run - the summary of a run which Expired ends
+	struct Progress
+	{
+		std::atomic<size_t>						cases;
+		std::atomic<size_t>						failedCases;
+		std::chrono::steady_clock::time_point	start;
+	};
+	static Progress& Completed()
+	{
+		static Progress progress;
+		return progress;
 	}
 
-	template <class T1, class T2>
-	static void Fail(LPCTSTR message1, LPCTSTR message2, const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	// the watchdog handler of an in process run: the case cannot be stopped, so the
+	// state of the run is printed, every running case is recorded as failed, the report
+	// files are closed and the process exits
+	static void Expired(Watchdog& watchdog, Watchdog::Watch& expired, double elapsed)
 	{
-		std::ostringstream ostr;
-		FormatMessage(ostr, message1, message2, expected, actual, file, line); 
-		if(throws)
+		const std::string expiry = Watchdog::Expiry(expired, elapsed);
+		std::string text = std::string(_T("[TIMEOUT] ")) + expired.test->suite + _T(".") + expired.test->name + _T(": ")
+						 + expiry + _T("\n");
+		std::deque<Result> running(1);	// the results of the CaseEnd records stay valid until _exit
+		std::vector<const TestCase*> tests(1, expired.test);
+		running[0].counters = *expired.counters;
+		running[0].error = expiry;
+		running[0].seconds = elapsed;
+		std::vector<Watchdog::Watch>& watches = watchdog.Watches();
+		for(size_t i = 0; i < watches.size(); ++i)
 		{
-			throw std::runtime_error(ostr.str());
+			Watchdog::Watch& watch = watches[i];
+			if(&watch == &expired)
+			{
+				continue;
+			}
+			std::lock_guard<std::mutex> guard(watch.lock);
+			if(watch.test)
+			{
+				const double seconds = std::chrono::duration<double>(Watchdog::Clock::now() - watch.start).count();
+				const std::string site = Watchdog::LastSite(watch);
+				char running_for[32];
+				snprintf(running_for, sizeof(running_for), "%.2f s", seconds);
+				text += std::string(_T("[RUNNING] ")) + watch.test->suite + _T(".") + watch.test->name + _T(": ")
+					  + running_for + _T(", ") + site + _T("\n");
+				running.push_back(Result());
+				tests.push_back(watch.test);
+				running.back().counters = *watch.counters;
+				running.back().error = std::string(_T("run aborted after ")) + running_for + _T(" by the timeout of ")
+									 + expired.test->suite + _T(".") + expired.test->name + _T(", ") + site;
+				running.back().seconds = seconds;
+			}
 		}
-		else
+		char totals[128];
+		snprintf(totals, sizeof(totals), "Run aborted: %lu assertions passed, %lu failed in the completed cases\n",
+				 Statistics::Passed(), Statistics::Failed());
+		text += totals;
+		Console::Write(Console::Error, text.data(), text.size());	// the hung case may hold any lock
+
+		// a case which hangs while it writes a record holds the reporter lock - the report
+		// files are then left as they are rather than waiting for it forever
+		if(Reporter::Available(1000))
 		{
-			SET_CONSOLE_COLOR(0x0C);	// RED
-			std::cerr << ostr.str() << std::endl;
-			SET_CONSOLE_COLOR(0x0F);	// WHITE
+			const Progress& completed = Runner::Completed();
+			RunSummary summary;
+			summary.cases = completed.cases.load(std::memory_order_relaxed) + running.size();
+			summary.failedCases = completed.failedCases.load(std::memory_order_relaxed) + running.size();
+			summary.passed = Statistics::Passed();
+			summary.failed = Statistics::Failed();
+			summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - completed.start).count();
+			for(size_t i = 0; i < running.size(); ++i)
+			{	// recorded as a case ended by an exception
+				Result& result = running[i];
+				result.aborted = true;
+				result.counters.failed.store(result.counters.failed.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+				summary.passed += result.counters.passed.load(std::memory_order_relaxed);
+				summary.failed += result.counters.failed.load(std::memory_order_relaxed);
+				Reporter::CaseEnd(*tests[i], result);
+			}
+			Reporter::Abort(summary);
 		}
+		_exit(Watchdog::ExitCode);
 	}
 
-	template <class T1, class T2>
-	static void Pass(LPCTSTR message1, LPCTSTR message2, const T1& expected, const T2& actual, bool throws, LPCSTR file, int line)
+	static void RunCase(const TestCase& test, Result& result)
 	{
-		if(throws)
-		{	// do not print pass messages in case of assertion mode
-			return;
+		result.aborted = false;
+		result.inputs.clear();
+		Reporter::SetCase(&test);
+		ResultCache::Current() = &result.inputs;
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		Statistics::Begin(&result.counters);
+		Watchdog::Begin(test, &result.counters, start);
+		Allocations::Counters allocations = Allocations::Begin();
+		Resources::Usage resources = Resources::Sample();
+		PerfCounters::Counters counters = PerfCounters::Sample();
+		try
+		{
+			test.function();
 		}
-		SET_CONSOLE_COLOR(0x0A);	// GREEN
-		std::cout << _T("[PASS] ");
-		SET_CONSOLE_COLOR(0x0F);	// WHITE
-
-		std::ostringstream ostr;
-		FormatMessage(ostr, message1, message2, file, line, false); 	// new line is not needed in pass method
-		std::cout << ostr.str() << std::endl;
+		catch(const std::runtime_error& e)
+		{	// ASSERT_XXX failure - already counted by Assert::Fail
+			Allocations::Ignore ignore;
+			result.aborted = true;
+			result.error = e.what();
+		}
+		catch(const std::exception& e)
+		{
+			Allocations::Ignore ignore;
+			result.aborted = true;
+			result.error = std::string(_T("unexpected exception: ")) + e.what();
+			++result.counters.failed;
+		}
+		catch(...)
+		{
+			Allocations::Ignore ignore;
+			result.aborted = true;
+			result.error = _T("unexpected exception");
+			++result.counters.failed;
+		}
+		result.metrics.allocations = Allocations::Since(allocations);
+		result.metrics.counters = PerfCounters::Since(counters);
+		result.metrics.resources = Resources::Since(resources);
+		Watchdog::End();
+		Statistics::End(&result.counters);
+		result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		ResultCache::Current() = NULL;
+		Reporter::SetCase(NULL);
+		Reporter::CaseEnd(test, result);
 	}
-
-};	// Assert
+};	// Runner
 
 };	// UnitTest
 
 ///////////////////////////////////////////////////////////////////////////////
-#undef SET_CONSOLE_COLOR
+// Counting operator new/delete - defined only in the source file which defines
+// UNITTEST_TRACK_ALLOCATIONS (replacement operators must be defined exactly once)
+///////////////////////////////////////////////////////////////////////////////
+#ifdef UNITTEST_TRACK_ALLOCATIONS
+static const bool UnitTest_AllocationTracking = UnitTest::Allocations::Enable();
+
+void* operator new(size_t size)
+{
+	void* pointer = UnitTest::Allocations::Allocate(size);
+	if(!pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return UnitTest::Allocations::Allocate(size);
+}
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return UnitTest::Allocations::Allocate(size);
+}
+void operator delete(void* pointer) noexcept
+{
+	UnitTest::Allocations::Free(pointer);
+}
+void operator delete[](void* pointer) noexcept
+{
+	UnitTest::Allocations::Free(pointer);
+}
+void operator delete(void* pointer, size_t) noexcept
+{
+	UnitTest::Allocations::Free(pointer);
+}
+void operator delete[](void* pointer, size_t) noexcept
+{
+	UnitTest::Allocations::Free(pointer);
+}
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	UnitTest::Allocations::Free(pointer);
+}
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	UnitTest::Allocations::Free(pointer);
+}
+
+// over-aligned types (alignas above __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	void* pointer = UnitTest::Allocations::Allocate(size, static_cast<size_t>(alignment));
+	if(!pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return UnitTest::Allocations::Allocate(size, static_cast<size_t>(alignment));
+}
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return UnitTest::Allocations::Allocate(size, static_cast<size_t>(alignment));
+}
+void operator delete(void* pointer, std::align_val_t alignment) noexcept
+{
+	UnitTest::Allocations::Free(pointer, static_cast<size_t>(alignment));
+}
+void operator delete[](void* pointer, std::align_val_t alignment) noexcept
+{
+	UnitTest::Allocations::Free(pointer, static_cast<size_t>(alignment));
+}
+void operator delete(void* pointer, size_t, std::align_val_t alignment) noexcept
+{
+	UnitTest::Allocations::Free(pointer, static_cast<size_t>(alignment));
+}
+void operator delete[](void* pointer, size_t, std::align_val_t alignment) noexcept
+{
+	UnitTest::Allocations::Free(pointer, static_cast<size_t>(alignment));
+}
+void operator delete(void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	UnitTest::Allocations::Free(pointer, static_cast<size_t>(alignment));
+}
+void operator delete[](void* pointer, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	UnitTest::Allocations::Free(pointer, static_cast<size_t>(alignment));
+}
+#endif
@@ -0,0 +1,102 @@
+#!/bin/sh
+###############################################################################
+# compile_cost.sh - compile time and code size of a 10k-assertion source file,
+# written with TEST_EQUAL(a, b, msg) and with CHECK(a == b)
+# Usage: bench/compile_cost.sh			(CXX, CXXFLAGS and REPEAT override the defaults)
+#
+# Two generated sources, 10000 assertions in 100 TEST_CASEs each, the operands
+# returned by a function the compiler cannot see through:
+#	builtin - 50 pairs of builtin types (int == long, double == char, ...)
+#	types   - 1000 distinct structs with their own operator== and operator<<
+# Each source is compiled with -c at -O0 and -O2; the time is the best of REPEAT
+# runs and the size is .text + .rodata of the object file.
+###############################################################################
+set -e
+cd "$(dirname "$0")"
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--std=c++17}
+REPEAT=${REPEAT:-3}
+OUT=${TMPDIR:-/tmp}/unittest-bench
+mkdir -p "$OUT"
+
+# generate SHAPE MACRO > file.cpp - SHAPE is builtin or types, MACRO is TEST_EQUAL or CHECK
+generate()
+{
+	awk -v shape="$1" -v macro="$2" 'BEGIN {
+		split("int|long|long long|unsigned|unsigned long|short|unsigned short|char|double|float", builtin, "|")
+		print "#include \"UnitTest.hpp\""
+		print "template <class T> T Opaque(int id);	// declared only - the object file is not linked"
+		if(shape == "types")
+		{
+			for(t = 0; t < 1000; ++t)
+			{
+				printf "struct T%d { int v; };\n", t
+				printf "inline bool operator==(const T%d& a, const T%d& b) { return a.v == b.v; }\n", t, t
+				printf "inline std::ostream& operator<<(std::ostream& o, const T%d& t) { return o << t.v; }\n", t
+			}
+		}
+		for(c = 0; c < 100; ++c)
+		{
+			printf "TEST_CASE(Generated, Case%d)\n{\n", c
+			for(i = 0; i < 100; ++i)
+			{
+				n = c * 100 + i
+				if(shape == "types")
+				{
+					left = "T" (n % 1000); right = left
+				}
+				else
+				{	# 50 distinct (left, right) pairs: the right type is offset by 0..4 from the left one
+					k = n % 50
+					left = builtin[k % 10 + 1]; right = builtin[(k % 10 + int(k / 10)) % 10 + 1]
+				}
+				a = "Opaque<" left ">(" n ")"
+				b = "Opaque<" right ">(" n + 1 ")"
+				if(macro == "CHECK")
+					printf "\tCHECK(%s == %s);\n", a, b
+				else
+					printf "\tTEST_EQUAL(%s, %s, \"%d\");\n", a, b, n
+			}
+			print "}"
+		}
+	}'
+}
+
+# seconds SOURCE FLAGS - the best compile time of REPEAT runs, leaves the object in $OUT/object.o
+seconds()
+{
+	best=""
+	run=0
+	while [ $run -lt "$REPEAT" ]; do
+		start=$(date +%s.%N)
+		$CXX $CXXFLAGS $2 -I.. -c "$1" -o "$OUT/object.o"
+		end=$(date +%s.%N)
+		best=$(echo "$start $end $best" | awk '{ t = $2 - $1; if($3 != "" && $3 < t) t = $3; printf "%.2f", t }')
+		run=$((run + 1))
+	done
+	echo "$best"
+}
+
+# bytes - .text and .rodata sections (with their suffixes) of $OUT/object.o
+bytes()
+{
+	size -A "$OUT/object.o" | awk '$1 ~ /^\.(text|rodata)/ { total += $2 } END { print total }'
+}
+
+printf '%-8s %-4s %22s %22s\n' "shape" "opt" "TEST_EQUAL s / bytes" "CHECK s / bytes"
+for shape in builtin types; do
+	generate $shape TEST_EQUAL > "$OUT/$shape-test_equal.cpp"
+	generate $shape CHECK > "$OUT/$shape-check.cpp"
+	for opt in -O0 -O2; do
+		old=$(seconds "$OUT/$shape-test_equal.cpp" $opt)
+		oldBytes=$(bytes)
+		new=$(seconds "$OUT/$shape-check.cpp" $opt)
+		newBytes=$(bytes)
+		printf '%-8s %-4s %10s %11s %10s %11s\n' $shape $opt "$old" "$oldBytes" "$new" "$newBytes"
+	done
+done
+
+# the header alone, for reference
+echo '#include "UnitTest.hpp"' > "$OUT/header.cpp"
+printf '%-8s %-4s %10s\n' header -O0 "$(seconds "$OUT/header.cpp" -O0)"
+printf '%-8s %-4s %10s\n' header -O2 "$(seconds "$OUT/header.cpp" -O2)"
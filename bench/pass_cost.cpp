@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////////////
+// pass_cost.cpp - the cost of one passing assertion, verbose and quiet
+///////////////////////////////////////////////////////////////////////////////
+// Build and run from this directory (see run.sh):
+//	g++ -std=c++17 -O2 -I.. pass_cost.cpp -o pass_cost -pthread
+//	./pass_cost 2000000 > /dev/null				// every pass formatted and printed
+//	./pass_cost 2000000 --quiet > /dev/null		// passes only bump the counter
+//
+// The verbose run is the only mode there was before quiet mode: every passing
+// assertion is formatted and written (the console has since moved to one
+// write per batch, so it is cheaper now than it was then). The quiet run is
+// the same loop with Statistics::SetQuiet(true). The time per assertion is
+// printed on stderr, so stdout can go to /dev/null, a pipe or a file.
+///////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+UNITTEST_NOINLINE static int One()
+{	// the compiler cannot fold the comparison into a constant
+	return 1;
+}
+
+int main(int argc, char* argv[])
+{
+	long count = argc > 1 ? atol(argv[1]) : 2000000;
+	bool quiet = argc > 2 && strcmp(argv[2], "--quiet") == 0;
+	UnitTest::Statistics::SetQuiet(quiet);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(long i = 0; i < count; ++i)
+	{
+		TEST_EQUAL(One(), 1, "loop");
+	}
+	UnitTest::Reporter::Flush();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	fprintf(stderr, "%s: %ld passing assertions, %.1f ns per assertion (%lu counted)\n",
+			quiet ? "quiet" : "verbose", count, seconds * 1e9 / count, UnitTest::Statistics::Passed());
+	return UnitTest::Statistics::Passed() == static_cast<unsigned long>(count) ? 0 : 1;
+}
@@ -0,0 +1,36 @@
+///////////////////////////////////////////////////////////////////////////////
+// records_per_second.cpp - console records per second, sync and async
+///////////////////////////////////////////////////////////////////////////////
+// Build and run from this directory (see run.sh):
+//	g++ -std=c++17 -O2 -I.. records_per_second.cpp -o records_per_second -pthread
+//	./records_per_second 1000000 sync | cat > /dev/null	// to a pipe
+//	./records_per_second 1000000 async > records.txt		// to a file
+//
+// Every passing TEST_IS_TRUE is one [PASS] record written by the ConsoleWriter
+// to stdout. The rate is printed on stderr once the last record was written.
+///////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+int main(int argc, char* argv[])
+{
+	long count = argc > 1 ? atol(argv[1]) : 1000000;
+	bool async = argc > 2 && strcmp(argv[2], "async") == 0;
+	UnitTest::Reporter::SetAsync(async);
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	for(long i = 0; i < count; ++i)
+	{
+		TEST_IS_TRUE(i >= 0, "record");
+	}
+	UnitTest::Reporter::Flush();
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	fprintf(stderr, "%s: %ld records in %.3f s, %.2f M records/s\n",
+			async ? "async" : "sync", count, seconds, count / seconds / 1e6);
+	return 0;
+}
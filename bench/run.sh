@@ -0,0 +1,26 @@
+#!/bin/sh
+###############################################################################
+# run.sh - builds and runs the runtime benchmarks of UnitTest.hpp
+# Usage: bench/run.sh [COUNT]	(CXX and CXXFLAGS override the compiler and flags)
+# The times are printed on stderr; stdout of the benchmarks is discarded.
+###############################################################################
+set -e
+cd "$(dirname "$0")"
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--std=c++17 -O2}
+COUNT=${1:-2000000}
+OUT=${TMPDIR:-/tmp}/unittest-bench
+mkdir -p "$OUT"
+
+# pass_cost - ns per passing TEST_EQUAL, verbose and quiet
+$CXX $CXXFLAGS -I.. pass_cost.cpp -o "$OUT/pass_cost" -pthread
+"$OUT/pass_cost" "$COUNT" > /dev/null
+"$OUT/pass_cost" "$COUNT" --quiet > /dev/null
+
+# records_per_second - [PASS] records/s of the console writer to a pipe and to a file
+$CXX $CXXFLAGS -I.. records_per_second.cpp -o "$OUT/records_per_second" -pthread
+for mode in sync async; do
+	printf 'pipe, '; "$OUT/records_per_second" "$COUNT" $mode | cat > /dev/null
+	printf 'file, '; "$OUT/records_per_second" "$COUNT" $mode > "$OUT/records.txt"
+done
+rm -f "$OUT/records.txt"
@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+// cache.cpp - the cases which --cache, --changed-only and --only-failed select
+///////////////////////////////////////////////////////////////////////////////
+// Built and run by run.sh from a copy in its output directory, so the source
+// file a case depends on can be edited without a rebuild:
+//	g++ -std=c++17 -O2 -I.. cache.cpp -o cache -pthread
+//	CACHE_DATA=data ./cache --cache data/cache --changed-only
+//
+// Every case reads its inputs from the directory in CACHE_DATA:
+//	Cache.Plain		- depends only on its source file
+//	Cache.Input		- input.txt
+//	Cache.Flaky		- flaky.txt, fails while it holds "fail"
+//	Cache.Overflow	- 24 files an-input-with-a-rather-long-name-NNN.txt, whose
+//					  paths do not fit in the 1024 bytes a --fork child returns
+///////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+static std::string Data(const std::string& name)
+{
+	const char* directory = getenv("CACHE_DATA");
+	return std::string(directory ? directory : ".") + "/" + name;
+}
+
+static std::string Contents(const std::string& path)
+{
+	std::ifstream file(path.c_str());
+	std::ostringstream contents;
+	contents << file.rdbuf();
+	return contents.str();
+}
+
+TEST_CASE(Cache, Plain)
+{
+	TEST_PASS("no input");
+}
+
+TEST_CASE(Cache, Input)
+{
+	const std::string path = Data("input.txt");
+	TEST_INPUT(path);
+	TEST_IS_TRUE(!Contents(path).empty(), "input.txt is readable");
+}
+
+TEST_CASE(Cache, Flaky)
+{
+	const std::string path = Data("flaky.txt");
+	TEST_INPUT(path);
+	TEST_IS_TRUE(Contents(path).compare(0, 4, "fail") != 0, "flaky.txt does not say fail");
+}
+
+TEST_CASE(Cache, Overflow)
+{
+	for(int i = 0; i < 24; ++i)
+	{
+		const std::string path = Data("an-input-with-a-rather-long-name-" + std::to_string(100 + i) + ".txt");
+		TEST_INPUT(path);
+		TEST_IS_TRUE(!Contents(path).empty(), "the input is readable");
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	return UnitTest::Runner::Main(argc, argv);
+}
@@ -0,0 +1,117 @@
+#!/bin/sh
+###############################################################################
+# run.sh - builds and runs the regression tests of the UnitTest.hpp runner
+# Usage: tests/run.sh		(CXX and CXXFLAGS override the compiler and flags)
+# Prints one line per failed check and exits with 1 if any check failed.
+###############################################################################
+set -e
+cd "$(dirname "$0")"
+CXX=${CXX:-g++}
+CXXFLAGS=${CXXFLAGS:--std=c++17 -O2 -Wall -Wextra}
+OUT=${TMPDIR:-/tmp}/unittest-tests
+mkdir -p "$OUT"
+failed=0
+
+# expect NAME STATUS PATTERN OUTPUT-FILE - the last command exited with STATUS
+# and its output has a line which matches the grep pattern (no pattern - any output)
+expect()
+{
+	if [ "$status" != "$2" ]; then
+		echo "FAILED: $1: exit status $status, expected $2"
+		failed=1
+	elif [ -n "$3" ] && ! grep -q -- "$3" "$4"; then
+		echo "FAILED: $1: no line matches '$3'"
+		sed 's/^/	/' "$4"
+		failed=1
+	fi
+}
+
+# ran NAME STATUS CASES - the last cache run exited with STATUS and ran CASES, in order
+ran()
+{
+	cases=$(sed -n 's/^\[CASE\] Cache\.\([A-Za-z]*\):.*/\1/p' "$OUT/out.txt" | paste -s -d, -)
+	if [ "$status" != "$2" ] || [ "$cases" != "$3" ]; then
+		echo "FAILED: $1: exit status $status and cases '$cases', expected $2 and '$3'"
+		failed=1
+	fi
+}
+
+# cache ARGS - runs the cache cases with --cache $CACHE_DATA/cache
+cache()
+{
+	status=0; "$OUT/cache" --cache "$CACHE_DATA/cache" "$@" > "$OUT/out.txt" 2>&1 || status=$?
+}
+
+# selection - --filter globs and --tags expressions, through CaseIndex and through Runner::Main
+$CXX $CXXFLAGS -I.. selection.cpp -o "$OUT/selection" -pthread
+status=0; "$OUT/selection" > "$OUT/out.txt" 2>&1 || status=$?
+expect "selection" 0 "" "$OUT/out.txt"
+if [ -s "$OUT/out.txt" ]; then cat "$OUT/out.txt"; fi
+status=0; "$OUT/selection" --list --filter 'Parser.*,-Parser.Slow*' > "$OUT/out.txt" 2>&1 || status=$?
+expect "--list --filter" 0 "^2 cases$" "$OUT/out.txt"
+expect "--list --filter" 0 "^Parser.Io \[fast,io\]$" "$OUT/out.txt"
+status=0; "$OUT/selection" --list --tags 'io | (slow' > "$OUT/out.txt" 2>&1 || status=$?
+expect "--tags 'io | (slow'" 2 "^Invalid --tags expression: missing ')' at 11$" "$OUT/out.txt"
+status=0; "$OUT/selection" --tags 'io slow' > "$OUT/out.txt" 2>&1 || status=$?
+expect "--tags 'io slow'" 2 "^Invalid --tags expression: unexpected 's' at 4$" "$OUT/out.txt"
+status=0; "$OUT/selection" --filter 'Lexer.*' --tags 'fast & !io' > "$OUT/out.txt" 2>&1 || status=$?
+expect "--filter --tags" 0 "^Test cases: 1 passed, 0 failed$" "$OUT/out.txt"
+expect "--filter --tags" 0 "Lexer.Fast" "$OUT/out.txt"
+
+# cache - --changed-only, --only-failed and --failed-first over four cases and their inputs;
+# built from a copy of cache.cpp, whose edits change the fingerprint of every case
+cp cache.cpp "$OUT/cache.cpp"
+$CXX $CXXFLAGS -I"$PWD/.." "$OUT/cache.cpp" -o "$OUT/cache" -pthread
+CACHE_DATA=$OUT/cache-data
+export CACHE_DATA
+rm -rf "$CACHE_DATA"
+mkdir -p "$CACHE_DATA"
+echo one > "$CACHE_DATA/input.txt"
+echo pass > "$CACHE_DATA/flaky.txt"
+for i in $(seq 100 123); do echo "$i" > "$CACHE_DATA/an-input-with-a-rather-long-name-$i.txt"; done
+cache --changed-only; ran "first run" 0 "Plain,Input,Flaky,Overflow"
+cache --changed-only; ran "nothing changed" 0 ""
+expect "nothing changed" 0 "^Cache: 4 of 4 cases skipped$" "$OUT/out.txt"
+touch "$CACHE_DATA/input.txt"
+cache --changed-only; ran "input touched" 0 ""
+echo two > "$CACHE_DATA/input.txt"
+cache --changed-only; ran "input edited" 0 "Input"
+cache --changed-only; ran "after the edit" 0 ""
+echo fail > "$CACHE_DATA/flaky.txt"
+cache --changed-only; ran "flaky fails" 1 "Flaky"
+cache --changed-only; ran "a failed case reruns" 1 "Flaky"
+cache --only-failed; ran "--only-failed" 1 "Flaky"
+cache --failed-first --threads 1; ran "--failed-first" 1 "Flaky,Plain,Input,Overflow"
+echo pass > "$CACHE_DATA/flaky.txt"
+cache --changed-only; ran "flaky passes" 0 "Flaky"
+cache --only-failed; ran "--only-failed without failures" 0 ""
+rm "$CACHE_DATA/input.txt"
+cache --changed-only; ran "input removed" 1 "Input"
+echo two > "$CACHE_DATA/input.txt"
+cache --changed-only; ran "input restored" 0 "Input"
+echo "// edited" >> "$OUT/cache.cpp"
+cache --changed-only; ran "source edited" 0 "Plain,Input,Flaky,Overflow"
+cache --changed-only; ran "after the source edit" 0 ""
+
+# --fork: the inputs come back from the child, the overflowing ones rerun every time
+if [ "$(uname -s)" = Linux ]; then
+	rm -f "$CACHE_DATA/cache"
+	cache --changed-only --fork 2; ran "--fork first run" 0 "Plain,Input,Flaky,Overflow"
+	cache --changed-only --fork 2; ran "--fork inputs overflowed" 0 "Overflow"
+	echo three > "$CACHE_DATA/input.txt"
+	cache --changed-only --fork 2; ran "--fork input edited" 0 "Input,Overflow"
+fi
+
+# a corrupt cache is an empty one and is rewritten; an unwritable one is reported
+head -c 100 "$CACHE_DATA/cache" > "$OUT/truncated"
+mv "$OUT/truncated" "$CACHE_DATA/cache"
+cache --changed-only; ran "truncated cache" 0 "Plain,Input,Flaky,Overflow"
+cache --changed-only; ran "rewritten cache" 0 ""
+echo "not a cache" > "$CACHE_DATA/cache"
+cache --changed-only; ran "foreign cache" 0 "Plain,Input,Flaky,Overflow"
+status=0; "$OUT/cache" --cache "$CACHE_DATA/missing/cache" > "$OUT/out.txt" 2>&1 || status=$?
+expect "unwritable cache" 0 "^Cannot write $CACHE_DATA/missing/cache$" "$OUT/out.txt"
+
+rm -rf "$OUT/out.txt" "$CACHE_DATA"
+[ $failed -eq 0 ] && echo "All checks passed"
+exit $failed
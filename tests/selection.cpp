@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+// selection.cpp - --filter globs and --tags expressions over a fixed set of cases
+///////////////////////////////////////////////////////////////////////////////
+// Build and run from this directory (see run.sh):
+//	g++ -std=c++17 -O2 -I.. selection.cpp -o selection -pthread
+//	./selection							// the CaseIndex checks below
+//	./selection --list --tags 'fast'	// any argument goes to Runner::Main
+//
+// Without arguments the program registers 64 more cases, so the bitsets span
+// two words, builds a CaseIndex and checks which cases each --filter and --tags
+// string selects, and the error of each malformed tag expression. It exits with
+// the number of failed assertions.
+///////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.hpp"
+
+#include <string>
+#include <vector>
+
+TEST_CASE_TAGS(Parser, Fast, "fast")
+{
+}
+TEST_CASE_TAGS(Parser, Slow, "slow")
+{
+}
+TEST_CASE_TAGS(Parser, SlowIo, "slow, io")
+{
+}
+TEST_CASE_TAGS(Parser, Io, "fast,io")
+{
+}
+TEST_CASE_TAGS(Lexer, Fast, "fast")
+{
+}
+TEST_CASE(Lexer, Untagged)
+{
+}
+
+static void Nothing()
+{
+}
+
+// the selected "suite.name"s in registration order, comma separated
+static std::string Names(const UnitTest::CaseIndex::Bits& bits)
+{
+	std::vector<size_t> selection;
+	UnitTest::CaseIndex::Selection(bits, selection);
+	std::string names;
+	for(size_t i = 0; i < selection.size(); ++i)
+	{
+		const UnitTest::TestCase& test = UnitTest::Registry::Cases()[selection[i]];
+		names.append(names.empty() ? "" : ",").append(test.suite).append(".").append(test.name);
+	}
+	return names;
+}
+
+static std::string Tags(const UnitTest::CaseIndex& index, const char* expression)
+{
+	UnitTest::CaseIndex::Bits bits;
+	std::string error;
+	return index.Tags(expression, bits, error) ? Names(bits) : "error: " + error;
+}
+
+int main(int argc, char* argv[])
+{
+	if(argc > 1)
+	{
+		return UnitTest::Runner::Main(argc, argv);
+	}
+	static std::vector<std::string> bulk;
+	for(int i = 0; i < 64; ++i)
+	{
+		bulk.push_back("Case" + std::to_string(100 + i));
+	}
+	for(size_t i = 0; i < bulk.size(); ++i)
+	{
+		UnitTest::Registrar("Bulk", bulk[i].c_str(), &Nothing, __FILE__, __LINE__, false, "bulk");
+	}
+	UnitTest::Statistics::SetQuiet(true);
+	const UnitTest::CaseIndex index;
+	const std::string named = "Parser.Fast,Parser.Slow,Parser.SlowIo,Parser.Io,Lexer.Fast,Lexer.Untagged";
+
+	// globs
+	TEST_EQUAL(Names(index.Filter("Parser.*")), "Parser.Fast,Parser.Slow,Parser.SlowIo,Parser.Io", "prefix");
+	TEST_EQUAL(Names(index.Filter("Parser.Slow")), "Parser.Slow", "an exact name is not a prefix");
+	TEST_EQUAL(Names(index.Filter("*.?ast")), "Parser.Fast,Lexer.Fast", "no literal prefix");
+	TEST_EQUAL(Names(index.Filter("*Io")), "Parser.SlowIo,Parser.Io", "'*' backtracks");
+	TEST_EQUAL(Names(index.Filter("Lexer.Untagged,Parser.Io")), "Parser.Io,Lexer.Untagged", "registration order");
+	TEST_EQUAL(Names(index.Filter("Nothing.*")), "", "no match");
+	TEST_EQUAL(Names(index.Filter("Bulk.Case1??")).size(), 64u * 13 - 1, "every bulk case");
+
+	// exclusions
+	TEST_EQUAL(Names(index.Filter("Parser.*,-Parser.Slow*")), "Parser.Fast,Parser.Io", "exclusion after a glob");
+	TEST_EQUAL(Names(index.Filter("-Parser.Slow*,Parser.*")), "Parser.Fast,Parser.Io", "exclusion before a glob");
+	TEST_EQUAL(Names(index.Filter("-Bulk.*,-Parser.*")), "Lexer.Fast,Lexer.Untagged", "only exclusions");
+	TEST_EQUAL(Names(index.Filter("-Bulk.*,,")), named, "empty patterns");
+
+	// tags: '&' binds tighter than '|', '!' tighter than both
+	TEST_EQUAL(Tags(index, "fast"), "Parser.Fast,Parser.Io,Lexer.Fast", "one tag");
+	TEST_EQUAL(Tags(index, "fast & !io"), "Parser.Fast,Lexer.Fast", "negation");
+	TEST_EQUAL(Tags(index, "!!io"), "Parser.SlowIo,Parser.Io", "double negation");
+	TEST_EQUAL(Tags(index, "fast | slow & io"), "Parser.Fast,Parser.SlowIo,Parser.Io,Lexer.Fast", "precedence");
+	TEST_EQUAL(Tags(index, "(fast | slow) & io"), "Parser.SlowIo,Parser.Io", "parentheses");
+	TEST_EQUAL(Tags(index, "!(fast|slow)&!bulk"), "Lexer.Untagged", "negated group");
+	TEST_EQUAL(Tags(index, "!bulk"), named, "negation is trimmed to the registered cases");
+	TEST_EQUAL(Tags(index, "unknown"), "", "unknown tag");
+	TEST_EQUAL(Tags(index, "!unknown & !bulk"), named, "negated unknown tag");
+
+	// syntax errors - the position is 1-based
+	TEST_EQUAL(Tags(index, "io | (slow"), "error: missing ')' at 11", "unclosed group");
+	TEST_EQUAL(Tags(index, "io slow"), "error: unexpected 's' at 4", "two tags");
+	TEST_EQUAL(Tags(index, "io)"), "error: unexpected ')' at 3", "unopened group");
+	TEST_EQUAL(Tags(index, "io &"), "error: expected a tag at 5", "missing operand");
+	TEST_EQUAL(Tags(index, ""), "error: expected a tag at 1", "empty expression");
+	TEST_EQUAL(Tags(index, "| io"), "error: expected a tag at 1", "leading operator");
+
+	UnitTest::Reporter::Flush();
+	return static_cast<int>(UnitTest::Statistics::Failed());
+}